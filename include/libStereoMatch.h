@@ -12,13 +12,20 @@
 #ifndef __LIB_STEREO_MATCH_H_
 #define __LIB_STEREO_MATCH_H_
 
+#include <common/cpuFeatures.h>
+#include <common/costVolume.h>
+
 #include <costCompute/costCompute.h>
 #include <costCompute/adCost.h>
 #include <costCompute/censusCost.h>
 #include <costCompute/adCensusCost.h>
+#include <costCompute/miCost.h>
 
 #include <costAggregation/costAggregation.h>
+#include <costAggregation/penaltyModel.h>
 #include <costAggregation/multipathAggregation.h>
+#include <costAggregation/memoryEfficientAggregation.h>
+#include <costAggregation/mgmAggregation.h>
 
 #include <dispCompute/dispCompute.h>
 
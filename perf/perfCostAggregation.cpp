@@ -79,4 +79,260 @@ BENCHMARK_DEFINE_F(Cones, perfWinnerTakesAll)(benchmark::State& state) {
 
 BENCHMARK_REGISTER_F(Cones, perfWinnerTakesAll)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
 
+BENCHMARK_DEFINE_F(Cones, perfMultipathAggregationRagged)(benchmark::State& state) {
+    transformToGray();
+
+    const int maxDisp = static_cast<int>(state.range(0));
+
+    // every row searches half of the disparities, sliding from the far half
+    // at the top to the near half at the bottom
+    Mat searchRange(left.rows, 1, CV_32SC2);
+    for (int i = 0; i < left.rows; ++i) {
+        searchRange.ptr<int>(i)[0] = maxDisp / 2 * i / left.rows;
+        searchRange.ptr<int>(i)[1] = maxDisp / 2 * i / left.rows + maxDisp / 2;
+    }
+
+    Mat bands;
+    searchRangeBands(searchRange, left.rows, left.cols, 0, maxDisp, bands);
+
+    CostVolume cost(CostLayout::Ragged);
+    cost.create(bands, maxDisp, CV_16U);
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = maxDisp;
+        params.costType = CV_16U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    CostVolume aggregatedCost(CostLayout::Ragged);
+    auto multipathAggregator =
+        MultipathAggregation::create(MultipathAggregation::Params());
+
+    for (auto _ : state) {
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMultipathAggregationRagged)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
+
+BENCHMARK_DEFINE_F(Cones, perfMultipathAggregationValidBand)(benchmark::State& state) {
+    transformToGray();
+
+    // an unallocated ragged volume only stores the valid trapezoid
+    CostVolume cost(CostLayout::Ragged);
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = static_cast<int>(state.range(0));
+        params.costType = CV_16U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    CostVolume aggregatedCost(CostLayout::Ragged);
+    auto multipathAggregator =
+        MultipathAggregation::create(MultipathAggregation::Params());
+
+    for (auto _ : state) {
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMultipathAggregationValidBand)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
+
+BENCHMARK_DEFINE_F(Cones, perfMultipathAggregationSimd)(benchmark::State& state) {
+    transformToGray();
+
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 128;
+        params.costType = CV_8U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    // the 16-bit path costs with the kernel of each instruction set level
+    setMaxSimdLevel(static_cast<SimdLevel>(state.range(0)));
+    if (currentSimdLevel() != static_cast<SimdLevel>(state.range(0))) {
+        state.SkipWithError("instruction set level not supported");
+    }
+
+    Mat aggregatedCost;
+    auto multipathAggregator =
+        MultipathAggregation::create(MultipathAggregation::Params());
+
+    for (auto _ : state) {
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+    }
+
+    setMaxSimdLevel(SimdLevel::AVX512);
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMultipathAggregationSimd)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(0, 3, 1);
+
+BENCHMARK_DEFINE_F(Cones, perfMultipathAggregationPath)(benchmark::State& state) {
+    transformToGray();
+
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 128;
+        params.costType = CV_8U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    // one path type at a time: horizontal, vertical, 45, -45 and the knight
+    // moves(the 22.5 and 67.5 degree lines, four times the paths of the others)
+    auto params = MultipathAggregation::Params();
+    params.enableHonrizon = state.range(0) == 0;
+    params.enableVertiacl = state.range(0) == 1;
+    params.enablePostive45 = state.range(0) == 2;
+    params.enableNegtive45 = state.range(0) == 3;
+    params.enableKnightMove = state.range(0) == 4;
+
+    Mat aggregatedCost;
+    auto multipathAggregator = MultipathAggregation::create(params);
+
+    for (auto _ : state) {
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMultipathAggregationPath)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(0, 4, 1);
+
+BENCHMARK_DEFINE_F(Cones, perfMultipathAggregationPathCount)(benchmark::State& state) {
+    transformToGray();
+
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 128;
+        params.costType = CV_8U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    // 4 paths on the axes, 8 with the diagonals and 16 with the knight moves
+    auto params = MultipathAggregation::Params();
+    params.enablePostive45 = state.range(0) >= 8;
+    params.enableNegtive45 = state.range(0) >= 8;
+    params.enableKnightMove = state.range(0) >= 16;
+
+    Mat aggregatedCost;
+    auto multipathAggregator = MultipathAggregation::create(params);
+
+    for (auto _ : state) {
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMultipathAggregationPathCount)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->Arg(4)->Arg(8)->Arg(16);
+
+BENCHMARK_DEFINE_F(Cones, perfMemoryEfficientAggregation)(benchmark::State& state) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = static_cast<int>(state.range(0));
+    costParams.costType = CV_8U;
+    auto censusComputer = CensusCost::create(costParams);
+
+    auto dispParams = DispComputeParams();
+    dispParams.minDisp = costParams.minDisp;
+    dispParams.maxDisp = costParams.maxDisp;
+
+    // the costs are computed strip by strip within the aggregation
+    auto params = MemoryEfficientAggregation::Params();
+    auto aggregator = MemoryEfficientAggregation::create(params);
+
+    Mat disp;
+    for (auto _ : state) {
+        aggregator->aggregation(left, right, *censusComputer, disp,
+                                dispParams);
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMemoryEfficientAggregation)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(64, 256, 64);
+
+BENCHMARK_DEFINE_F(Cones, perfMGMAggregation)(benchmark::State& state) {
+    transformToGray();
+
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = static_cast<int>(state.range(0));
+        params.costType = CV_8U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    Mat aggregatedCost;
+    auto mgmAggregator = MGMAggregation::create(MGMAggregation::Params());
+
+    for (auto _ : state) {
+        mgmAggregator->aggregation(left, cost, aggregatedCost);
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMGMAggregation)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(64, 256, 64);
+
+BENCHMARK_DEFINE_F(Cones, perfMultipathAggregationFusedWTA)(benchmark::State& state) {
+    transformToGray();
+
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 128;
+        params.costType = CV_8U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    auto dispParams = DispComputeParams();
+    dispParams.minDisp = 0;
+    dispParams.maxDisp = 128;
+
+    // 0: the aggregated cost is stored and scanned, 1: the last direction
+    // picks the disparities
+    auto aggregator = std::static_pointer_cast<MultipathAggregation>(
+        MultipathAggregation::create(MultipathAggregation::Params()));
+    Mat aggregatedCost, disp;
+
+    for (auto _ : state) {
+        if (state.range(0)) {
+            aggregator->aggregation(left, cost, disp, dispParams);
+        } else {
+            aggregator->aggregation(left, cost, aggregatedCost);
+            winnerTakesAll(aggregatedCost, disp, dispParams);
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMultipathAggregationFusedWTA)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->Arg(0)->Arg(1);
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -57,6 +57,20 @@ BENCHMARK_DEFINE_F(Cones, perfADCostGray)(benchmark::State &state) {
     }
 };
 
+BENCHMARK_DEFINE_F(Cones, perfADCostWindowSize)(benchmark::State &state) {
+    auto params = ADCost::Params();
+    params.windowWidth = state.range(0);
+    params.windowHeight = state.range(0);
+    params.minDisp = 0;
+    params.maxDisp = 128;
+    auto adCostComputer = ADCost::create(params);
+    Mat out;
+    transformToGray();
+    for (auto _ : state) {
+        adCostComputer->compute(left, right, out);
+    }
+};
+
 BENCHMARK_DEFINE_F(Cones, perfCensusCost)(benchmark::State& state) {
     auto params = CensusCost::Params();
     params.windowWidth = 9;
@@ -71,6 +85,39 @@ BENCHMARK_DEFINE_F(Cones, perfCensusCost)(benchmark::State& state) {
     }
 }
 
+BENCHMARK_DEFINE_F(Cones, perfCensusCostPattern)(benchmark::State& state) {
+    auto params = CensusCost::Params();
+    params.windowWidth = 15;
+    params.windowHeight = 15;
+    params.minDisp = 0;
+    params.maxDisp = 128;
+    params.costType = CV_8U;
+    params.pattern = static_cast<CensusPattern>(state.range(0));
+    auto censusCostComputer = CensusCost::create(params);
+    Mat out;
+    transformToGray();
+    for (auto _ : state) {
+        censusCostComputer->compute(left, right, out);
+    }
+}
+
+BENCHMARK_DEFINE_F(Cones, perfCensusCostWindow)(benchmark::State& state) {
+    // the dense windows with specialized kernels
+    const int windows[][2] = {{5, 5}, {7, 7}, {9, 7}, {11, 11}};
+    auto params = CensusCost::Params();
+    params.windowWidth = windows[state.range(0)][0];
+    params.windowHeight = windows[state.range(0)][1];
+    params.minDisp = 0;
+    params.maxDisp = 128;
+    params.costType = CV_8U;
+    auto censusCostComputer = CensusCost::create(params);
+    Mat out;
+    transformToGray();
+    for (auto _ : state) {
+        censusCostComputer->compute(left, right, out);
+    }
+}
+
 BENCHMARK_DEFINE_F(Cones, perfADCensusCost)(benchmark::State& state) {
     auto params = ADCensusCost::Params();
     params.windowWidth = 9;
@@ -87,9 +134,25 @@ BENCHMARK_DEFINE_F(Cones, perfADCensusCost)(benchmark::State& state) {
     }
 }
 
+BENCHMARK_DEFINE_F(Cones, perfMICost)(benchmark::State& state) {
+    auto params = MICost::Params();
+    params.minDisp = 0;
+    params.maxDisp = state.range(0);
+    auto miCostComputer = MICost::create(params);
+    Mat out;
+    transformToGray();
+    for (auto _ : state) {
+        miCostComputer->compute(left, right, out);
+    }
+}
+
 BENCHMARK_REGISTER_F(Cones, perfADCostColor)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
 BENCHMARK_REGISTER_F(Cones, perfADCostGray)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
+BENCHMARK_REGISTER_F(Cones, perfADCostWindowSize)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(5, 25, 4);
 BENCHMARK_REGISTER_F(Cones, perfCensusCost)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
+BENCHMARK_REGISTER_F(Cones, perfCensusCostPattern)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(0, 2, 1);
+BENCHMARK_REGISTER_F(Cones, perfCensusCostWindow)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(0, 3, 1);
 BENCHMARK_REGISTER_F(Cones, perfADCensusCost)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
+BENCHMARK_REGISTER_F(Cones, perfMICost)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
 
 BENCHMARK_MAIN();
\ No newline at end of file
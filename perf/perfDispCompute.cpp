@@ -66,4 +66,39 @@ BENCHMARK_DEFINE_F(Cones, perfWinnerTakesAll)(benchmark::State& state) {
 
 BENCHMARK_REGISTER_F(Cones, perfWinnerTakesAll)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
 
+BENCHMARK_DEFINE_F(Cones, perfWinnerTakesAllLRCheck)(benchmark::State& state) {
+    transformToGray();
+
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 128;
+        params.costType = CV_16U;
+
+        CensusCost::create(params)->compute(left, right, cost);
+    }
+
+    // 0: no left-right check, 1: left-right check, 2: left-right check and
+    // right disparity map
+    auto params = DispComputeParams();
+    params.enableLRCheck = state.range(0) > 0;
+    params.enableUniqueCheck = false;
+    params.minDisp = 0;
+    params.maxDisp = 128;
+
+    Mat disp, rightDisp;
+    for (auto _ : state) {
+        if (state.range(0) == 2) {
+            winnerTakesAll(cost, disp, rightDisp, params);
+        } else {
+            winnerTakesAll(cost, disp, params);
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfWinnerTakesAllLRCheck)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->DenseRange(0, 2, 1);
+
 BENCHMARK_MAIN();
\ No newline at end of file
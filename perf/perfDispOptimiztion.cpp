@@ -93,4 +93,73 @@ BENCHMARK_DEFINE_F(Cones, perfDispOptimiztion)(benchmark::State& state) {
 
 BENCHMARK_REGISTER_F(Cones, perfDispOptimiztion)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kSecond)->DenseRange(32, 256, 32);
 
+BENCHMARK_DEFINE_F(Cones, perfRemoveSmallArea)(benchmark::State& state) {
+    transformToGray();
+
+    // the raw costs give a noisy disparity map of many small areas
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 64;
+
+        auto censusComputer = CensusCost::create(params);
+        censusComputer->compute(left, right, cost);
+    }
+
+    Mat disp;
+    {
+        auto params = DispComputeParams();
+        params.minDisp = 0;
+        params.maxDisp = 64;
+
+        winnerTakesAll(cost, disp, params);
+    }
+
+    Mat optimizedDisp;
+    {
+        auto params = DispOptParams();
+        params.enableRemoveSmallArea = true;
+        params.enableDispFill = false;
+        params.enableMedianFilter = false;
+        params.enableBilateralFilter = false;
+        params.dispDomainThreshold = 1;
+        params.smallAreaThreshold = state.range(0);
+
+        for (auto _ : state) {
+            dispOptimiz(disp, optimizedDisp, params);
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfRemoveSmallArea)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->Arg(20)->Arg(200);
+
+BENCHMARK_DEFINE_F(Cones, perfMedianFilter)(benchmark::State& state) {
+    // a megapixel disparity map of sub-pixel disparities
+    RNG rng(5);
+    Mat disp(1000, 1000, CV_32FC1);
+    for (int i = 0; i < disp.rows; ++i) {
+        for (int j = 0; j < disp.cols; ++j) {
+            disp.ptr<float>(i)[j] = rng.uniform(0.f, 64.f);
+        }
+    }
+
+    Mat filteredDisp;
+    {
+        auto params = DispOptParams();
+        params.enableRemoveSmallArea = false;
+        params.enableDispFill = false;
+        params.enableMedianFilter = true;
+        params.k = state.range(0);
+
+        for (auto _ : state) {
+            dispOptimiz(disp, filteredDisp, params);
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(Cones, perfMedianFilter)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond)->Arg(3)->Arg(5)->Arg(9);
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,51 @@
+/**
+ * @file costTraits.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __COST_TRAITS_H_
+#define __COST_TRAITS_H_
+
+#include <cfloat>
+#include <cstdint>
+#include <limits>
+
+namespace libSM {
+/**
+ * @brief properties of the element types a cost volume can be stored in
+ *
+ * @tparam T element type(uint8_t, uint16_t or float)
+ */
+template <typename T> struct CostTraits;
+
+template <> struct CostTraits<uint8_t> {
+    typedef int Work; // type used for arithmetic on the costs
+    static uint8_t invalid() { return std::numeric_limits<uint8_t>::max(); }
+    static uint8_t saturate(const int val) {
+        return static_cast<uint8_t>(val < 0 ? 0 : (val > 255 ? 255 : val));
+    }
+};
+
+template <> struct CostTraits<uint16_t> {
+    typedef int Work;
+    static uint16_t invalid() { return std::numeric_limits<uint16_t>::max(); }
+    static uint16_t saturate(const int val) {
+        return static_cast<uint16_t>(val < 0 ? 0
+                                             : (val > 65535 ? 65535 : val));
+    }
+};
+
+template <> struct CostTraits<float> {
+    typedef float Work;
+    static float invalid() { return FLT_MAX; }
+    static float saturate(const float val) { return val; }
+};
+} // namespace libSM
+
+#endif //!__COST_TRAITS_H_
@@ -0,0 +1,353 @@
+#include "costVolume.h"
+#include "costTraits.h"
+#include "dispRange.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+
+namespace libSM {
+/**
+ * @brief set all the cells of a volume to a value
+ *
+ * @tparam T element type
+ * @param volume volume
+ * @param val value
+ */
+template <typename T> static void fillCells(CostVolume &volume, const T val) {
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < volume.rows(); ++i) {
+        if (volume.layout() == CostLayout::Ragged) {
+            for (int j = 0; j < volume.cols(); ++j) {
+                T *ptrCost = volume.ptr<T>(i, j);
+                std::fill(ptrCost + volume.dispBegin(i, j),
+                          ptrCost + volume.dispEnd(i, j), val);
+            }
+        } else if (volume.layout() == CostLayout::PixelMajor) {
+            for (int j = 0; j < volume.cols(); ++j) {
+                T *ptrCost = volume.ptr<T>(i, j);
+                std::fill(ptrCost, ptrCost + volume.dispRange(), val);
+            }
+        } else {
+            for (int d = 0; d < volume.dispRange(); ++d) {
+                T *ptrCost = volume.ptr<T>(i) + d * volume.dispStep();
+                std::fill(ptrCost, ptrCost + volume.cols(), val);
+            }
+        }
+    }
+}
+
+/**
+ * @brief copy the cells of a ragged volume from or to another volume of the
+ * same rows, columns and disparities, the cells of the destination missing in
+ * the source are invalid
+ *
+ * @tparam T element type
+ * @param src source volume
+ * @param dst destination volume
+ */
+template <typename T>
+static void copyRaggedCells(const CostVolume &src, CostVolume &dst) {
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < src.rows(); ++i) {
+        for (int j = 0; j < src.cols(); ++j) {
+            const int srcBegin = src.dispBegin(i, j);
+            const int srcEnd = src.dispEnd(i, j);
+            for (int d = dst.dispBegin(i, j); d < dst.dispEnd(i, j); ++d) {
+                dst.at<T>(i, j, d) = d >= srcBegin && d < srcEnd
+                                         ? src.at<T>(i, j, d)
+                                         : CostTraits<T>::invalid();
+            }
+        }
+    }
+}
+
+/**
+ * @brief copy the cells of a volume to another one of the same geometry
+ *
+ * @tparam T element type
+ * @param src source volume
+ * @param dst destination volume
+ */
+template <typename T>
+static void copyCells(const CostVolume &src, CostVolume &dst) {
+    const int dispRange = src.dispRange();
+
+    if (src.layout() == CostLayout::Ragged ||
+        dst.layout() == CostLayout::Ragged) {
+        copyRaggedCells<T>(src, dst);
+        return;
+    }
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < src.rows(); ++i) {
+        if (src.layout() == CostLayout::PixelMajor &&
+            dst.layout() == CostLayout::PixelMajor) {
+            for (int j = 0; j < src.cols(); ++j) {
+                const T *ptrSrc = src.ptr<T>(i, j);
+                std::copy(ptrSrc, ptrSrc + dispRange, dst.ptr<T>(i, j));
+            }
+        } else if (src.layout() == CostLayout::DispMajor &&
+                   dst.layout() == CostLayout::DispMajor) {
+            for (int d = 0; d < dispRange; ++d) {
+                const T *ptrSrc = src.ptr<T>(i) + d * src.dispStep();
+                std::copy(ptrSrc, ptrSrc + src.cols(),
+                          dst.ptr<T>(i) + d * dst.dispStep());
+            }
+        } else if (dst.layout() == CostLayout::DispMajor) {
+            // pixel-major to disparity-major, the writes are contiguous
+            for (int d = 0; d < dispRange; ++d) {
+                T *ptrDst = dst.ptr<T>(i) + d * dst.dispStep();
+                const T *ptrSrc = src.ptr<T>(i) + d;
+                for (int j = 0; j < src.cols(); ++j) {
+                    ptrDst[j] = ptrSrc[j * src.pixelStep()];
+                }
+            }
+        } else {
+            for (int j = 0; j < src.cols(); ++j) {
+                T *ptrDst = dst.ptr<T>(i, j);
+                const T *ptrSrc = src.ptr<T>(i) + j;
+                for (int d = 0; d < dispRange; ++d) {
+                    ptrDst[d] = ptrSrc[d * src.dispStep()];
+                }
+            }
+        }
+    }
+}
+
+CostVolume::CostVolume(const CostLayout layout)
+    : data_(nullptr), rows_(0), cols_(0), dispRange_(0), depth_(CV_32F),
+      layout_(layout), rowStep_(0), pixelStep_(0), dispStep_(0) {}
+
+CostVolume::CostVolume(const int rows, const int cols, const int dispRange,
+                       const int depth, const CostLayout layout)
+    : CostVolume(layout) {
+    create(rows, cols, dispRange, depth);
+}
+
+CostVolume::CostVolume(const Mat &mat) : CostVolume(CostLayout::PixelMajor) {
+    if (mat.empty()) {
+        return;
+    }
+
+    CV_Assert_N(mat.dims == 2, mat.depth() == CV_8U || mat.depth() == CV_16U ||
+                                   mat.depth() == CV_32F);
+
+    holder_ = std::make_shared<Mat>(mat);
+    data_ = const_cast<unsigned char *>(mat.ptr<unsigned char>(0));
+    rows_ = mat.rows;
+    cols_ = mat.cols;
+    dispRange_ = mat.channels();
+    depth_ = mat.depth();
+    rowStep_ = static_cast<ptrdiff_t>(mat.step1());
+    pixelStep_ = dispRange_;
+    dispStep_ = 1;
+}
+
+void CostVolume::create(const int rows, const int cols, const int dispRange,
+                        const int depth) {
+    CV_Assert_N(rows > 0, cols > 0, dispRange > 0,
+                depth == CV_8U || depth == CV_16U || depth == CV_32F);
+
+    const bool sameShape =
+        rows == rows_ && cols == cols_ && dispRange == dispRange_;
+    if (!empty() && sameShape && depth == depth_) {
+        return;
+    }
+
+    if (layout_ == CostLayout::Ragged) {
+        // the bands of the volume are kept, otherwise all the disparities
+        if (!(bands_ && sameShape)) {
+            create(Mat(rows, cols, CV_32SC2, Scalar(0, dispRange)), dispRange,
+                   depth);
+            return;
+        }
+    }
+
+    allocate(rows, cols, dispRange, depth);
+}
+
+void CostVolume::create(const Mat &bands, const int dispRange,
+                        const int depth) {
+    CV_Assert_N(layout_ == CostLayout::Ragged, !bands.empty(),
+                bands.type() == CV_32SC2, dispRange > 0,
+                depth == CV_8U || depth == CV_16U || depth == CV_32F);
+
+    // a margin of dispRange elements keeps the offsets of the cells d = 0
+    // inside the data
+    auto pixelBands =
+        std::make_shared<std::vector<PixelBand>>(bands.total());
+    ptrdiff_t offset = dispRange;
+    for (int i = 0; i < bands.rows; ++i) {
+        const int *ptrBands = bands.ptr<int>(i);
+        for (int j = 0; j < bands.cols; ++j) {
+            PixelBand &band = (*pixelBands)[i * bands.cols + j];
+            band.begin = std::min(std::max(ptrBands[2 * j], 0), dispRange);
+            band.end =
+                std::min(std::max(ptrBands[2 * j + 1], band.begin), dispRange);
+            band.offset = offset - band.begin;
+            offset += band.end - band.begin;
+        }
+    }
+
+    bands_ = pixelBands;
+    allocate(bands.rows, bands.cols, dispRange, depth);
+}
+
+void CostVolume::create(const CostVolume &geometry, const int depth) {
+    if (layout_ != CostLayout::Ragged || !geometry.bands_) {
+        create(geometry.rows(), geometry.cols(), geometry.dispRange(), depth);
+        return;
+    }
+
+    if (!empty() && bands_ == geometry.bands_ && depth == depth_) {
+        return;
+    }
+
+    CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
+    bands_ = geometry.bands_;
+    allocate(geometry.rows(), geometry.cols(), geometry.dispRange(), depth);
+}
+
+void CostVolume::allocate(const int rows, const int cols, const int dispRange,
+                          const int depth) {
+    const int elemSize = static_cast<int>(CV_ELEM_SIZE1(depth));
+    const int alignElems = COST_VOLUME_ALIGN / elemSize;
+    size_t elems;
+    if (layout_ == CostLayout::PixelMajor) {
+        pixelStep_ = static_cast<ptrdiff_t>(alignSize(dispRange, alignElems));
+        rowStep_ = pixelStep_ * cols;
+        dispStep_ = 1;
+        elems = static_cast<size_t>(rowStep_) * rows;
+    } else if (layout_ == CostLayout::DispMajor) {
+        pixelStep_ = 1;
+        rowStep_ = static_cast<ptrdiff_t>(alignSize(cols, alignElems));
+        dispStep_ = rowStep_ * rows;
+        elems = static_cast<size_t>(dispStep_) * dispRange;
+    } else {
+        const PixelBand &last = bands_->back();
+        pixelStep_ = 0;
+        rowStep_ = 0;
+        dispStep_ = 1;
+        elems = static_cast<size_t>(last.offset + last.end);
+    }
+
+    std::shared_ptr<unsigned char> buffer(
+        new unsigned char[elems * elemSize + COST_VOLUME_ALIGN],
+        std::default_delete<unsigned char[]>());
+    data_ = alignPtr(buffer.get(), COST_VOLUME_ALIGN);
+    holder_ = buffer;
+    rows_ = rows;
+    cols_ = cols;
+    dispRange_ = dispRange;
+    depth_ = depth;
+}
+
+void CostVolume::release() {
+    holder_.reset();
+    bands_.reset();
+    data_ = nullptr;
+    rows_ = cols_ = dispRange_ = 0;
+    rowStep_ = pixelStep_ = dispStep_ = 0;
+}
+
+void CostVolume::setTo(const double val) {
+    if (depth_ == CV_8U) {
+        fillCells<uint8_t>(*this, saturate_cast<uint8_t>(val));
+    } else if (depth_ == CV_16U) {
+        fillCells<uint16_t>(*this, saturate_cast<uint16_t>(val));
+    } else {
+        fillCells<float>(*this, saturate_cast<float>(val));
+    }
+}
+
+void CostVolume::copyTo(CostVolume &dst) const {
+    if (empty()) {
+        dst.release();
+        return;
+    }
+
+    if (dst.data_ == data_) {
+        return;
+    }
+
+    dst.create(*this, depth_);
+
+    if (depth_ == CV_8U) {
+        copyCells<uint8_t>(*this, dst);
+    } else if (depth_ == CV_16U) {
+        copyCells<uint16_t>(*this, dst);
+    } else {
+        copyCells<float>(*this, dst);
+    }
+}
+
+void CostVolume::copyTo(Mat &dst) const {
+    if (empty()) {
+        dst.release();
+        return;
+    }
+
+    dst.create(rows_, cols_, CV_MAKETYPE(depth_, dispRange_));
+    CostVolume view(dst);
+    copyTo(view);
+}
+
+void searchRangeBands(const Mat &searchRange, const int rows, const int cols,
+                      const int minDisp, const int dispRange, Mat &bands) {
+    CV_Assert_N(!searchRange.empty(), searchRange.type() == CV_32SC2,
+                searchRange.rows <= rows, searchRange.cols <= cols);
+
+    bands.create(rows, cols, CV_32SC2);
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < rows; ++i) {
+        const int *ptrRange =
+            searchRange.ptr<int>(i * searchRange.rows / rows);
+        int *ptrBands = bands.ptr<int>(i);
+        for (int j = 0; j < cols; ++j) {
+            const int tile = j * searchRange.cols / cols;
+            const int begin = std::min(
+                std::max(ptrRange[2 * tile] - minDisp, 0), dispRange);
+            ptrBands[2 * j] = begin;
+            ptrBands[2 * j + 1] = std::min(
+                std::max(ptrRange[2 * tile + 1] - minDisp, begin), dispRange);
+        }
+    }
+}
+
+void validBands(const int rows, const int cols, const int halfWidth,
+                const int halfHeight, const int minDisp, const int dispRange,
+                Mat &bands) {
+    CV_Assert_N(rows > 0, cols > 0, dispRange > 0);
+
+    const bool narrow = !bands.empty();
+    if (narrow) {
+        CV_Assert_N(bands.type() == CV_32SC2, bands.rows == rows,
+                    bands.cols == cols);
+    } else {
+        bands.create(rows, cols, CV_32SC2);
+    }
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < rows; ++i) {
+        int *ptrBands = bands.ptr<int>(i);
+        const bool borderRow = i < halfHeight || i > rows - halfHeight - 1;
+        for (int j = 0; j < cols; ++j) {
+            int begin = 0, end = 0;
+            if (!borderRow && j >= halfWidth && j <= cols - halfWidth - 1) {
+                validDispRange(j, cols, halfWidth, minDisp, dispRange, begin,
+                               end);
+            }
+
+            if (narrow) {
+                begin = std::max(begin, ptrBands[2 * j]);
+                end = std::max(std::min(end, ptrBands[2 * j + 1]), begin);
+            }
+
+            ptrBands[2 * j] = begin;
+            ptrBands[2 * j + 1] = end;
+        }
+    }
+}
+} // namespace libSM
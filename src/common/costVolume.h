@@ -0,0 +1,271 @@
+/**
+ * @file costVolume.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-17
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __COST_VOLUME_H_
+#define __COST_VOLUME_H_
+
+#include <typeDef.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace cv {
+class Mat;
+}
+
+/**
+ * @brief alignment(in bytes) of the rows and the pixels of a cost volume
+ *
+ */
+#define COST_VOLUME_ALIGN 64
+
+namespace libSM {
+/**
+ * @brief memory layout of a cost volume
+ *
+ */
+enum class CostLayout {
+    PixelMajor, // the disparities of a pixel are adjacent, every pixel is
+                // padded to COST_VOLUME_ALIGN bytes
+    DispMajor,  // every disparity is a slice of rows, the pixels of a row are
+                // adjacent and every row is padded to COST_VOLUME_ALIGN bytes
+    Ragged      // only the band of disparities [dispBegin, dispEnd) of a pixel
+                // is stored, the bands are packed one after another
+};
+
+/**
+ * @brief three-dimensional cost space of rows x cols x dispRange cells. The
+ * cell (i, j, d) lies at ptr<T>(i, j)[d * dispStep()] whatever the layout,
+ * where d has to lie in [dispBegin(i, j), dispEnd(i, j)). Copies share the
+ * data like cv::Mat.
+ *
+ */
+class LIBSM_API CostVolume {
+  public:
+    /**
+     * @brief construct an empty volume
+     *
+     * @param layout layout of the data created later on
+     */
+    CostVolume(IN const CostLayout layout = CostLayout::PixelMajor);
+    /**
+     * @brief construct and allocate a volume
+     *
+     * @param rows number of rows
+     * @param cols number of columns
+     * @param dispRange number of disparities
+     * @param depth element type(CV_8U, CV_16U or CV_32F)
+     * @param layout memory layout
+     */
+    CostVolume(IN const int rows, IN const int cols, IN const int dispRange,
+               IN const int depth,
+               IN const CostLayout layout = CostLayout::PixelMajor);
+    /**
+     * @brief pixel-major view of a cost space stored in a cv::Mat, the data is
+     * shared and the pixels are not padded
+     *
+     * @param mat cost space(one channel per disparity)
+     */
+    explicit CostVolume(IN const cv::Mat &mat);
+    /**
+     * @brief allocate the volume in its layout, nothing is done if the volume
+     * already has this geometry
+     *
+     * @param rows number of rows
+     * @param cols number of columns
+     * @param dispRange number of disparities
+     * @param depth element type(CV_8U, CV_16U or CV_32F)
+     */
+    void create(IN const int rows, IN const int cols, IN const int dispRange,
+                IN const int depth);
+    /**
+     * @brief allocate a ragged volume that only stores the band of
+     * disparities of every pixel
+     *
+     * @param bands CV_32SC2 map of the disparity indices [begin, end) of every
+     * pixel
+     * @param dispRange number of disparities
+     * @param depth element type(CV_8U, CV_16U or CV_32F)
+     */
+    void create(IN const cv::Mat &bands, IN const int dispRange,
+                IN const int depth);
+    /**
+     * @brief allocate the volume in its layout with the geometry of another
+     * one, a ragged volume takes over the bands of a ragged geometry
+     *
+     * @param geometry volume whose rows, columns, disparities(and bands) are
+     * used
+     * @param depth element type(CV_8U, CV_16U or CV_32F)
+     */
+    void create(IN const CostVolume &geometry, IN const int depth);
+    /**
+     * @brief release the data, the layout is kept
+     *
+     */
+    void release();
+    /**
+     * @brief set all the cells to a value
+     *
+     * @param val value
+     */
+    void setTo(IN const double val);
+    /**
+     * @brief copy the cells to another volume, which keeps its layout. Cells
+     * of the destination that are missing in the source are set to the
+     * invalid cost
+     *
+     * @param dst destination volume
+     */
+    void copyTo(OUT CostVolume &dst) const;
+    /**
+     * @brief copy the cells to a cv::Mat(one channel per disparity)
+     *
+     * @param dst destination cost space
+     */
+    void copyTo(OUT cv::Mat &dst) const;
+
+    bool empty() const { return data_ == nullptr; }
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int dispRange() const { return dispRange_; }
+    int depth() const { return depth_; }
+    CostLayout layout() const { return layout_; }
+    /**
+     * @brief first stored disparity index of pixel (i, j)
+     *
+     */
+    int dispBegin(const int i, const int j) const {
+        return bands_ ? (*bands_)[i * cols_ + j].begin : 0;
+    }
+    /**
+     * @brief one past the last stored disparity index of pixel (i, j)
+     *
+     */
+    int dispEnd(const int i, const int j) const {
+        return bands_ ? (*bands_)[i * cols_ + j].end : dispRange_;
+    }
+    /**
+     * @brief number of elements between adjacent rows, 0 for the ragged
+     * layout
+     *
+     */
+    ptrdiff_t rowStep() const { return rowStep_; }
+    /**
+     * @brief number of elements between adjacent pixels of a row, 0 for the
+     * ragged layout
+     *
+     */
+    ptrdiff_t pixelStep() const { return pixelStep_; }
+    /**
+     * @brief number of elements between adjacent disparities of a pixel
+     *
+     */
+    ptrdiff_t dispStep() const { return dispStep_; }
+
+    /**
+     * @brief pointer to the cell (i, j, 0)
+     *
+     * @tparam T element type
+     * @param i row
+     * @param j column
+     */
+    template <typename T> T *ptr(const int i, const int j = 0) {
+        return reinterpret_cast<T *>(data_) + offset(i, j);
+    }
+    template <typename T> const T *ptr(const int i, const int j = 0) const {
+        return reinterpret_cast<const T *>(data_) + offset(i, j);
+    }
+    /**
+     * @brief the cell (i, j, d)
+     *
+     */
+    template <typename T> T &at(const int i, const int j, const int d) {
+        return ptr<T>(i, j)[d * dispStep_];
+    }
+    template <typename T>
+    const T &at(const int i, const int j, const int d) const {
+        return ptr<T>(i, j)[d * dispStep_];
+    }
+
+  private:
+    /**
+     * @brief stored disparities of a ragged pixel
+     *
+     */
+    struct PixelBand {
+        ptrdiff_t offset; // number of elements from the data to the cell d = 0
+        int begin;        // first stored disparity index
+        int end;          // one past the last stored disparity index
+    };
+    ptrdiff_t offset(const int i, const int j) const {
+        return bands_ ? (*bands_)[i * cols_ + j].offset
+                      : i * rowStep_ + j * pixelStep_;
+    }
+    /**
+     * @brief allocate the data of the geometry in the layout
+     *
+     */
+    void allocate(const int rows, const int cols, const int dispRange,
+                  const int depth);
+    std::shared_ptr<void> holder_; // owner of the data
+    std::shared_ptr<const std::vector<PixelBand>> bands_; // ragged bands
+    unsigned char *data_;
+    int rows_;
+    int cols_;
+    int dispRange_;
+    int depth_;
+    CostLayout layout_;
+    ptrdiff_t rowStep_;
+    ptrdiff_t pixelStep_;
+    ptrdiff_t dispStep_;
+};
+
+/**
+ * @brief per-pixel disparity bands of a per-row or per-tile search range map.
+ * The image is divided evenly into searchRange.rows x searchRange.cols tiles,
+ * e.g. a single column of one range per image row gives per-row ranges.
+ *
+ * @param searchRange CV_32SC2 map of the searched disparities [min, max) of
+ * every tile
+ * @param rows number of image rows
+ * @param cols number of image columns
+ * @param minDisp minimum disparity value of the cost volume
+ * @param dispRange disparity range of the cost volume
+ * @param bands CV_32SC2 map of the disparity indices [begin, end) of every
+ * pixel, which is the input of CostVolume::create for the ragged layout
+ */
+void LIBSM_API searchRangeBands(IN const cv::Mat &searchRange,
+                                IN const int rows, IN const int cols,
+                                IN const int minDisp, IN const int dispRange,
+                                OUT cv::Mat &bands);
+
+/**
+ * @brief per-pixel disparity bands of the cells whose windows lie inside both
+ * images, i.e. a trapezoid per row and empty bands on the border. The bands
+ * of the inner pixels are the ones of validDispRange.
+ *
+ * @param rows number of image rows
+ * @param cols number of image columns
+ * @param halfWidth half width of the window
+ * @param halfHeight half height of the window
+ * @param minDisp minimum disparity value of the cost volume
+ * @param dispRange disparity range of the cost volume
+ * @param bands CV_32SC2 map of the disparity indices [begin, end) of every
+ * pixel, input bands of the same size(e.g. of searchRangeBands) are narrowed
+ * down to the valid cells
+ */
+void LIBSM_API validBands(IN const int rows, IN const int cols,
+                          IN const int halfWidth, IN const int halfHeight,
+                          IN const int minDisp, IN const int dispRange,
+                          IN OUT cv::Mat &bands);
+} // namespace libSM
+
+#endif //!__COST_VOLUME_H_
@@ -0,0 +1,97 @@
+#include "cpuFeatures.h"
+
+#include <atomic>
+
+#if defined(LIBSM_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace libSM {
+
+#if defined(LIBSM_X86) && defined(_MSC_VER)
+/**
+ * @brief detect the supported level by cpuid and xgetbv
+ *
+ * @return SimdLevel supported level
+ */
+static SimdLevel detectByCpuid() {
+    int info[4] = {0};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse42 = (info[2] >> 20) & 1;
+    const bool popcnt = (info[2] >> 23) & 1;
+    const bool osxsave = (info[2] >> 27) & 1;
+    const bool avx = (info[2] >> 28) & 1;
+
+    if (!sse42 || !popcnt) {
+        return SimdLevel::Scalar;
+    }
+
+    if (!osxsave || !avx || maxLeaf < 7) {
+        return SimdLevel::SSE42;
+    }
+
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+    const bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] >> 5) & 1;
+    const bool avx512f = (info[1] >> 16) & 1;
+    const bool avx512bw = (info[1] >> 30) & 1;
+    const bool avx512vl = (info[1] >> 31) & 1;
+
+    if (!ymmEnabled || !avx2) {
+        return SimdLevel::SSE42;
+    }
+
+    if (!zmmEnabled || !avx512f || !avx512bw || !avx512vl) {
+        return SimdLevel::AVX2;
+    }
+
+    return SimdLevel::AVX512;
+}
+#endif
+
+SimdLevel detectSimdLevel() {
+#if defined(LIBSM_X86) && defined(_MSC_VER)
+    static const SimdLevel level = detectByCpuid();
+    return level;
+#elif defined(LIBSM_X86) && (defined(__GNUC__) || defined(__clang__))
+    static const SimdLevel level = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") &&
+            __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vl")) {
+            return SimdLevel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.2") &&
+            __builtin_cpu_supports("popcnt")) {
+            return SimdLevel::SSE42;
+        }
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+static std::atomic<int> maxSimdLevel(static_cast<int>(SimdLevel::AVX512));
+
+SimdLevel currentSimdLevel() {
+    const int detected = static_cast<int>(detectSimdLevel());
+    const int limit = maxSimdLevel.load(std::memory_order_relaxed);
+    return static_cast<SimdLevel>(detected < limit ? detected : limit);
+}
+
+void setMaxSimdLevel(const SimdLevel level) {
+    maxSimdLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+} // namespace libSM
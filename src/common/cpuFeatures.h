@@ -0,0 +1,73 @@
+/**
+ * @file cpuFeatures.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __CPU_FEATURES_H_
+#define __CPU_FEATURES_H_
+
+#include <typeDef.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define LIBSM_X86 1
+#endif
+
+// Functions using the intrinsics of a given instruction set are compiled with
+// the corresponding target attribute, so that the library itself can be built
+// without global ISA flags and the kernel is selected at runtime.
+#if defined(LIBSM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LIBSM_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define LIBSM_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define LIBSM_TARGET_AVX512                                                    \
+    __attribute__((target("avx512f,avx512bw,avx512vl,avx2,popcnt")))
+#else
+#define LIBSM_TARGET_SSE42
+#define LIBSM_TARGET_AVX2
+#define LIBSM_TARGET_AVX512
+#endif
+
+namespace libSM {
+/**
+ * @brief instruction set levels used by the vectorized kernels
+ *
+ */
+enum class SimdLevel {
+    Scalar = 0, // portable C++ implementation
+    SSE42 = 1,  // SSE4.2 + POPCNT
+    AVX2 = 2,   // AVX2
+    AVX512 = 3  // AVX-512F + AVX-512BW + AVX-512VL
+};
+
+/**
+ * @brief detect the highest instruction set level supported by the cpu and
+ * the operating system
+ *
+ * @return SimdLevel supported level
+ */
+SimdLevel LIBSM_API detectSimdLevel();
+
+/**
+ * @brief the instruction set level used by the kernels, i.e. the detected
+ * level limited by setMaxSimdLevel
+ *
+ * @return SimdLevel level in use
+ */
+SimdLevel LIBSM_API currentSimdLevel();
+
+/**
+ * @brief limit the instruction set level used by the kernels, mainly for
+ * testing and benchmarking the different implementations
+ *
+ * @param level maximum level
+ */
+void LIBSM_API setMaxSimdLevel(IN const SimdLevel level);
+} // namespace libSM
+
+#endif //!__CPU_FEATURES_H_
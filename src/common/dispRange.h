@@ -0,0 +1,41 @@
+/**
+ * @file dispRange.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __DISP_RANGE_H_
+#define __DISP_RANGE_H_
+
+#include <algorithm>
+
+namespace libSM {
+/**
+ * @brief the disparities [beginDisp, endDisp) of left pixel x whose matched
+ * right pixel x - minDisp - d keeps the whole window inside the image, i.e.
+ * lies in [halfWidth, cols - halfWidth - 1]
+ *
+ * @param x left image x-coordinate
+ * @param cols number of image columns
+ * @param halfWidth half width of the window
+ * @param minDisp minimum disparity value
+ * @param dispRange disparity range
+ * @param beginDisp first valid disparity index
+ * @param endDisp one past the last valid disparity index
+ */
+inline void validDispRange(const int x, const int cols, const int halfWidth,
+                           const int minDisp, const int dispRange,
+                           int &beginDisp, int &endDisp) {
+    beginDisp = std::min(std::max(x - minDisp - (cols - halfWidth - 1), 0),
+                         dispRange);
+    endDisp =
+        std::max(std::min(x - minDisp - halfWidth + 1, dispRange), beginDisp);
+}
+} // namespace libSM
+
+#endif //!__DISP_RANGE_H_
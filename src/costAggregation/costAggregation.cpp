@@ -0,0 +1,15 @@
+#include "costAggregation.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+
+namespace libSM {
+void CostAggregation::aggregation(const Mat &left, const CostVolume &cost,
+                                  CostVolume &aggregationCost) {
+    Mat costMat, aggregationCostMat;
+    cost.copyTo(costMat);
+    aggregation(left, costMat, aggregationCostMat);
+    CostVolume(aggregationCostMat).copyTo(aggregationCost);
+}
+} // namespace libSM
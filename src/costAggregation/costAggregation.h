@@ -13,6 +13,7 @@
 #define __COST_AGGREGATION_H_
 
 #include <typeDef.h>
+#include <common/costVolume.h>
 
 namespace cv {
 class Mat;
@@ -30,12 +31,23 @@ class LIBSM_API CostAggregation {
      * @brief aggregation cost
      *
      * @param left  left image
-     * @param cost cost space
-     * @param aggregationCost aggregated cost
+     * @param cost cost space(CV_8U, CV_16U or CV_32F)
+     * @param aggregationCost aggregated cost, CV_16U for integer costs and
+     * CV_32F for float costs
      */
     virtual void aggregation(IN const cv::Mat &left,
                              IN const cv::Mat &cost,
                              OUT cv::Mat &aggregationCost) = 0;
+    /**
+     * @brief aggregation cost of a cost volume, the aggregated volume keeps its
+     * layout. The default implementation goes through cv::Mat.
+     *
+     * @param left  left image
+     * @param cost cost volume(CV_8U, CV_16U or CV_32F)
+     * @param aggregationCost aggregated cost volume
+     */
+    virtual void aggregation(IN const cv::Mat &left, IN const CostVolume &cost,
+                             OUT CostVolume &aggregationCost);
 };
 } // namespace libSM
 
@@ -0,0 +1,484 @@
+#include "memoryEfficientAggregation.h"
+#include "common/costTraits.h"
+#include "pathKernel.h"
+#include "pathPenalty.h"
+#include "dispCompute/dispKernel.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace libSM {
+/**
+ * @brief what the forward pass leaves for a pixel: the disparity of the
+ * minimum of the forward sum, the forward sums of the disparities around it
+ * and the minimum of the forward sum at the other disparities
+ *
+ * @tparam AggT aggregated cost type
+ */
+template <typename AggT> struct ForwardState {
+    uint16_t disp;
+    AggT cost[3];
+    AggT otherMin;
+};
+
+/**
+ * @brief costs of an image computed strip by strip, a strip is computed when
+ * one of its rows is asked for. The computer is prepared for the whole pair
+ * while the strips are alive.
+ *
+ */
+class CostStrips {
+  public:
+    CostStrips(const Mat &left, const Mat &right, CostComputer &computer,
+               const int stripRows)
+        : left_(left), right_(right), computer_(computer),
+          stripRows_(max(stripRows, 1)),
+          stripMargin_(max(computer.windowHeight() / 2, 0)) {
+        computer_.prepare(left_, right_);
+    }
+    ~CostStrips() { computer_.prepare(Mat(), Mat()); }
+
+    /**
+     * @brief cost of an image row, dispRange() values per pixel
+     *
+     * @param i image y-coordinate
+     * @return const uchar* cost row, valid until a row of another strip is
+     * asked for
+     */
+    const uchar *row(const int i) {
+        if (i < begin_ || i >= end_) {
+            begin_ = i / stripRows_ * stripRows_;
+            end_ = min(begin_ + stripRows_, left_.rows);
+            // the margins keep the cost windows of the strip rows inside the
+            // strip and the state of the whole pair is prepared, so the strip
+            // costs equal the costs of the whole image
+            offset_ = max(begin_ - stripMargin_, 0);
+            const int bottom = min(end_ + stripMargin_, left_.rows);
+            computer_.compute(left_.rowRange(offset_, bottom),
+                              right_.rowRange(offset_, bottom), strip_);
+        }
+        return strip_.ptr<uchar>(i - offset_);
+    }
+
+    int depth() const { return strip_.depth(); }
+    int dispRange() const { return strip_.channels(); }
+
+  private:
+    const Mat &left_, &right_;
+    CostComputer &computer_;
+    const int stripRows_, stripMargin_;
+    int begin_ = 0, end_ = 0, offset_ = 0;
+    Mat strip_;
+};
+
+class MemoryEfficientAggregationImpl : public MemoryEfficientAggregation {
+  public:
+    MemoryEfficientAggregationImpl(const Params params) : params_(params){};
+    void aggregation(const cv::Mat &left, const cv::Mat &right,
+                     CostComputer &computer, cv::Mat &dispMap,
+                     const DispComputeParams params) override;
+    void aggregation(const cv::Mat &left, const cv::Mat &right,
+                     CostComputer &computer, cv::Mat &dispMap,
+                     cv::Mat &confidenceMap,
+                     const DispComputeParams params) override;
+
+  private:
+    /**
+     * @brief aggregation cost and winner-takes-all, with the left-right check
+     *
+     * @param left rectified left image
+     * @param right rectified right image
+     * @param computer cost computer
+     * @param dispMap disparity map
+     * @param confidenceMap confidence map, nullptr if not wanted
+     * @param params disparity computation control parameters
+     */
+    void aggregationDisp(const cv::Mat &left, const cv::Mat &right,
+                         CostComputer &computer, cv::Mat &dispMap,
+                         cv::Mat *confidenceMap,
+                         const DispComputeParams &params);
+    /**
+     * @brief both passes over an image pair
+     *
+     * @param left base image
+     * @param right match image
+     * @param computer cost computer
+     * @param dispMap disparity map without the left-right check
+     * @param bestDisp disparity index(disparity - minDisp) of every
+     * pixel(CV_32S), -1 where the uniqueness check fails
+     * @param confidenceMap confidence map without the left-right check,
+     * nullptr if not wanted
+     * @param params disparity computation control parameters
+     */
+    void match(const cv::Mat &left, const cv::Mat &right,
+               CostComputer &computer, cv::Mat &dispMap, cv::Mat &bestDisp,
+               cv::Mat *confidenceMap, const DispComputeParams &params);
+    /**
+     * @brief one pass over the rows, the forward pass stores the forward
+     * state of every pixel, the backward pass picks the disparities
+     *
+     * @tparam CostT cost type
+     * @tparam AggT aggregated cost type
+     * @param left base image
+     * @param strips costs of the image pair
+     * @param forward forward(top to bottom) or backward pass
+     * @param states forward states of the pixels
+     * @param dispMap disparity map, written by the backward pass
+     * @param bestDisp integer disparities, written by the backward pass
+     * @param confidenceMap confidence map, written by the backward pass,
+     * nullptr if not wanted
+     * @param params disparity computation control parameters
+     */
+    template <typename CostT, typename AggT>
+    void aggregationPass(const cv::Mat &left, CostStrips &strips,
+                         const bool forward, vector<ForwardState<AggT>> &states,
+                         cv::Mat &dispMap, cv::Mat &bestDisp,
+                         cv::Mat *confidenceMap,
+                         const DispComputeParams &params);
+    Params params_;
+};
+
+template <typename CostT, typename AggT>
+void MemoryEfficientAggregationImpl::aggregationPass(
+    const cv::Mat &left, CostStrips &strips, const bool forward,
+    vector<ForwardState<AggT>> &states, cv::Mat &dispMap, cv::Mat &bestDisp,
+    cv::Mat *confidenceMap, const DispComputeParams &params) {
+    typedef typename CostTraits<AggT>::Work Work;
+    const AggT invalid = CostTraits<AggT>::invalid();
+    const Work P1 = path::toWork<Work>(params_.P1);
+    const path::Penalties<Work> penalties = path::preparePenalties<Work>(
+        params_.penaltyModel, params_.P1, params_.P2, left);
+    const Mat &guide = penalties.guide;
+    const path::UpdatePathFunc<CostT, AggT> updatePath =
+        path::selectUpdatePath<CostT, AggT>();
+
+    const int rows = left.rows, cols = left.cols;
+    const int dispRange = strips.dispRange();
+    const int stride = dispRange + 2;
+    const int direction = forward ? 1 : -1;
+    // the left-right check of the mirrored pair follows the passes
+    DispComputeParams pixelParams = params;
+    pixelParams.enableLRCheck = false;
+
+    // the paths coming from the previous row: vertical, negative 45 and
+    // positive 45, whose previous pixels are at these column offsets in the
+    // direction of the pass
+    const int pathCount = 3;
+    const int lastOffset[pathCount] = {0, -1, 1};
+    const bool enabled[pathCount] = {params_.enableVertiacl,
+                                     params_.enableNegtive45,
+                                     params_.enablePostive45};
+
+    // path costs of the previous and of the current row, shifted by one
+    // disparity with invalid costs around the band
+    vector<AggT> lastRow(pathCount * cols * stride, invalid),
+        curRow(pathCount * cols * stride, invalid);
+    vector<Work> lastRowMin(pathCount * cols), curRowMin(pathCount * cols);
+    vector<AggT> lastCost(stride, invalid), curCost(stride, invalid);
+    // the horizontal paths of a row run while the other paths are updated,
+    // into a sum of their own which joins the sum of the others afterwards
+    vector<AggT> sum(static_cast<size_t>(cols) * dispRange);
+    vector<AggT> horizontalSum(static_cast<size_t>(cols) * dispRange);
+
+    for (int step = 0; step < rows; ++step) {
+        const int i = forward ? step : rows - 1 - step;
+        const CostT *ptrCost = reinterpret_cast<const CostT *>(strips.row(i));
+        const uchar *ptrGuide = guide.ptr<uchar>(i);
+        const uchar *ptrLastGuide =
+            step > 0 ? guide.ptr<uchar>(i - direction) : nullptr;
+        float *ptrDispMap = forward ? nullptr : dispMap.ptr<float>(i);
+        int *ptrBestDisp = forward ? nullptr : bestDisp.ptr<int>(i);
+        float *ptrConfidenceMap = !forward && confidenceMap != nullptr
+                                      ? confidenceMap->ptr<float>(i)
+                                      : nullptr;
+
+#pragma omp parallel default(shared)
+        {
+#pragma omp single nowait
+            if (params_.enableHonrizon) {
+                std::fill(horizontalSum.begin(), horizontalSum.end(),
+                          static_cast<AggT>(0));
+                const int beginLoc = forward ? 0 : cols - 1;
+                Work lastMin = invalid;
+                for (int d = 0; d < dispRange; ++d) {
+                    const Work pathCost = ptrCost[beginLoc * dispRange + d];
+                    lastCost[d + 1] = static_cast<AggT>(pathCost);
+                    lastMin = min(lastMin, pathCost);
+                    horizontalSum[beginLoc * dispRange + d] =
+                        static_cast<AggT>(pathCost);
+                }
+                for (int j = beginLoc + direction; j >= 0 && j < cols;
+                     j += direction) {
+                    lastMin = updatePath(
+                        ptrCost + j * dispRange, lastCost.data() + 1, 0,
+                        dispRange, P1, lastMin,
+                        penalties.table[abs(ptrGuide[j] -
+                                            ptrGuide[j - direction])],
+                        curCost.data() + 1,
+                        horizontalSum.data() + j * dispRange);
+                    lastCost.swap(curCost);
+                }
+            }
+
+            // the thread of the horizontal paths joins the columns left when
+            // it is done
+#pragma omp for schedule(dynamic, 16)
+            for (int j = 0; j < cols; ++j) {
+                const CostT *ptrPixelCost = ptrCost + j * dispRange;
+                AggT *ptrSum = sum.data() + j * dispRange;
+                std::fill(ptrSum, ptrSum + dispRange, static_cast<AggT>(0));
+
+                for (int path = 0; path < pathCount; ++path) {
+                    if (!enabled[path]) {
+                        continue;
+                    }
+
+                    const int lastJ = j + lastOffset[path] * direction;
+                    AggT *ptrOut =
+                        curRow.data() + (path * cols + j) * stride + 1;
+                    Work &curMin = curRowMin[path * cols + j];
+
+                    if (step == 0 || lastJ < 0 || lastJ >= cols) {
+                        curMin = invalid;
+                        for (int d = 0; d < dispRange; ++d) {
+                            const Work pathCost = ptrPixelCost[d];
+                            ptrOut[d] = static_cast<AggT>(pathCost);
+                            curMin = min(curMin, pathCost);
+                            ptrSum[d] = CostTraits<AggT>::saturate(
+                                static_cast<Work>(ptrSum[d]) + pathCost);
+                        }
+                    } else {
+                        curMin = updatePath(
+                            ptrPixelCost,
+                            lastRow.data() + (path * cols + lastJ) * stride +
+                                1,
+                            0, dispRange, P1, lastRowMin[path * cols + lastJ],
+                            penalties.table[abs(ptrGuide[j] -
+                                                ptrLastGuide[lastJ])],
+                            ptrOut, ptrSum);
+                    }
+                }
+            }
+
+            // sums of both passes of a pixel
+            vector<Work> total(forward ? 0 : dispRange);
+#pragma omp for schedule(static)
+            for (int j = 0; j < cols; ++j) {
+                AggT *ptrSum = sum.data() + j * dispRange;
+                if (params_.enableHonrizon) {
+                    const AggT *ptrHorizontalSum =
+                        horizontalSum.data() + j * dispRange;
+                    for (int d = 0; d < dispRange; ++d) {
+                        ptrSum[d] = CostTraits<AggT>::saturate(
+                            static_cast<Work>(ptrSum[d]) +
+                            ptrHorizontalSum[d]);
+                    }
+                }
+
+                if (forward) {
+                    ForwardState<AggT> &state = states[i * cols + j];
+                    state.disp = static_cast<uint16_t>(
+                        min_element(ptrSum, ptrSum + dispRange) - ptrSum);
+                    state.otherMin = invalid;
+                    for (int d = 0; d < dispRange; ++d) {
+                        if (abs(d - state.disp) > 1) {
+                            state.otherMin = min(state.otherMin, ptrSum[d]);
+                        }
+                    }
+                    for (int k = 0; k < 3; ++k) {
+                        const int d = state.disp - 1 + k;
+                        state.cost[k] = d >= 0 && d < dispRange ? ptrSum[d]
+                                                                : invalid;
+                    }
+                    continue;
+                }
+
+                const ForwardState<AggT> &state = states[i * cols + j];
+                int majorDisp = 0;
+                for (int d = 0; d < dispRange; ++d) {
+                    const Work forwardCost =
+                        abs(d - state.disp) <= 1
+                            ? state.cost[d - state.disp + 1]
+                            : state.otherMin;
+                    total[d] = static_cast<Work>(ptrSum[d]) + forwardCost;
+                    if (total[d] < total[majorDisp]) {
+                        majorDisp = d;
+                    }
+                }
+
+                // the neighbours of the minimum belong to the same match
+                Work minorMinCost = numeric_limits<Work>::max();
+                for (int d = 0; d < dispRange; ++d) {
+                    if (abs(d - majorDisp) > 1) {
+                        minorMinCost = min(minorMinCost, total[d]);
+                    }
+                }
+
+                wta::Winner winner;
+                winner.disp = majorDisp;
+                winner.cost = static_cast<float>(total[majorDisp]);
+                winner.minorCost = static_cast<float>(minorMinCost);
+                winner.inside = majorDisp > 0 && majorDisp < dispRange - 1;
+                winner.preCost =
+                    winner.inside ? static_cast<float>(total[majorDisp - 1])
+                                  : 0.f;
+                winner.aftCost =
+                    winner.inside ? static_cast<float>(total[majorDisp + 1])
+                                  : 0.f;
+
+                ptrDispMap[j] = wta::pickDisparity(
+                    winner, j, -1, pixelParams,
+                    ptrConfidenceMap != nullptr ? ptrConfidenceMap + j
+                                                : nullptr);
+                ptrBestDisp[j] =
+                    params.enableUniqueCheck &&
+                            !wta::isUnique(winner, params.uniquenessRatio)
+                        ? -1
+                        : majorDisp;
+            }
+        }
+
+        lastRow.swap(curRow);
+        lastRowMin.swap(curRowMin);
+    }
+}
+
+void MemoryEfficientAggregationImpl::match(const cv::Mat &left,
+                                           const cv::Mat &right,
+                                           CostComputer &computer,
+                                           cv::Mat &dispMap, cv::Mat &bestDisp,
+                                           cv::Mat *confidenceMap,
+                                           const DispComputeParams &params) {
+    CostStrips strips(left, right, computer, params_.stripRows);
+    // the first strip tells the cost type
+    strips.row(0);
+    CV_Assert_N(strips.depth() == CV_8U || strips.depth() == CV_16U ||
+                    strips.depth() == CV_32F,
+                strips.dispRange() == params.maxDisp - params.minDisp);
+
+    dispMap.create(left.size(), CV_32FC1);
+    bestDisp.create(left.size(), CV_32SC1);
+    if (confidenceMap != nullptr)
+        confidenceMap->create(left.size(), CV_32FC1);
+
+    if (strips.depth() == CV_32F) {
+        vector<ForwardState<float>> states(left.total());
+        aggregationPass<float, float>(left, strips, true, states, dispMap,
+                                      bestDisp, confidenceMap, params);
+        aggregationPass<float, float>(left, strips, false, states, dispMap,
+                                      bestDisp, confidenceMap, params);
+    } else {
+        vector<ForwardState<uint16_t>> states(left.total());
+        if (strips.depth() == CV_8U) {
+            aggregationPass<uint8_t, uint16_t>(left, strips, true, states,
+                                               dispMap, bestDisp,
+                                               confidenceMap, params);
+            aggregationPass<uint8_t, uint16_t>(left, strips, false, states,
+                                               dispMap, bestDisp,
+                                               confidenceMap, params);
+        } else {
+            aggregationPass<uint16_t, uint16_t>(left, strips, true, states,
+                                                dispMap, bestDisp,
+                                                confidenceMap, params);
+            aggregationPass<uint16_t, uint16_t>(left, strips, false, states,
+                                                dispMap, bestDisp,
+                                                confidenceMap, params);
+        }
+    }
+}
+
+void MemoryEfficientAggregationImpl::aggregationDisp(
+    const cv::Mat &left, const cv::Mat &right, CostComputer &computer,
+    cv::Mat &dispMap, cv::Mat *confidenceMap,
+    const DispComputeParams &params) {
+    CV_Assert_N(!left.empty(), left.type() == CV_8UC1,
+                left.size() == right.size(), right.type() == CV_8UC1);
+
+    Mat leftDisp, leftBestDisp;
+    match(left, right, computer, leftDisp, leftBestDisp, confidenceMap,
+          params);
+
+    // the left-right difference is the only confidence which needs the
+    // right image matched
+    const bool lrConfidence =
+        confidenceMap != nullptr &&
+        params.confidenceType == ConfidenceType::LeftRightDifference;
+    if (!params.enableLRCheck && !lrConfidence) {
+        dispMap = leftDisp;
+        return;
+    }
+
+    // the right image is the base image of the mirrored pair, whose
+    // disparities grow in the same direction as the ones of the left image
+    Mat mirroredLeft, mirroredRight;
+    flip(right, mirroredLeft, 1);
+    flip(left, mirroredRight, 1);
+    DispComputeParams rightParams = params;
+    rightParams.enableUniqueCheck = false;
+    rightParams.enableSubpixelFitting = false;
+    Mat rightDisp, rightBestDisp;
+    match(mirroredLeft, mirroredRight, computer, rightDisp, rightBestDisp,
+          nullptr, rightParams);
+
+    const int cols = left.cols;
+#pragma omp parallel for schedule(static) default(shared)
+    for (int i = 0; i < left.rows; ++i) {
+        float *ptrDispMap = leftDisp.ptr<float>(i);
+        const int *ptrLeftBestDisp = leftBestDisp.ptr<int>(i);
+        const int *ptrRightBestDisp = rightBestDisp.ptr<int>(i);
+        float *ptrConfidenceMap =
+            confidenceMap != nullptr ? confidenceMap->ptr<float>(i) : nullptr;
+
+        for (int j = 0; j < cols; ++j) {
+            if (ptrLeftBestDisp[j] < 0) {
+                continue;
+            }
+
+            const int disp = ptrLeftBestDisp[j] + params.minDisp;
+            const int rx = j - disp;
+            if (rx < 0 || rx >= cols) {
+                if (lrConfidence) {
+                    ptrConfidenceMap[j] = 0.f;
+                }
+                continue;
+            }
+
+            const int rightDisp =
+                ptrRightBestDisp[cols - 1 - rx] + params.minDisp;
+            if (params.enableLRCheck &&
+                abs(disp - rightDisp) > params.lrCheckThreshod) {
+                ptrDispMap[j] =
+                    disp < rightDisp ? OCCLUDED_PIXEL : MISMATCHED_PIXEL;
+                if (ptrConfidenceMap != nullptr) {
+                    ptrConfidenceMap[j] = 0.f;
+                }
+            } else if (lrConfidence) {
+                ptrConfidenceMap[j] = 1.f / (1 + abs(disp - rightDisp));
+            }
+        }
+    }
+
+    dispMap = leftDisp;
+}
+
+void MemoryEfficientAggregationImpl::aggregation(
+    const cv::Mat &left, const cv::Mat &right, CostComputer &computer,
+    cv::Mat &dispMap, const DispComputeParams params) {
+    aggregationDisp(left, right, computer, dispMap, nullptr, params);
+}
+
+void MemoryEfficientAggregationImpl::aggregation(
+    const cv::Mat &left, const cv::Mat &right, CostComputer &computer,
+    cv::Mat &dispMap, cv::Mat &confidenceMap,
+    const DispComputeParams params) {
+    aggregationDisp(left, right, computer, dispMap, &confidenceMap, params);
+}
+
+Ptr<MemoryEfficientAggregation>
+MemoryEfficientAggregation::create(const Params params) {
+    return Ptr<MemoryEfficientAggregation>(
+        new MemoryEfficientAggregationImpl(params));
+}
+} // namespace libSM
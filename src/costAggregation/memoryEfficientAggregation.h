@@ -0,0 +1,109 @@
+/**
+ * @file memoryEfficientAggregation.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __MEMORY_EFFICIENT_AGGREGATION_H_
+#define __MEMORY_EFFICIENT_AGGREGATION_H_
+
+#include <typeDef.h>
+#include <costCompute/costCompute.h>
+#include <dispCompute/dispCompute.h>
+
+#include "penaltyModel.h"
+
+namespace cv {
+class Mat;
+}
+
+namespace libSM {
+/**
+ * @brief memory efficient multi-path aggregation(eSGM) with an on the fly
+ * winner-takes-all. The forward pass runs the paths from the left and from
+ * the top and leaves every pixel the disparity of its minimal forward sum with
+ * the sums around it, the backward pass runs the other paths and picks the
+ * disparity of the sum of both passes, the forward sum of a disparity away
+ * from the forward minimum is taken as the minimum of the forward sum there.
+ * The costs are computed strip by strip, so that only the cost of a strip and
+ * the path costs of two rows are resident besides the per-pixel state.
+ *
+ * @paper H. Hirschmuller, M. Buder and I. Ernst, "Memory Efficient
+ * Semi-Global Matching," in ISPRS Annals of the Photogrammetry, Remote
+ * Sensing and Spatial Information Sciences, vol. I-3, pp. 371-376, 2012.
+ *
+ */
+class LIBSM_API MemoryEfficientAggregation {
+  public:
+    /**
+     * @brief cost aggregation parameters
+     *
+     */
+    struct Params {
+        Params()
+            : enableHonrizon(true), enableVertiacl(true),
+              enablePostive45(true), enableNegtive45(true), P1(10.f),
+              P2(150.f), stripRows(64) {}
+        bool enableHonrizon;  // enable aggregation on horizontal line
+        bool enableVertiacl;  // enable aggregation on vertical line
+        bool enablePostive45; // enable aggregation on postive 45 line
+        bool enableNegtive45; // enable aggregation on negtive 45 line
+        float P1;             // penalty coefficient for disparity continuity
+        float P2;       // penalty coefficient for disparity no continuity
+        int stripRows;  // image rows of a cost strip, a strip is computed
+                        // with the rows its cost windows reach around it
+        Ptr<PenaltyModel> penaltyModel; // penalty of disparity changes larger
+                                        // than one pixel, the inverse
+                                        // gradient model of P1 and P2 if empty
+    };
+    virtual ~MemoryEfficientAggregation() {}
+    /**
+     * @brief create MemoryEfficientAggregation
+     *
+     * @param params cost aggregation parameters
+     * @return Ptr<MemoryEfficientAggregation> MemoryEfficientAggregation's Ptr
+     */
+    static Ptr<MemoryEfficientAggregation> create(IN const Params params);
+    /**
+     * @brief aggregation cost and winner-takes-all, the left-right check
+     * matches the mirrored images once more
+     *
+     * @param left rectified left image(CV_8UC1)
+     * @param right rectified right image(CV_8UC1)
+     * @param computer cost computer of the disparity range of params, its costs
+     * are CV_8U, CV_16U or CV_32F and its window height tells the rows around
+     * a strip the strip costs need
+     * @param dispMap disparity map
+     * @param params disparity computation control parameters
+     */
+    virtual void aggregation(IN const cv::Mat &left, IN const cv::Mat &right,
+                             IN CostComputer &computer, OUT cv::Mat &dispMap,
+                             IN const DispComputeParams params) = 0;
+    /**
+     * @brief aggregation cost and winner-takes-all which gives the confidence
+     * of every disparity as well, taken from the sums of both passes the
+     * disparity is picked from
+     *
+     * @param left rectified left image(CV_8UC1)
+     * @param right rectified right image(CV_8UC1)
+     * @param computer cost computer of the disparity range of params, its costs
+     * are CV_8U, CV_16U or CV_32F and its window height tells the rows around
+     * a strip the strip costs need
+     * @param dispMap disparity map
+     * @param confidenceMap confidence map(CV_32F) of params.confidenceType, 0
+     * where the checks reject the disparity
+     * @param params disparity computation control parameters
+     */
+    virtual void aggregation(IN const cv::Mat &left, IN const cv::Mat &right,
+                             IN CostComputer &computer, OUT cv::Mat &dispMap,
+                             OUT cv::Mat &confidenceMap,
+                             IN const DispComputeParams params) = 0;
+};
+} // namespace libSM
+
+#endif //!__MEMORY_EFFICIENT_AGGREGATION_H_
@@ -0,0 +1,268 @@
+#include "mgmAggregation.h"
+#include "common/costTraits.h"
+#include "pathKernel.h"
+#include "pathPenalty.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace libSM {
+/**
+ * @brief pixels of a block of a line, the blocks of a line are handed out to
+ * the threads
+ *
+ */
+static const int MGM_BLOCK_PIXELS = 64;
+
+class MGMAggregationImpl : public MGMAggregation {
+  public:
+    MGMAggregationImpl(const Params params) : params_(params){};
+    void aggregation(const cv::Mat &left, const cv::Mat &cost,
+                     cv::Mat &aggregationCost) override;
+
+  private:
+    /**
+     * @brief aggregation cost along one direction, the previous pixels of a
+     * pixel are the one at -direction and the one at -direction turned by 90
+     * degrees
+     *
+     * @tparam CostT cost type
+     * @tparam AggT aggregated cost type
+     * @param cost cost space
+     * @param penalties penalties of the paths
+     * @param aggregationCost aggregated cost
+     * @param directionY row step of the direction(-1, 0 or 1)
+     * @param directionX column step of the direction(-1, 0 or 1)
+     */
+    template <typename CostT, typename AggT>
+    void aggregationDirection(
+        const cv::Mat &cost,
+        const path::Penalties<typename CostTraits<AggT>::Work> &penalties,
+        cv::Mat &aggregationCost, const int directionY, const int directionX);
+    /**
+     * @brief aggregation cost along all the enabled directions
+     *
+     * @tparam CostT cost type
+     * @tparam AggT aggregated cost type
+     * @param left  left image
+     * @param cost cost space
+     * @param aggregationCost aggregated cost
+     */
+    template <typename CostT, typename AggT>
+    void aggregationImpl(const cv::Mat &left, const cv::Mat &cost,
+                         cv::Mat &aggregationCost);
+    Params params_;
+};
+
+template <typename CostT, typename AggT>
+void MGMAggregationImpl::aggregationDirection(
+    const cv::Mat &cost,
+    const path::Penalties<typename CostTraits<AggT>::Work> &penalties,
+    cv::Mat &aggregationCost, const int directionY, const int directionX) {
+    typedef typename CostTraits<AggT>::Work Work;
+    const Work P1 = path::toWork<Work>(params_.P1);
+    const Mat &guide = penalties.guide;
+    const path::UpdatePathPairFunc<CostT, AggT> updatePath =
+        path::selectUpdatePathPair<CostT, AggT>();
+
+    const int rows = cost.rows, cols = cost.cols;
+    const int dispRange = cost.channels();
+
+    // the offsets of the two previous pixels
+    const int predY[2] = {-directionY, -directionX};
+    const int predX[2] = {-directionX, directionY};
+
+    // the image is swept line by line, a line only depends on itself and on
+    // the line before. The lines are rows unless both previous pixels are in
+    // the column before(the postive 45 directions).
+    const bool rowSweep =
+        predY[0] == predY[1] || predY[0] == 0 || predY[1] == 0;
+    const int lines = rowSweep ? rows : cols;
+    const int lineLength = rowSweep ? cols : rows;
+    int lineStep = 1, pixelStep = 1;
+    if (rowSweep) {
+        lineStep = -(predY[0] != 0 ? predY[0] : predY[1]);
+        if (predY[0] == 0) {
+            pixelStep = -predX[0];
+        } else if (predY[1] == 0) {
+            pixelStep = -predX[1];
+        }
+    } else {
+        lineStep = -predX[0];
+    }
+
+    // the previous pixels in sweep coordinates, one line back(-1) or on the
+    // same line(0), and the offset on that line
+    int predLine[2], predPixel[2];
+    for (int n = 0; n < 2; ++n) {
+        predLine[n] = (rowSweep ? predY[n] : predX[n]) * lineStep;
+        predPixel[n] = (rowSweep ? predX[n] : predY[n]) * pixelStep;
+    }
+
+    // a pixel depending on the pixel before it on the same line(the
+    // horizontal and vertical directions) waits for the block before it, so
+    // that the blocks of a line run one wave behind each other
+    const bool pixelDependent = predLine[0] == 0 || predLine[1] == 0;
+    const int blocks = (lineLength + MGM_BLOCK_PIXELS - 1) / MGM_BLOCK_PIXELS;
+    const int skew = pixelDependent ? 1 : 0;
+    const int waves = lines + skew * (blocks - 1);
+
+    // the path costs and their minimums of the current and of the last line,
+    // every pixel has an invalid cell on both sides of its disparities
+    const int pixelCells = dispRange + 2;
+    vector<AggT> pathCost[2] = {
+        vector<AggT>(lineLength * pixelCells, CostTraits<AggT>::invalid()),
+        vector<AggT>(lineLength * pixelCells, CostTraits<AggT>::invalid())};
+    vector<Work> pathMin[2] = {vector<Work>(lineLength),
+                               vector<Work>(lineLength)};
+
+    for (int wave = 0; wave < waves; ++wave) {
+#pragma omp parallel for schedule(dynamic) default(shared)
+        for (int block = 0; block < blocks; ++block) {
+            const int line = wave - skew * block;
+            if (line < 0 || line >= lines) {
+                continue;
+            }
+
+            AggT *curCost = pathCost[line & 1].data();
+            const AggT *lastCost = pathCost[(line + 1) & 1].data();
+            Work *curMin = pathMin[line & 1].data();
+            const Work *lastMin = pathMin[(line + 1) & 1].data();
+            const int outer = lineStep > 0 ? line : lines - 1 - line;
+
+            const int blockEnd =
+                min(lineLength, (block + 1) * MGM_BLOCK_PIXELS);
+            for (int k = block * MGM_BLOCK_PIXELS; k < blockEnd; ++k) {
+                const int inner = pixelStep > 0 ? k : lineLength - 1 - k;
+                const int i = rowSweep ? outer : inner;
+                const int j = rowSweep ? inner : outer;
+                const CostT *ptrCost = cost.ptr<CostT>(i) + j * dispRange;
+                AggT *ptrSum = aggregationCost.ptr<AggT>(i) + j * dispRange;
+                AggT *ptrPathCost = curCost + k * pixelCells + 1;
+                const uchar pixel = guide.ptr<uchar>(i)[j];
+
+                const AggT *ptrLastCost[2];
+                Work lastMinCost[2], penalty[2];
+                int valid = 0;
+                for (int n = 0; n < 2; ++n) {
+                    const int lastK = k + predPixel[n];
+                    if (line + predLine[n] < 0 || lastK < 0 ||
+                        lastK >= lineLength) {
+                        continue;
+                    }
+                    const bool sameLine = predLine[n] == 0;
+                    ptrLastCost[valid] =
+                        (sameLine ? curCost : lastCost) + lastK * pixelCells +
+                        1;
+                    lastMinCost[valid] = (sameLine ? curMin : lastMin)[lastK];
+                    const uchar lastPixel =
+                        guide.ptr<uchar>(i + predY[n])[j + predX[n]];
+                    penalty[valid] = penalties.table[abs(pixel - lastPixel)];
+                    ++valid;
+                }
+
+                if (valid == 0) {
+                    // the first pixel of the sweep starts the path with its
+                    // costs
+                    Work minCost = CostTraits<AggT>::invalid();
+                    for (int d = 0; d < dispRange; ++d) {
+                        const Work pathCostD = ptrCost[d];
+                        ptrPathCost[d] = static_cast<AggT>(pathCostD);
+                        minCost = min(minCost, pathCostD);
+                        ptrSum[d] = CostTraits<AggT>::saturate(
+                            static_cast<Work>(ptrSum[d]) + pathCostD);
+                    }
+                    curMin[k] = minCost;
+                    continue;
+                }
+
+                // a pixel on the border has a single previous pixel, which
+                // averaged with itself is the recurrence of SGM
+                if (valid == 1) {
+                    ptrLastCost[1] = ptrLastCost[0];
+                    lastMinCost[1] = lastMinCost[0];
+                    penalty[1] = penalty[0];
+                }
+                curMin[k] = updatePath(ptrCost, ptrLastCost[0], ptrLastCost[1],
+                                       0, dispRange, P1, lastMinCost[0],
+                                       lastMinCost[1], penalty[0], penalty[1],
+                                       ptrPathCost, ptrSum);
+            }
+        }
+    }
+}
+
+template <typename CostT, typename AggT>
+void MGMAggregationImpl::aggregationImpl(const cv::Mat &left,
+                                         const cv::Mat &cost,
+                                         cv::Mat &aggregationCost) {
+    // every direction adds its costs to the aggregated cost in place
+    aggregationCost.setTo(0);
+    const path::Penalties<typename CostTraits<AggT>::Work> penalties =
+        path::preparePenalties<typename CostTraits<AggT>::Work>(
+            params_.penaltyModel, params_.P1, params_.P2, left);
+
+    if (params_.enableHonrizon) {
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          0, 1);
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          0, -1);
+    }
+
+    if (params_.enableVertiacl) {
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          1, 0);
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          -1, 0);
+    }
+
+    if (params_.enablePostive45) {
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          1, -1);
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          -1, 1);
+    }
+
+    if (params_.enableNegtive45) {
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          1, 1);
+        aggregationDirection<CostT, AggT>(cost, penalties, aggregationCost,
+                                          -1, -1);
+    }
+}
+
+void MGMAggregationImpl::aggregation(const cv::Mat &left, const cv::Mat &cost,
+                                     cv::Mat &aggregationCost) {
+    CV_Assert_N(!cost.empty(), left.size() == cost.size(),
+                cost.depth() == CV_8U || cost.depth() == CV_16U ||
+                    cost.depth() == CV_32F);
+
+    if (!params_.enableHonrizon && !params_.enableVertiacl &&
+        !params_.enableNegtive45 && !params_.enablePostive45) {
+        if (cost.depth() == CV_8U)
+            cost.convertTo(aggregationCost, CV_16U);
+        else
+            aggregationCost = cost;
+        return;
+    }
+
+    const int aggregationDepth = cost.depth() == CV_32F ? CV_32F : CV_16U;
+    aggregationCost =
+        Mat(cost.size(), CV_MAKETYPE(aggregationDepth, cost.channels()));
+
+    if (cost.depth() == CV_8U) {
+        aggregationImpl<uint8_t, uint16_t>(left, cost, aggregationCost);
+    } else if (cost.depth() == CV_16U) {
+        aggregationImpl<uint16_t, uint16_t>(left, cost, aggregationCost);
+    } else {
+        aggregationImpl<float, float>(left, cost, aggregationCost);
+    }
+}
+
+Ptr<CostAggregation> MGMAggregation::create(const Params params) {
+    return Ptr<CostAggregation>(new MGMAggregationImpl(params));
+}
+
+} // namespace libSM
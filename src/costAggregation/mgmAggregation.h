@@ -0,0 +1,75 @@
+/**
+ * @file mgmAggregation.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-21
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __MGM_AGGREGATION_H_
+#define __MGM_AGGREGATION_H_
+
+#include "costAggregation.h"
+#include "penaltyModel.h"
+
+namespace libSM {
+/**
+ * @brief More Global Matching cost aggregator. The path cost of a pixel
+ * averages the SGM recurrence over two previous pixels of the quadrant of the
+ * direction, the one along the direction and the one along the direction
+ * turned by 90 degrees, so that every path sees a 2D neighbourhood and the
+ * streaking of the 1D paths of SGM is reduced.
+ *
+ * @paper G. Facciolo, C. de Franchis and E. Meinhardt, "MGM: A Significantly
+ * More Global Matching for Stereovision," in Proceedings of the British
+ * Machine Vision Conference, 2015.
+ *
+ */
+class LIBSM_API MGMAggregation : public CostAggregation {
+  public:
+    /**
+     * @brief cost aggregation parameters
+     *
+     */
+    struct Params {
+        Params()
+            : enableHonrizon(true), enableVertiacl(true),
+              enablePostive45(true), enableNegtive45(true), P1(10.f),
+              P2(150.f) {}
+        bool enableHonrizon;  // enable aggregation on horizontal line
+        bool enableVertiacl;  // enable aggregation on vertical line
+        bool enablePostive45; // enable aggregation on postive 45 line
+        bool enableNegtive45; // enable aggregation on negtive 45 line
+        float P1;             // penalty coefficient for disparity continuity
+        float P2;             // penalty coefficient for disparity no continuity
+        Ptr<PenaltyModel> penaltyModel; // penalty of disparity changes larger
+                                        // than one pixel, the inverse
+                                        // gradient model of P1 and P2 if empty
+    };
+    using CostAggregation::aggregation;
+    virtual ~MGMAggregation() {}
+    /**
+     * @brief create MGMAggregation
+     *
+     * @param params cost aggregation parameters
+     * @return Ptr<CostAggregation> CostAggregation's Ptr
+     */
+    static Ptr<CostAggregation> create(IN const Params params);
+    /**
+     * @brief aggregation cost
+     *
+     * @param left  left image
+     * @param cost cost space(CV_8U, CV_16U or CV_32F)
+     * @param aggregationCost aggregated cost, CV_16U for integer costs and
+     * CV_32F for float costs
+     */
+    virtual void aggregation(IN const cv::Mat &left,
+                             IN const cv::Mat &cost,
+                             OUT cv::Mat &aggregationCost) override = 0;
+};
+} // namespace libSM
+
+#endif //!__MGM_AGGREGATION_H_
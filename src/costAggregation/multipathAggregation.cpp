@@ -1,4 +1,8 @@
 #include "multipathAggregation.h"
+#include "common/costTraits.h"
+#include "pathKernel.h"
+#include "pathPenalty.h"
+#include "dispCompute/dispKernel.h"
 
 #include <opencv2/opencv.hpp>
 
@@ -6,374 +10,715 @@ using namespace cv;
 using namespace std;
 
 namespace libSM {
+/**
+ * @brief move the band of a pixel, the cells of the old band out of the new
+ * one become invalid, the new band is left to be written
+ *
+ * @tparam AggT aggregated cost type
+ * @param pathCost path costs of the pixel, shifted by one disparity
+ * @param begin band begin, updated
+ * @param end band end, updated
+ * @param newBegin new band begin
+ * @param newEnd new band end
+ */
+template <typename AggT>
+static void setPathBand(AggT *pathCost, int &begin, int &end,
+                        const int newBegin, const int newEnd) {
+    const AggT invalid = CostTraits<AggT>::invalid();
+    std::fill(pathCost + begin + 1,
+              pathCost + max(min(end, newBegin), begin) + 1, invalid);
+    std::fill(pathCost + min(max(begin, newEnd), end) + 1, pathCost + end + 1,
+              invalid);
+    begin = newBegin;
+    end = newEnd;
+}
+
+/**
+ * @brief rolling state of a tile of path lines advanced together, the path
+ * costs of the previous and of the current pixel of every line lie in two
+ * compact buffers, so that the lines of a tile stepping through adjacent
+ * pixels of a row read and write adjacent memory. The path costs of every
+ * pixel are added to the aggregated cost as soon as they are computed.
+ *
+ * @tparam CostT cost type
+ * @tparam AggT aggregated cost type
+ */
+template <typename CostT, typename AggT> class PathTile {
+  public:
+    typedef typename CostTraits<AggT>::Work Work;
+
+    PathTile(const int lines, const int dispRange, const Work P1,
+             const path::UpdatePathFunc<CostT, AggT> updatePath)
+        : pixelCells_(dispRange + 2),
+          lastCost_(lines * pixelCells_, CostTraits<AggT>::invalid()),
+          curCost_(lines * pixelCells_, CostTraits<AggT>::invalid()),
+          lastBegin_(lines, 0), lastEnd_(lines, 0), curBegin_(lines, 0),
+          curEnd_(lines, 0), lastMin_(lines, CostTraits<AggT>::invalid()),
+          curMin_(lines, CostTraits<AggT>::invalid()), P1_(P1),
+          updatePath_(updatePath){};
+
+    /**
+     * @brief start a line at a pixel, whose path costs are its costs
+     *
+     * @param line line of the tile
+     * @param ptrCost costs of the pixel(cell d at ptrCost[d])
+     * @param dispBegin band begin of the pixel
+     * @param dispEnd band end of the pixel
+     * @param ptrSum aggregated cost of the pixel
+     */
+    void start(const int line, const CostT *ptrCost, const int dispBegin,
+               const int dispEnd, AggT *ptrSum) {
+        AggT *lastCost = lastCost_.data() + line * pixelCells_;
+        setPathBand(lastCost, lastBegin_[line], lastEnd_[line], dispBegin,
+                    dispEnd);
+        Work lastMin = CostTraits<AggT>::invalid();
+        for (int d = dispBegin; d < dispEnd; ++d) {
+            const Work pathCost = ptrCost[d];
+            lastCost[d + 1] = static_cast<AggT>(pathCost);
+            lastMin = min(lastMin, pathCost);
+            ptrSum[d] = CostTraits<AggT>::saturate(
+                static_cast<Work>(ptrSum[d]) + pathCost);
+        }
+        lastMin_[line] = lastMin;
+    }
+
+    /**
+     * @brief move a line to its next pixel, the pixel is current until the
+     * tile advances
+     *
+     * @param line line of the tile
+     * @param ptrCost costs of the pixel(cell d at ptrCost[d])
+     * @param dispBegin band begin of the pixel
+     * @param dispEnd band end of the pixel
+     * @param penalty penalty of disparity changes larger than one pixel
+     * @param ptrSum aggregated cost of the pixel
+     */
+    void step(const int line, const CostT *ptrCost, const int dispBegin,
+              const int dispEnd, const Work penalty, AggT *ptrSum) {
+        AggT *curCost = curCost_.data() + line * pixelCells_;
+        setPathBand(curCost, curBegin_[line], curEnd_[line], dispBegin,
+                    dispEnd);
+        curMin_[line] = updatePath_(
+            ptrCost, lastCost_.data() + line * pixelCells_ + 1, dispBegin,
+            dispEnd, P1_, lastMin_[line], penalty, curCost + 1, ptrSum);
+    }
+
+    /**
+     * @brief the current pixels of the lines become the previous ones, a line
+     * which did not step is over
+     *
+     */
+    void advance() {
+        lastCost_.swap(curCost_);
+        lastBegin_.swap(curBegin_);
+        lastEnd_.swap(curEnd_);
+        lastMin_.swap(curMin_);
+    }
+
+  private:
+    const int pixelCells_;
+    vector<AggT> lastCost_, curCost_;
+    vector<int> lastBegin_, lastEnd_, curBegin_, curEnd_;
+    vector<Work> lastMin_, curMin_;
+    const Work P1_;
+    const path::UpdatePathFunc<CostT, AggT> updatePath_;
+};
+
+/**
+ * @brief path costs of the last rows of a direction swept row by row, the
+ * path costs of the pixels of a row lie in a compact buffer of the columns,
+ * so that a row step reads and writes adjacent pixels of adjacent rows
+ * whatever the direction. The path costs of every pixel are added to the
+ * aggregated cost as soon as they are computed.
+ *
+ * @tparam CostT cost type
+ * @tparam AggT aggregated cost type
+ */
+template <typename CostT, typename AggT> class PathRows {
+  public:
+    typedef typename CostTraits<AggT>::Work Work;
+
+    PathRows(const int rows, const int cols, const int dispRange,
+             const Work P1,
+             const path::UpdatePathFunc<CostT, AggT> updatePath)
+        : rows_(rows), cols_(cols), pixelCells_(dispRange + 2),
+          cost_(static_cast<size_t>(rows) * cols * pixelCells_,
+                CostTraits<AggT>::invalid()),
+          begin_(rows * cols, 0), end_(rows * cols, 0),
+          min_(rows * cols, CostTraits<AggT>::invalid()), P1_(P1),
+          updatePath_(updatePath){};
+
+    /**
+     * @brief start a path at a pixel, whose path costs are its costs
+     *
+     * @param i image y-coordinate
+     * @param j image x-coordinate
+     * @param ptrCost costs of the pixel(cell d at ptrCost[d])
+     * @param dispBegin band begin of the pixel
+     * @param dispEnd band end of the pixel
+     * @param ptrSum aggregated cost of the pixel
+     */
+    void start(const int i, const int j, const CostT *ptrCost,
+               const int dispBegin, const int dispEnd, AggT *ptrSum) {
+        const int pixel = slot(i, j);
+        AggT *pathCost = cost_.data() + pixel * pixelCells_;
+        setPathBand(pathCost, begin_[pixel], end_[pixel], dispBegin, dispEnd);
+        Work pathMin = CostTraits<AggT>::invalid();
+        for (int d = dispBegin; d < dispEnd; ++d) {
+            const Work val = ptrCost[d];
+            pathCost[d + 1] = static_cast<AggT>(val);
+            pathMin = min(pathMin, val);
+            ptrSum[d] =
+                CostTraits<AggT>::saturate(static_cast<Work>(ptrSum[d]) + val);
+        }
+        min_[pixel] = pathMin;
+    }
+
+    /**
+     * @brief continue the path of a pixel of a previous row at a pixel
+     *
+     * @param i image y-coordinate
+     * @param j image x-coordinate
+     * @param lastI y-coordinate of the previous pixel of the path
+     * @param lastJ x-coordinate of the previous pixel of the path
+     * @param ptrCost costs of the pixel(cell d at ptrCost[d])
+     * @param dispBegin band begin of the pixel
+     * @param dispEnd band end of the pixel
+     * @param penalty penalty of disparity changes larger than one pixel
+     * @param ptrSum aggregated cost of the pixel
+     */
+    void step(const int i, const int j, const int lastI, const int lastJ,
+              const CostT *ptrCost, const int dispBegin, const int dispEnd,
+              const Work penalty, AggT *ptrSum) {
+        const int pixel = slot(i, j), lastPixel = slot(lastI, lastJ);
+        AggT *pathCost = cost_.data() + pixel * pixelCells_;
+        setPathBand(pathCost, begin_[pixel], end_[pixel], dispBegin, dispEnd);
+        min_[pixel] = updatePath_(
+            ptrCost, cost_.data() + lastPixel * pixelCells_ + 1, dispBegin,
+            dispEnd, P1_, min_[lastPixel], penalty, pathCost + 1, ptrSum);
+    }
+
+  private:
+    /**
+     * @brief slot of a pixel, the rows take turns in the buffer
+     *
+     */
+    int slot(const int i, const int j) const { return i % rows_ * cols_ + j; }
+
+    const int rows_, cols_, pixelCells_;
+    vector<AggT> cost_;
+    vector<int> begin_, end_;
+    vector<Work> min_;
+    const Work P1_;
+    const path::UpdatePathFunc<CostT, AggT> updatePath_;
+};
+
 class MultipathAggregationImpl : public MultipathAggregation {
   public:
     MultipathAggregationImpl(const Params params) : params_(params){};
     void aggregation(const cv::Mat &left, const cv::Mat &cost,
                      cv::Mat &aggregationCost) override;
+    void aggregation(const cv::Mat &left, const CostVolume &cost,
+                     CostVolume &aggregationCost) override;
+    void aggregation(const cv::Mat &left, const cv::Mat &cost,
+                     cv::Mat &dispMap, const DispComputeParams params) override;
+    void aggregation(const cv::Mat &left, const cv::Mat &cost,
+                     cv::Mat &dispMap, cv::Mat &confidenceMap,
+                     const DispComputeParams params) override;
 
   private:
     /**
-     * @brief aggregation cost horizontally
+     * @brief the horizontal paths, a row is a job which walks it from left to
+     * right and back, so that the jobs add into disjoint rows of the one
+     * aggregated cost
      *
-     * @param left  left image
      * @param cost cost space
+     * @param penalties penalties of the paths
+     * @param rightToLeft also from right to left
      * @param aggregationCost aggregated cost
-     * @param leftToRight from left to right
      */
-    void aggregationHorizontal(const cv::Mat &left, const Mat &cost,
-                               Mat &aggregationCost, bool leftToRight = true);
+    template <typename CostT, typename AggT>
+    void horizontalRows(const CostVolume &cost,
+                        const path::Penalties<typename CostTraits<AggT>::Work>
+                            &penalties,
+                        const bool rightToLeft, CostVolume &aggregationCost);
     /**
-     * @brief aggregation cost vertically
+     * @brief sweep the rows of the image for the paths of directions going
+     * down or going up, a row is split into bands of columns and every pixel
+     * continues the paths of the pixels of the previous rows. A path starts
+     * at every pixel whose predecessor is out of the image.
      *
-     * @param left  left image
      * @param cost cost space
+     * @param penalties penalties of the paths
+     * @param directions steps of the paths(x one of 0, 1, 2, -1 or -2, y one
+     * of 1 and 2 or one of -1 and -2 for all the directions)
      * @param aggregationCost aggregated cost
-     * @param leftToRight from up to bottom
      */
-    void aggregationVertical(const cv::Mat &left, const Mat &cost,
-                             Mat &aggregationCost, bool upToBottom = true);
+    template <typename CostT, typename AggT>
+    void sweepRows(const CostVolume &cost,
+                   const path::Penalties<typename CostTraits<AggT>::Work>
+                       &penalties,
+                   const vector<Point> &directions,
+                   CostVolume &aggregationCost);
     /**
-     * @brief aggregation cost on the negative 45-degree line
+     * @brief the horizontal paths from right to left as the last direction,
+     * the sum of all the paths of a pixel is kept only until the winner of
+     * the pixel and the best matches of the right pixels are updated, one
+     * row a job
+     *
+     * @param cost cost space of the pixel-major layout
+     * @param penalties penalties of the paths
+     * @param aggregationCost aggregated cost of the other directions
+     * @param dispMap disparity map
+     * @param confidenceMap confidence map, nullptr if not wanted
+     * @param params disparity computation control parameters
+     */
+    template <typename CostT, typename AggT>
+    void
+    horizontalWinners(const CostVolume &cost,
+                      const path::Penalties<typename CostTraits<AggT>::Work>
+                          &penalties,
+                      const CostVolume &aggregationCost, cv::Mat &dispMap,
+                      cv::Mat *confidenceMap,
+                      const DispComputeParams &params);
+    /**
+     * @brief sweep the rows for all the enabled directions but the
+     * horizontal ones, the directions going down are swept together and then
+     * the ones going up, every pixel of a row steps all of them at once
      *
-     * @param left  left image
      * @param cost cost space
+     * @param penalties penalties of the paths
      * @param aggregationCost aggregated cost
-     * @param topLeftToBottomRight from top-left to bottom-right
      */
-    void aggregationNegative45(const cv::Mat &left, const Mat &cost,
-                               Mat &aggregationCost,
-                               bool topLeftToBottomRight = true);
+    template <typename CostT, typename AggT>
+    void
+    sweepDirections(const CostVolume &cost,
+                    const path::Penalties<typename CostTraits<AggT>::Work>
+                        &penalties,
+                    CostVolume &aggregationCost);
     /**
-     * @brief aggregation cost on the 45-degree line
+     * @brief aggregation cost along all the enabled paths
      *
+     * @tparam CostT cost type
+     * @tparam AggT aggregated cost type
      * @param left  left image
      * @param cost cost space
      * @param aggregationCost aggregated cost
-     * @param topRightToBottomLeft from top-right to bottom-left
      */
-    void aggregationPostive45(const cv::Mat &left, const Mat &cost,
-                              Mat &aggregationCost,
-                              bool topRightToBottomLeft = true);
+    template <typename CostT, typename AggT>
+    void aggregationImpl(const cv::Mat &left, const CostVolume &cost,
+                         CostVolume &aggregationCost);
+    /**
+     * @brief aggregation cost along all the enabled paths and winner-takes-all
+     * in the horizontal paths from right to left
+     *
+     * @tparam CostT cost type
+     * @tparam AggT aggregated cost type
+     * @param left  left image
+     * @param cost cost space of the pixel-major layout
+     * @param dispMap disparity map
+     * @param confidenceMap confidence map, nullptr if not wanted
+     * @param params disparity computation control parameters
+     */
+    template <typename CostT, typename AggT>
+    void aggregationDispImpl(const cv::Mat &left, const CostVolume &cost,
+                             cv::Mat &dispMap, cv::Mat *confidenceMap,
+                             const DispComputeParams &params);
+    /**
+     * @brief aggregation cost and winner-takes-all in one
+     *
+     * @param left  left image
+     * @param cost cost space
+     * @param dispMap disparity map
+     * @param confidenceMap confidence map, nullptr if not wanted
+     * @param params disparity computation control parameters
+     */
+    void aggregationDisp(const cv::Mat &left, const cv::Mat &cost,
+                         cv::Mat &dispMap, cv::Mat *confidenceMap,
+                         const DispComputeParams &params);
+    /**
+     * @brief aggregation of a pixel-major or ragged cost volume into an
+     * allocated volume of the same geometry
+     *
+     * @param left  left image
+     * @param cost cost volume
+     * @param aggregationCost aggregated cost volume
+     */
+    void aggregationPixelMajor(const cv::Mat &left, const CostVolume &cost,
+                               CostVolume &aggregationCost);
     Params params_;
 };
 
-void MultipathAggregationImpl::aggregationHorizontal(const cv::Mat &left,
-                                                     const Mat &cost,
-                                                     Mat &aggregationCost,
-                                                     bool leftToRight) {
-    const int beginLoc = leftToRight ? 0 : cost.cols - 1;
-    const int endLoc = leftToRight ? cost.cols : 0;
-    const int direction = leftToRight ? 1 : -1;
-
-#pragma omp parallel for schedule(dynamic) default(shared)
-    for (int i = 0; i < cost.rows; ++i) {
-        auto ptrCost = cost.ptr<float>(i);
-        auto ptrAggregationCost = aggregationCost.ptr<float>(i);
-        auto ptrLeft = left.ptr<uchar>(i);
-
-        vector<float> lastCost(cost.channels() + 2, FLT_MAX);
-        float lastMin = FLT_MAX;
-
-        for (int d = 0; d < cost.channels(); ++d) {
-            auto curCost = ptrCost[cost.channels() * beginLoc + d];
-            lastMin = min(lastMin, curCost);
-            lastCost[d + 1] = curCost;
-        }
-
-        for (int j = beginLoc + direction; j != endLoc; j += direction) {
-            float curLocMinCost = FLT_MAX;
-
-            for (int d = 0; d < cost.channels(); ++d) {
-                auto lastCurDispCost = lastCost[d + 1];
-                auto lastPreDispCost = lastCost[d] + params_.P1;
-                auto lastAftDispCost = lastCost[d + 2] + params_.P1;
-                auto lastElseDispCost =
-                    lastMin +
-                    max(params_.P2 /
-                            (max(abs(ptrLeft[j] - ptrLeft[j - direction]), 1)),
-                        params_.P1);
-
-                auto curCost = ptrCost[cost.channels() * j + d] +
-                               min(min(lastCurDispCost, lastPreDispCost),
-                                   min(lastAftDispCost, lastElseDispCost)) -
-                               lastMin;
-
-                curLocMinCost = min(curLocMinCost, curCost);
-                ptrAggregationCost[cost.channels() * j + d] = curCost;
-            }
-
-            for (int d = 0; d < cost.channels(); ++d) {
-                lastCost[d + 1] = ptrAggregationCost[cost.channels() * j + d];
+template <typename CostT, typename AggT>
+void MultipathAggregationImpl::horizontalRows(
+    const CostVolume &cost,
+    const path::Penalties<typename CostTraits<AggT>::Work> &penalties,
+    const bool rightToLeft, CostVolume &aggregationCost) {
+    typedef typename CostTraits<AggT>::Work Work;
+    const Work P1 = path::toWork<Work>(params_.P1);
+    const Mat &guide = penalties.guide;
+    const path::UpdatePathFunc<CostT, AggT> updatePath =
+        path::selectUpdatePath<CostT, AggT>();
+
+#pragma omp parallel default(shared)
+    {
+        PathTile<CostT, AggT> line(1, cost.dispRange(), P1, updatePath);
+
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < cost.rows(); ++i) {
+            auto ptrGuide = guide.ptr<uchar>(i);
+
+            for (int way = 0; way < (rightToLeft ? 2 : 1); ++way) {
+                const bool forward = way == 0;
+                const int beginLoc = forward ? 0 : cost.cols() - 1;
+                const int endLoc = forward ? cost.cols() : -1;
+                const int direction = forward ? 1 : -1;
+
+                line.start(0, cost.ptr<CostT>(i, beginLoc),
+                           cost.dispBegin(i, beginLoc),
+                           cost.dispEnd(i, beginLoc),
+                           aggregationCost.ptr<AggT>(i, beginLoc));
+
+                for (int j = beginLoc + direction; j != endLoc;
+                     j += direction) {
+                    line.step(0, cost.ptr<CostT>(i, j), cost.dispBegin(i, j),
+                              cost.dispEnd(i, j),
+                              penalties.table[abs(ptrGuide[j] -
+                                                  ptrGuide[j - direction])],
+                              aggregationCost.ptr<AggT>(i, j));
+                    line.advance();
+                }
             }
-
-            lastMin = curLocMinCost;
         }
     }
 }
 
-void MultipathAggregationImpl::aggregationVertical(const cv::Mat &left,
-                                                   const Mat &cost,
-                                                   Mat &aggregationCost,
-                                                   bool upToBottom) {
-    const int beginLoc = upToBottom ? 0 : cost.rows - 1;
-    const int endLoc = upToBottom ? cost.rows : 0;
-    const int direction = upToBottom ? 1 : -1;
-
-#pragma omp parallel for schedule(dynamic) default(shared)
-    for (int j = 0; j < cost.cols; ++j) {
-        vector<float> lastCost(cost.channels() + 2, FLT_MAX);
-        float lastMin = FLT_MAX;
-        uchar lastPixel = left.ptr<uchar>(beginLoc)[j];
-
-        for (int d = 0; d < cost.channels(); ++d) {
-            auto curCost = cost.ptr<float>(beginLoc)[cost.channels() * j + d];
-            lastCost[d + 1] = curCost;
-
-            if (curCost < lastMin) {
-                lastMin = curCost;
+template <typename CostT, typename AggT>
+void MultipathAggregationImpl::sweepRows(
+    const CostVolume &cost,
+    const path::Penalties<typename CostTraits<AggT>::Work> &penalties,
+    const vector<Point> &directions, CostVolume &aggregationCost) {
+    typedef typename CostTraits<AggT>::Work Work;
+    const Work P1 = path::toWork<Work>(params_.P1);
+    const Mat &guide = penalties.guide;
+    const path::UpdatePathFunc<CostT, AggT> updatePath =
+        path::selectUpdatePath<CostT, AggT>();
+
+    const int rows = cost.rows(), cols = cost.cols();
+    const int directionCount = static_cast<int>(directions.size());
+    const bool down = directions.front().y > 0;
+    // a pixel reads the row of its predecessor while the pixels of the other
+    // columns write the current row, the rows in between are kept too
+    vector<PathRows<CostT, AggT>> paths;
+    paths.reserve(directions.size());
+    for (const Point &direction : directions) {
+        CV_Assert(direction.y != 0 && (direction.y > 0) == down);
+        paths.emplace_back(abs(direction.y) + 1, cols, cost.dispRange(), P1,
+                           updatePath);
+    }
+
+#pragma omp parallel default(shared)
+    for (int step = 0; step < rows; ++step) {
+        const int i = down ? step : rows - 1 - step;
+        auto ptrCurGuide = guide.ptr<uchar>(i);
+
+        // the columns of a row are split into bands, the pixels of a row are
+        // independent of each other, every one writes its own aggregated cost
+#pragma omp for schedule(static)
+        for (int j = 0; j < cols; ++j) {
+            const CostT *ptrCost = cost.ptr<CostT>(i, j);
+            const int dispBegin = cost.dispBegin(i, j);
+            const int dispEnd = cost.dispEnd(i, j);
+            AggT *ptrSum = aggregationCost.ptr<AggT>(i, j);
+
+            for (int k = 0; k < directionCount; ++k) {
+                const int lastI = i - directions[k].y;
+                const int lastJ = j - directions[k].x;
+                if (lastI < 0 || lastI >= rows || lastJ < 0 || lastJ >= cols) {
+                    paths[k].start(i, j, ptrCost, dispBegin, dispEnd, ptrSum);
+                } else {
+                    paths[k].step(
+                        i, j, lastI, lastJ, ptrCost, dispBegin, dispEnd,
+                        penalties.table[abs(ptrCurGuide[j] -
+                                            guide.ptr<uchar>(lastI)[lastJ])],
+                        ptrSum);
+                }
             }
         }
+    }
+}
 
-        for (int i = beginLoc + direction; i != endLoc; i = i + direction) {
-            auto ptrCurCost = cost.ptr<float>(i);
-            auto ptrCurLeft = left.ptr<uchar>(i);
-            auto ptrAggregationCost = aggregationCost.ptr<float>(i);
-            float curLocMinCost = FLT_MAX;
-
-            for (int d = 0; d < cost.channels(); ++d) {
-                auto lastCurDispCost = lastCost[d + 1];
-                auto lastPreDispCost = lastCost[d] + params_.P1;
-                auto lastAftDispCost = lastCost[d + 2] + params_.P1;
-                auto lastElseDispCost =
-                    lastMin +
-                    max(params_.P2 / (max(abs(ptrCurLeft[j] - lastPixel), 1)),
-                        params_.P1);
-
-                auto curCost = ptrCurCost[cost.channels() * j + d] +
-                               min(min(lastCurDispCost, lastPreDispCost),
-                                   min(lastAftDispCost, lastElseDispCost)) -
-                               lastMin;
-
-                curLocMinCost = min(curLocMinCost, curCost);
-                ptrAggregationCost[cost.channels() * j + d] = curCost;
+template <typename CostT, typename AggT>
+void MultipathAggregationImpl::horizontalWinners(
+    const CostVolume &cost,
+    const path::Penalties<typename CostTraits<AggT>::Work> &penalties,
+    const CostVolume &aggregationCost, cv::Mat &dispMap,
+    cv::Mat *confidenceMap, const DispComputeParams &params) {
+    typedef typename CostTraits<AggT>::Work Work;
+    const Work P1 = path::toWork<Work>(params_.P1);
+    const Mat &guide = penalties.guide;
+    const path::UpdatePathFunc<CostT, AggT> updatePath =
+        path::selectUpdatePath<CostT, AggT>();
+    const wta::FindWinnerFunc<AggT> findWinner =
+        wta::selectFindWinner<AggT>();
+
+    const int cols = cost.cols(), dispRange = cost.dispRange();
+    const bool needRight =
+        wta::needRightWinners(params, false, confidenceMap != nullptr);
+
+#pragma omp parallel default(shared)
+    {
+        PathTile<CostT, AggT> line(1, dispRange, P1, updatePath);
+        // sum of all the paths of the current pixel
+        vector<AggT> total(dispRange);
+        vector<wta::Winner> winners(cols);
+        wta::RightWinners<AggT> rightWinners(cols, dispRange);
+
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < cost.rows(); ++i) {
+            auto ptrGuide = guide.ptr<uchar>(i);
+            auto ptrDispMap = dispMap.ptr<float>(i);
+            auto ptrConfidenceMap =
+                confidenceMap != nullptr ? confidenceMap->ptr<float>(i)
+                                         : nullptr;
+            rightWinners.reset();
+
+            for (int j = cols - 1; j >= 0; --j) {
+                const AggT *ptrSum = aggregationCost.ptr<AggT>(i, j);
+                std::copy(ptrSum, ptrSum + dispRange, total.begin());
+                if (j == cols - 1) {
+                    line.start(0, cost.ptr<CostT>(i, j), 0, dispRange,
+                               total.data());
+                } else {
+                    line.step(
+                        0, cost.ptr<CostT>(i, j), 0, dispRange,
+                        penalties.table[abs(ptrGuide[j] - ptrGuide[j + 1])],
+                        total.data());
+                    line.advance();
+                }
+
+                winners[j] = findWinner(total.data(), 0, dispRange);
+                if (needRight) {
+                    rightWinners.add(j, total.data(), 0, dispRange);
+                }
             }
 
-            for (int d = 0; d < cost.channels(); ++d) {
-                lastCost[d + 1] = ptrAggregationCost[cost.channels() * j + d];
+            for (int j = 0; j < cols; ++j) {
+                const int rightBestDisp =
+                    needRight ? rightWinners.match(j, winners[j].disp) : -1;
+                ptrDispMap[j] = wta::pickDisparity(
+                    winners[j], j, rightBestDisp, params,
+                    ptrConfidenceMap != nullptr ? ptrConfidenceMap + j
+                                                : nullptr);
             }
-
-            lastMin = curLocMinCost;
-            lastPixel = ptrCurLeft[j];
         }
     }
 }
 
-void MultipathAggregationImpl::aggregationPostive45(const cv::Mat &left,
-                                                    const Mat &cost,
-                                                    Mat &aggregationCost,
-                                                    bool topRightToBottomLeft) {
-    const int beginLocY = topRightToBottomLeft ? 0 : cost.rows - 1;
-    const int endLocY = topRightToBottomLeft ? cost.rows : 0;
-    const int directionY = topRightToBottomLeft ? 1 : -1;
-    const int beginLocX = topRightToBottomLeft ? cost.cols - 1 : 0;
-    const int endLocX = topRightToBottomLeft ? 0 : cost.cols;
-    const int directionX = topRightToBottomLeft ? -1 : 1;
-
-    // Not directly using '!=' to avoid OpenMP's inability to statically
-    // determine the iteration count.
-#pragma omp parallel for schedule(dynamic) default(shared)
-    for (int indexX = 0; indexX < cost.cols; ++indexX) {
-        int j = beginLocX + indexX * directionX;
-        vector<float> lastCost(cost.channels() + 2, FLT_MAX);
-        float lastMin = FLT_MAX;
-        uchar lastPixel = left.ptr<uchar>(beginLocY)[j];
-
-        for (int d = 0; d < cost.channels(); ++d) {
-            auto curCost = cost.ptr<float>(beginLocY)[cost.channels() * j + d];
-            lastCost[d + 1] = curCost;
-
-            if (curCost < lastMin) {
-                lastMin = curCost;
-            }
-        }
-
-        int curLinej = j + directionX;
+template <typename CostT, typename AggT>
+void MultipathAggregationImpl::sweepDirections(
+    const CostVolume &cost,
+    const path::Penalties<typename CostTraits<AggT>::Work> &penalties,
+    CostVolume &aggregationCost) {
+    vector<Point> directions;
+    if (params_.enableVertiacl) {
+        directions.emplace_back(0, 1);
+    }
 
-        if (curLinej < 0) {
-            curLinej = cost.cols - 1;
-        } else if (curLinej > cost.cols - 1) {
-            curLinej = 0;
-        }
+    // postive 45 from top-right to bottom-left
+    if (params_.enablePostive45) {
+        directions.emplace_back(-1, 1);
+    }
 
-        for (int i = beginLocY + directionY; i != endLocY; i += directionY) {
-            auto ptrCurCost = cost.ptr<float>(i);
-            auto ptrCurLeft = left.ptr<uchar>(i);
-            auto ptrAggregationCost = aggregationCost.ptr<float>(i);
-            float curLocMinCost = FLT_MAX;
-
-            for (int d = 0; d < cost.channels(); ++d) {
-                auto lastCurDispCost = lastCost[d + 1];
-                auto lastPreDispCost = lastCost[d] + params_.P1;
-                auto lastAftDispCost = lastCost[d + 2] + params_.P1;
-                auto lastElseDispCost =
-                    lastMin +
-                    max(params_.P2 /
-                            (max(abs(ptrCurLeft[curLinej] - lastPixel), 1)),
-                        params_.P1);
-
-                auto curCost = ptrCurCost[cost.channels() * curLinej + d] +
-                               min(min(lastCurDispCost, lastPreDispCost),
-                                   min(lastAftDispCost, lastElseDispCost)) -
-                               lastMin;
-
-                curLocMinCost = min(curLocMinCost, curCost);
-                ptrAggregationCost[cost.channels() * curLinej + d] = curCost;
-            }
+    // negtive 45 from top-left to bottom-right
+    if (params_.enableNegtive45) {
+        directions.emplace_back(1, 1);
+    }
 
-            for (int d = 0; d < cost.channels(); ++d) {
-                lastCost[d + 1] =
-                    ptrAggregationCost[cost.channels() * curLinej + d];
-            }
+    if (params_.enableKnightMove) {
+        // one row and two columns or two rows and one column a step, the 22.5
+        // and 67.5 degree lines on both sides of the vertical
+        directions.emplace_back(2, 1);
+        directions.emplace_back(1, 2);
+        directions.emplace_back(-2, 1);
+        directions.emplace_back(-1, 2);
+    }
 
-            lastMin = curLocMinCost;
-            lastPixel = ptrCurLeft[curLinej];
-            curLinej += directionX;
+    if (directions.empty()) {
+        return;
+    }
 
-            if (curLinej < 0) {
-                curLinej = cost.cols - 1;
-            } else if (curLinej > cost.cols - 1) {
-                curLinej = 0;
-            }
-        }
+    // the directions go down in one sweep and back up in another
+    sweepRows<CostT, AggT>(cost, penalties, directions, aggregationCost);
+    for (Point &direction : directions) {
+        direction = Point(-direction.x, -direction.y);
     }
+    sweepRows<CostT, AggT>(cost, penalties, directions, aggregationCost);
 }
 
-void MultipathAggregationImpl::aggregationNegative45(
-    const cv::Mat &left, const Mat &cost, Mat &aggregationCost,
-    bool topLeftToBottomRight) {
-    const int beginLocY = topLeftToBottomRight ? 0 : cost.rows - 1;
-    const int endLocY = topLeftToBottomRight ? cost.rows : 0;
-    const int directionY = topLeftToBottomRight ? 1 : -1;
-    const int beginLocX = topLeftToBottomRight ? 0 : cost.cols - 1;
-    const int endLocX = topLeftToBottomRight ? cost.cols : 0;
-    const int directionX = topLeftToBottomRight ? 1 : -1;
-    
-    // Not directly using '!=' to avoid OpenMP's inability to statically
-    // determine the iteration count.
-#pragma omp parallel for schedule(dynamic) default(shared)
-    for (int indexX = 0; indexX < cost.cols; ++indexX) {
-        int j = beginLocX + indexX * directionX;
-        vector<float> lastCost(cost.channels() + 2, FLT_MAX);
-        float lastMin = FLT_MAX;
-        uchar lastPixel = left.ptr<uchar>(beginLocY)[j];
-
-        for (int d = 0; d < cost.channels(); ++d) {
-            auto curCost = cost.ptr<float>(beginLocY)[cost.channels() * j + d];
-            lastCost[d + 1] = curCost;
-
-            if (curCost < lastMin) {
-                lastMin = curCost;
-            }
-        }
-
-        int curLinej = j + directionX;
-
-        if (curLinej < 0) {
-            curLinej = cost.cols - 1;
-        } else if (curLinej > cost.cols - 1) {
-            curLinej = 0;
-        }
-
-        for (int i = beginLocY + directionY; i < endLocY; i += directionY) {
-            auto ptrCurCost = cost.ptr<float>(i);
-            auto ptrCurLeft = left.ptr<uchar>(i);
-            auto ptrAggregationCost = aggregationCost.ptr<float>(i);
-            float curLocMinCost = FLT_MAX;
-
-            for (int d = 0; d < cost.channels(); ++d) {
-                auto lastCurDispCost = lastCost[d + 1];
-                auto lastPreDispCost = lastCost[d] + params_.P1;
-                auto lastAftDispCost = lastCost[d + 2] + params_.P1;
-                auto lastElseDispCost =
-                    lastMin +
-                    max(params_.P2 /
-                            (max(abs(ptrCurLeft[curLinej] - lastPixel), 1)),
-                        params_.P1);
-
-                auto curCost = ptrCurCost[cost.channels() * curLinej + d] +
-                               min(min(lastCurDispCost, lastPreDispCost),
-                                   min(lastAftDispCost, lastElseDispCost)) -
-                               lastMin;
-
-                curLocMinCost = min(curLocMinCost, curCost);
-                ptrAggregationCost[cost.channels() * curLinej + d] = curCost;
-            }
+template <typename CostT, typename AggT>
+void MultipathAggregationImpl::aggregationImpl(const cv::Mat &left,
+                                               const CostVolume &cost,
+                                               CostVolume &aggregationCost) {
+    // the penalties are looked up by the guide image of the penalty model,
+    // which is the same for all the directions
+    const path::Penalties<typename CostTraits<AggT>::Work> penalties =
+        path::preparePenalties<typename CostTraits<AggT>::Work>(
+            params_.penaltyModel, params_.P1, params_.P2, left);
+
+    aggregationCost.setTo(0);
+    if (params_.enableHonrizon) {
+        horizontalRows<CostT, AggT>(cost, penalties, true, aggregationCost);
+    }
+    sweepDirections<CostT, AggT>(cost, penalties, aggregationCost);
+}
 
-            for (int d = 0; d < cost.channels(); ++d) {
-                lastCost[d + 1] =
-                    ptrAggregationCost[cost.channels() * curLinej + d];
-            }
+template <typename CostT, typename AggT>
+void MultipathAggregationImpl::aggregationDispImpl(
+    const cv::Mat &left, const CostVolume &cost, cv::Mat &dispMap,
+    cv::Mat *confidenceMap, const DispComputeParams &params) {
+    const path::Penalties<typename CostTraits<AggT>::Work> penalties =
+        path::preparePenalties<typename CostTraits<AggT>::Work>(
+            params_.penaltyModel, params_.P1, params_.P2, left);
+
+    // the horizontal paths from right to left are left out, the others are
+    // summed up first
+    CostVolume aggregationCost;
+    aggregationCost.create(cost, cost.depth() == CV_32F ? CV_32F : CV_16U);
+    aggregationCost.setTo(0);
+    if (params_.enableHonrizon) {
+        horizontalRows<CostT, AggT>(cost, penalties, false, aggregationCost);
+    }
+    sweepDirections<CostT, AggT>(cost, penalties, aggregationCost);
 
-            lastPixel = ptrCurLeft[curLinej];
-            lastMin = curLocMinCost;
-            curLinej += directionX;
+    horizontalWinners<CostT, AggT>(cost, penalties, aggregationCost, dispMap,
+                                   confidenceMap, params);
+}
 
-            if (curLinej < 0) {
-                curLinej = cost.cols - 1;
-            } else if (curLinej > cost.cols - 1) {
-                curLinej = 0;
-            }
-        }
+void MultipathAggregationImpl::aggregationPixelMajor(
+    const cv::Mat &left, const CostVolume &cost, CostVolume &aggregationCost) {
+    if (cost.depth() == CV_8U) {
+        aggregationImpl<uint8_t, uint16_t>(left, cost, aggregationCost);
+    } else if (cost.depth() == CV_16U) {
+        aggregationImpl<uint16_t, uint16_t>(left, cost, aggregationCost);
+    } else {
+        aggregationImpl<float, float>(left, cost, aggregationCost);
     }
 }
 
 void MultipathAggregationImpl::aggregation(const cv::Mat &left,
                                            const cv::Mat &cost,
                                            cv::Mat &aggregationCost) {
-    CV_Assert(!cost.empty());
-
-    if(!params_.enableHonrizon && !params_.enableVertiacl && !params_.enableNegtive45 && !params_.enablePostive45) {
-        aggregationCost = cost;
+    CV_Assert_N(!cost.empty(), cost.depth() == CV_8U ||
+                                   cost.depth() == CV_16U ||
+                                   cost.depth() == CV_32F);
+
+    if(!params_.enableHonrizon && !params_.enableVertiacl && !params_.enableNegtive45 && !params_.enablePostive45 && !params_.enableKnightMove) {
+        if (cost.depth() == CV_8U)
+            cost.convertTo(aggregationCost, CV_16U);
+        else
+            aggregationCost = cost;
         return;
     }
-    else {
-        aggregationCost = Mat(cost.size(), cost.type(), Scalar(0.f));
+
+    const int aggregationDepth = cost.depth() == CV_32F ? CV_32F : CV_16U;
+    aggregationCost =
+        Mat(cost.size(), CV_MAKETYPE(aggregationDepth, cost.channels()));
+
+    CostVolume aggregationView(aggregationCost);
+    aggregationPixelMajor(left, CostVolume(cost), aggregationView);
+}
+
+void MultipathAggregationImpl::aggregation(const cv::Mat &left,
+                                           const CostVolume &cost,
+                                           CostVolume &aggregationCost) {
+    CV_Assert_N(!cost.empty(), cost.depth() == CV_8U ||
+                                   cost.depth() == CV_16U ||
+                                   cost.depth() == CV_32F);
+
+    if (!params_.enableHonrizon && !params_.enableVertiacl &&
+        !params_.enableNegtive45 && !params_.enablePostive45 &&
+        !params_.enableKnightMove) {
+        CostAggregation::aggregation(left, cost, aggregationCost);
+        return;
     }
 
-    if (params_.enableHonrizon) {
-        Mat temp = Mat(cost.size(), cost.type(), Scalar(0.f));
-        aggregationHorizontal(left, cost, temp, true);
-        aggregationCost += temp;
-        aggregationHorizontal(left, cost, temp, false);
-        aggregationCost += temp;
+    // the paths run along the disparities of a pixel, which is the
+    // pixel-major or the ragged layout
+    CostVolume pixelMajorCost;
+    if (cost.layout() != CostLayout::DispMajor) {
+        pixelMajorCost = cost;
+    } else {
+        cost.copyTo(pixelMajorCost);
     }
 
-    if (params_.enableVertiacl) {
-        Mat temp = Mat(cost.size(), cost.type(), Scalar(0.f));
-        aggregationVertical(left, cost, temp, true);
-        aggregationCost += temp;
-        aggregationVertical(left, cost, temp, false);
-        aggregationCost += temp;
+    // the path costs keep the geometry of the cost
+    const int aggregationDepth = cost.depth() == CV_32F ? CV_32F : CV_16U;
+    if (aggregationCost.layout() == pixelMajorCost.layout()) {
+        aggregationCost.create(pixelMajorCost, aggregationDepth);
+        aggregationPixelMajor(left, pixelMajorCost, aggregationCost);
+    } else {
+        CostVolume pixelMajorAggregationCost(pixelMajorCost.layout());
+        pixelMajorAggregationCost.create(pixelMajorCost, aggregationDepth);
+        aggregationPixelMajor(left, pixelMajorCost,
+                              pixelMajorAggregationCost);
+        pixelMajorAggregationCost.copyTo(aggregationCost);
     }
+}
 
-    if (params_.enablePostive45) {
-        Mat temp = Mat(cost.size(), cost.type(), Scalar(0.f));
-        aggregationPostive45(left, cost, temp, true);
-        aggregationCost += temp;
-        aggregationPostive45(left, cost, temp, false);
-        aggregationCost += temp;
+void MultipathAggregationImpl::aggregationDisp(
+    const cv::Mat &left, const cv::Mat &cost, cv::Mat &dispMap,
+    cv::Mat *confidenceMap, const DispComputeParams &params) {
+    CV_Assert_N(!cost.empty(), cost.depth() == CV_8U ||
+                                   cost.depth() == CV_16U ||
+                                   cost.depth() == CV_32F,
+                cost.channels() == params.maxDisp - params.minDisp);
+
+    dispMap.create(cost.size(), CV_32FC1);
+    if (confidenceMap != nullptr)
+        confidenceMap->create(cost.size(), CV_32FC1);
+
+    if (!params_.enableHonrizon) {
+        Mat aggregationCost;
+        aggregation(left, cost, aggregationCost);
+        if (confidenceMap != nullptr) {
+            Mat rightDispMap;
+            winnerTakesAll(aggregationCost, dispMap, rightDispMap,
+                           *confidenceMap, params);
+        } else {
+            winnerTakesAll(aggregationCost, dispMap, params);
+        }
+        return;
     }
 
-    if (params_.enableNegtive45) {
-        Mat temp = Mat(cost.size(), cost.type(), Scalar(0.f));
-        aggregationNegative45(left, cost, temp, true);
-        aggregationCost += temp;
-        aggregationNegative45(left, cost, temp, false);
-        aggregationCost += temp;
+    const CostVolume costView(cost);
+    if (cost.depth() == CV_8U) {
+        aggregationDispImpl<uint8_t, uint16_t>(left, costView, dispMap,
+                                               confidenceMap, params);
+    } else if (cost.depth() == CV_16U) {
+        aggregationDispImpl<uint16_t, uint16_t>(left, costView, dispMap,
+                                                confidenceMap, params);
+    } else {
+        aggregationDispImpl<float, float>(left, costView, dispMap,
+                                          confidenceMap, params);
     }
 }
 
+void MultipathAggregationImpl::aggregation(const cv::Mat &left,
+                                           const cv::Mat &cost,
+                                           cv::Mat &dispMap,
+                                           const DispComputeParams params) {
+    aggregationDisp(left, cost, dispMap, nullptr, params);
+}
+
+void MultipathAggregationImpl::aggregation(const cv::Mat &left,
+                                           const cv::Mat &cost,
+                                           cv::Mat &dispMap,
+                                           cv::Mat &confidenceMap,
+                                           const DispComputeParams params) {
+    aggregationDisp(left, cost, dispMap, &confidenceMap, params);
+}
+
 Ptr<CostAggregation> MultipathAggregation::create(const Params params) {
     return Ptr<CostAggregation>(new MultipathAggregationImpl(params));
 }
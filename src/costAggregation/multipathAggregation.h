@@ -13,6 +13,9 @@
 #define __MULTI_PATH_AGGREGATION_H_
 
 #include "costAggregation.h"
+#include "penaltyModel.h"
+
+#include <dispCompute/dispCompute.h>
 
 namespace libSM {
 /**
@@ -26,14 +29,20 @@ class LIBSM_API MultipathAggregation : public CostAggregation {
      *
      */
     struct Params {
-        Params() : enableHonrizon(true), enableVertiacl(true), enableNegtive45(true), enablePostive45(true), P1(10.f), P2(150.f) {}
+        Params() : enableHonrizon(true), enableVertiacl(true), enableNegtive45(true), enablePostive45(true), enableKnightMove(false), P1(10.f), P2(150.f) {}
         bool enableHonrizon;  // enable aggregation on horizontal line
         bool enableVertiacl;  // enable aggregation on vertical line
         bool enablePostive45; // enable aggregation on postive 45 line
         bool enableNegtive45; // enable aggregation on negtive 45 line
+        bool enableKnightMove; // enable aggregation on the 22.5 and 67.5
+                               // degree lines(8 more paths, 16 in total)
         float P1;             // penalty coefficient for disparity continuity
         float P2;             // penalty coefficient for disparity no continuity
+        Ptr<PenaltyModel> penaltyModel; // penalty of disparity changes larger
+                                        // than one pixel, the inverse
+                                        // gradient model of P1 and P2 if empty
     };
+    using CostAggregation::aggregation;
     virtual ~MultipathAggregation() {}
     /**
      * @brief create MultiPathAggregation
@@ -46,12 +55,42 @@ class LIBSM_API MultipathAggregation : public CostAggregation {
      * @brief aggregation cost
      *
      * @param left  left image
-     * @param cost cost space
-     * @param aggregationCost aggregated cost
+     * @param cost cost space(CV_8U, CV_16U or CV_32F)
+     * @param aggregationCost aggregated cost, CV_16U for integer costs and
+     * CV_32F for float costs
      */
     virtual void aggregation(IN const cv::Mat &left,
                              IN const cv::Mat &cost,
                              OUT cv::Mat &aggregationCost) override = 0;
+    /**
+     * @brief aggregation cost and winner-takes-all in one, the horizontal
+     * path from right to left runs last and picks the disparities of a row as
+     * it passes, so that the sum of all the paths is never stored. Without
+     * the horizontal paths the aggregated cost is stored and scanned.
+     *
+     * @param left  left image
+     * @param cost cost space(CV_8U, CV_16U or CV_32F)
+     * @param dispMap disparity map
+     * @param params disparity computation control parameters
+     */
+    virtual void aggregation(IN const cv::Mat &left, IN const cv::Mat &cost,
+                             OUT cv::Mat &dispMap,
+                             IN const DispComputeParams params) = 0;
+    /**
+     * @brief aggregation cost and winner-takes-all in one which gives the
+     * confidence of every disparity as well, taken from the sums the
+     * disparity is picked from
+     *
+     * @param left  left image
+     * @param cost cost space(CV_8U, CV_16U or CV_32F)
+     * @param dispMap disparity map
+     * @param confidenceMap confidence map(CV_32F) of params.confidenceType, 0
+     * where the checks reject the disparity
+     * @param params disparity computation control parameters
+     */
+    virtual void aggregation(IN const cv::Mat &left, IN const cv::Mat &cost,
+                             OUT cv::Mat &dispMap, OUT cv::Mat &confidenceMap,
+                             IN const DispComputeParams params) = 0;
 };
 } // namespace libSM
 
@@ -0,0 +1,550 @@
+#include "pathKernel.h"
+#include "common/cpuFeatures.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#ifdef LIBSM_X86
+#include <immintrin.h>
+#endif
+
+namespace libSM {
+namespace path {
+template <typename CostT, typename AggT>
+static typename CostTraits<AggT>::Work
+updatePathScalar(const CostT *cost, const AggT *last, const int dispBegin,
+                 const int dispEnd, const typename CostTraits<AggT>::Work P1,
+                 const typename CostTraits<AggT>::Work lastMin,
+                 const typename CostTraits<AggT>::Work penalty, AggT *out,
+                 AggT *sum) {
+    typedef typename CostTraits<AggT>::Work Work;
+    const Work lastElseDispCost = lastMin + penalty;
+    Work curMin = CostTraits<AggT>::invalid();
+
+    for (int d = dispBegin; d < dispEnd; ++d) {
+        const Work lastCurDispCost = last[d];
+        const Work lastPreDispCost = last[d - 1] + P1;
+        const Work lastAftDispCost = last[d + 1] + P1;
+
+        const Work curCost = CostTraits<AggT>::saturate(
+            cost[d] +
+            std::min(std::min(lastCurDispCost, lastPreDispCost),
+                     std::min(lastAftDispCost, lastElseDispCost)) -
+            lastMin);
+
+        curMin = std::min(curMin, curCost);
+        out[d] = static_cast<AggT>(curCost);
+        sum[d] =
+            CostTraits<AggT>::saturate(static_cast<Work>(sum[d]) + curCost);
+    }
+
+    return curMin;
+}
+
+/**
+ * @brief average of the two previous pixel terms of MGM, integers are rounded
+ * up as by the vector average instructions
+ *
+ */
+static inline int average(const int a, const int b) {
+    return (a + b + 1) >> 1;
+}
+
+static inline float average(const float a, const float b) {
+    return (a + b) * 0.5f;
+}
+
+template <typename CostT, typename AggT>
+static typename CostTraits<AggT>::Work updatePathPairScalar(
+    const CostT *cost, const AggT *lastA, const AggT *lastB,
+    const int dispBegin, const int dispEnd,
+    const typename CostTraits<AggT>::Work P1,
+    const typename CostTraits<AggT>::Work lastMinA,
+    const typename CostTraits<AggT>::Work lastMinB,
+    const typename CostTraits<AggT>::Work penaltyA,
+    const typename CostTraits<AggT>::Work penaltyB, AggT *out, AggT *sum) {
+    typedef typename CostTraits<AggT>::Work Work;
+    const Work lastElseDispCostA = lastMinA + penaltyA;
+    const Work lastElseDispCostB = lastMinB + penaltyB;
+    Work curMin = CostTraits<AggT>::invalid();
+
+    for (int d = dispBegin; d < dispEnd; ++d) {
+        const Work minCostA =
+            std::min(std::min(static_cast<Work>(lastA[d]), lastA[d - 1] + P1),
+                     std::min(lastA[d + 1] + P1, lastElseDispCostA)) -
+            lastMinA;
+        const Work minCostB =
+            std::min(std::min(static_cast<Work>(lastB[d]), lastB[d - 1] + P1),
+                     std::min(lastB[d + 1] + P1, lastElseDispCostB)) -
+            lastMinB;
+
+        const Work curCost = CostTraits<AggT>::saturate(
+            cost[d] + average(minCostA, minCostB));
+
+        curMin = std::min(curMin, curCost);
+        out[d] = static_cast<AggT>(curCost);
+        sum[d] =
+            CostTraits<AggT>::saturate(static_cast<Work>(sum[d]) + curCost);
+    }
+
+    return curMin;
+}
+
+#ifdef LIBSM_X86
+// The 16-bit kernels rely on last[d] <= 65535 being one of the terms of the
+// minimum: saturating the other terms never changes it, and as lastMin is the
+// minimum of last over the band(the rest is invalid) the minimum minus lastMin
+// is never negative, so the whole step is exact in saturated 16-bit lanes.
+
+/**
+ * @brief eight costs widened to 16 bits
+ *
+ */
+LIBSM_TARGET_SSE42 static inline __m128i loadCostSSE42(const uint8_t *cost) {
+    return _mm_cvtepu8_epi16(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(cost)));
+}
+
+LIBSM_TARGET_SSE42 static inline __m128i loadCostSSE42(const uint16_t *cost) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(cost));
+}
+
+template <typename CostT>
+LIBSM_TARGET_SSE42 static int
+updatePathSSE42(const CostT *cost, const uint16_t *last, const int dispBegin,
+                const int dispEnd, const int P1, const int lastMin,
+                const int penalty, uint16_t *out, uint16_t *sum) {
+    const __m128i p1 = _mm_set1_epi16(static_cast<short>(std::min(P1, 65535)));
+    const __m128i lastMinVal = _mm_set1_epi16(static_cast<short>(lastMin));
+    const __m128i lastElseDispCost = _mm_set1_epi16(
+        static_cast<short>(std::min(lastMin + penalty, 65535)));
+    __m128i curMin = _mm_set1_epi16(-1);
+    int d = dispBegin;
+
+    for (; d + 8 <= dispEnd; d += 8) {
+        const __m128i lastCurDispCost =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(last + d));
+        const __m128i lastPreDispCost = _mm_adds_epu16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(last + d - 1)),
+            p1);
+        const __m128i lastAftDispCost = _mm_adds_epu16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(last + d + 1)),
+            p1);
+        const __m128i minCost =
+            _mm_min_epu16(_mm_min_epu16(lastCurDispCost, lastPreDispCost),
+                          _mm_min_epu16(lastAftDispCost, lastElseDispCost));
+        const __m128i curCost = _mm_adds_epu16(
+            loadCostSSE42(cost + d), _mm_sub_epi16(minCost, lastMinVal));
+
+        curMin = _mm_min_epu16(curMin, curCost);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + d), curCost);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(sum + d),
+            _mm_adds_epu16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(sum + d)),
+                curCost));
+    }
+
+    // the lowest lane of minpos is the minimum of the eight lanes
+    const int vectorMin = _mm_extract_epi16(_mm_minpos_epu16(curMin), 0);
+    return std::min(vectorMin,
+                    updatePathScalar<CostT, uint16_t>(cost, last, d, dispEnd,
+                                                      P1, lastMin, penalty,
+                                                      out, sum));
+}
+
+/**
+ * @brief eight minimal transitions of the previous pixel minus its minimum
+ *
+ */
+LIBSM_TARGET_SSE42 static inline __m128i
+minTransitionSSE42(const uint16_t *last, const __m128i p1,
+                   const __m128i lastMin, const __m128i lastElseDispCost) {
+    const __m128i lastCurDispCost =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(last));
+    const __m128i lastPreDispCost = _mm_adds_epu16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(last - 1)), p1);
+    const __m128i lastAftDispCost = _mm_adds_epu16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(last + 1)), p1);
+    return _mm_sub_epi16(
+        _mm_min_epu16(_mm_min_epu16(lastCurDispCost, lastPreDispCost),
+                      _mm_min_epu16(lastAftDispCost, lastElseDispCost)),
+        lastMin);
+}
+
+template <typename CostT>
+LIBSM_TARGET_SSE42 static int
+updatePathPairSSE42(const CostT *cost, const uint16_t *lastA,
+                    const uint16_t *lastB, const int dispBegin,
+                    const int dispEnd, const int P1, const int lastMinA,
+                    const int lastMinB, const int penaltyA, const int penaltyB,
+                    uint16_t *out, uint16_t *sum) {
+    const __m128i p1 = _mm_set1_epi16(static_cast<short>(std::min(P1, 65535)));
+    const __m128i lastMinValA = _mm_set1_epi16(static_cast<short>(lastMinA));
+    const __m128i lastMinValB = _mm_set1_epi16(static_cast<short>(lastMinB));
+    const __m128i lastElseDispCostA = _mm_set1_epi16(
+        static_cast<short>(std::min(lastMinA + penaltyA, 65535)));
+    const __m128i lastElseDispCostB = _mm_set1_epi16(
+        static_cast<short>(std::min(lastMinB + penaltyB, 65535)));
+    __m128i curMin = _mm_set1_epi16(-1);
+    int d = dispBegin;
+
+    for (; d + 8 <= dispEnd; d += 8) {
+        const __m128i minCostA = minTransitionSSE42(
+            lastA + d, p1, lastMinValA, lastElseDispCostA);
+        const __m128i minCostB = minTransitionSSE42(
+            lastB + d, p1, lastMinValB, lastElseDispCostB);
+        const __m128i curCost = _mm_adds_epu16(
+            loadCostSSE42(cost + d), _mm_avg_epu16(minCostA, minCostB));
+
+        curMin = _mm_min_epu16(curMin, curCost);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + d), curCost);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(sum + d),
+            _mm_adds_epu16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(sum + d)),
+                curCost));
+    }
+
+    const int vectorMin = _mm_extract_epi16(_mm_minpos_epu16(curMin), 0);
+    return std::min(vectorMin, updatePathPairScalar<CostT, uint16_t>(
+                                   cost, lastA, lastB, d, dispEnd, P1,
+                                   lastMinA, lastMinB, penaltyA, penaltyB,
+                                   out, sum));
+}
+
+/**
+ * @brief sixteen costs widened to 16 bits
+ *
+ */
+LIBSM_TARGET_AVX2 static inline __m256i loadCostAVX2(const uint8_t *cost) {
+    return _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(cost)));
+}
+
+LIBSM_TARGET_AVX2 static inline __m256i loadCostAVX2(const uint16_t *cost) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cost));
+}
+
+template <typename CostT>
+LIBSM_TARGET_AVX2 static int
+updatePathAVX2(const CostT *cost, const uint16_t *last, const int dispBegin,
+               const int dispEnd, const int P1, const int lastMin,
+               const int penalty, uint16_t *out, uint16_t *sum) {
+    const __m256i p1 =
+        _mm256_set1_epi16(static_cast<short>(std::min(P1, 65535)));
+    const __m256i lastMinVal = _mm256_set1_epi16(static_cast<short>(lastMin));
+    const __m256i lastElseDispCost = _mm256_set1_epi16(
+        static_cast<short>(std::min(lastMin + penalty, 65535)));
+    __m256i curMin = _mm256_set1_epi16(-1);
+    int d = dispBegin;
+
+    for (; d + 16 <= dispEnd; d += 16) {
+        const __m256i lastCurDispCost =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(last + d));
+        const __m256i lastPreDispCost = _mm256_adds_epu16(
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(last + d - 1)),
+            p1);
+        const __m256i lastAftDispCost = _mm256_adds_epu16(
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(last + d + 1)),
+            p1);
+        const __m256i minCost = _mm256_min_epu16(
+            _mm256_min_epu16(lastCurDispCost, lastPreDispCost),
+            _mm256_min_epu16(lastAftDispCost, lastElseDispCost));
+        const __m256i curCost = _mm256_adds_epu16(
+            loadCostAVX2(cost + d), _mm256_sub_epi16(minCost, lastMinVal));
+
+        curMin = _mm256_min_epu16(curMin, curCost);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + d), curCost);
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(sum + d),
+            _mm256_adds_epu16(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sum + d)),
+                curCost));
+    }
+
+    const int vectorMin = _mm_extract_epi16(
+        _mm_minpos_epu16(_mm_min_epu16(_mm256_castsi256_si128(curMin),
+                                       _mm256_extracti128_si256(curMin, 1))),
+        0);
+    // the tail runs legacy SSE code, which is slowed down by dirty upper
+    // halves of the ymm registers
+    _mm256_zeroupper();
+    return std::min(vectorMin,
+                    updatePathSSE42<CostT>(cost, last, d, dispEnd, P1,
+                                           lastMin, penalty, out, sum));
+}
+
+/**
+ * @brief sixteen minimal transitions of the previous pixel minus its minimum
+ *
+ */
+LIBSM_TARGET_AVX2 static inline __m256i
+minTransitionAVX2(const uint16_t *last, const __m256i p1,
+                  const __m256i lastMin, const __m256i lastElseDispCost) {
+    const __m256i lastCurDispCost =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(last));
+    const __m256i lastPreDispCost = _mm256_adds_epu16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(last - 1)), p1);
+    const __m256i lastAftDispCost = _mm256_adds_epu16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(last + 1)), p1);
+    return _mm256_sub_epi16(
+        _mm256_min_epu16(_mm256_min_epu16(lastCurDispCost, lastPreDispCost),
+                         _mm256_min_epu16(lastAftDispCost, lastElseDispCost)),
+        lastMin);
+}
+
+template <typename CostT>
+LIBSM_TARGET_AVX2 static int
+updatePathPairAVX2(const CostT *cost, const uint16_t *lastA,
+                   const uint16_t *lastB, const int dispBegin,
+                   const int dispEnd, const int P1, const int lastMinA,
+                   const int lastMinB, const int penaltyA, const int penaltyB,
+                   uint16_t *out, uint16_t *sum) {
+    const __m256i p1 =
+        _mm256_set1_epi16(static_cast<short>(std::min(P1, 65535)));
+    const __m256i lastMinValA = _mm256_set1_epi16(static_cast<short>(lastMinA));
+    const __m256i lastMinValB = _mm256_set1_epi16(static_cast<short>(lastMinB));
+    const __m256i lastElseDispCostA = _mm256_set1_epi16(
+        static_cast<short>(std::min(lastMinA + penaltyA, 65535)));
+    const __m256i lastElseDispCostB = _mm256_set1_epi16(
+        static_cast<short>(std::min(lastMinB + penaltyB, 65535)));
+    __m256i curMin = _mm256_set1_epi16(-1);
+    int d = dispBegin;
+
+    for (; d + 16 <= dispEnd; d += 16) {
+        const __m256i minCostA = minTransitionAVX2(
+            lastA + d, p1, lastMinValA, lastElseDispCostA);
+        const __m256i minCostB = minTransitionAVX2(
+            lastB + d, p1, lastMinValB, lastElseDispCostB);
+        const __m256i curCost = _mm256_adds_epu16(
+            loadCostAVX2(cost + d), _mm256_avg_epu16(minCostA, minCostB));
+
+        curMin = _mm256_min_epu16(curMin, curCost);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + d), curCost);
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(sum + d),
+            _mm256_adds_epu16(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sum + d)),
+                curCost));
+    }
+
+    const int vectorMin = _mm_extract_epi16(
+        _mm_minpos_epu16(_mm_min_epu16(_mm256_castsi256_si128(curMin),
+                                       _mm256_extracti128_si256(curMin, 1))),
+        0);
+    _mm256_zeroupper();
+    return std::min(vectorMin,
+                    updatePathPairSSE42<CostT>(cost, lastA, lastB, d, dispEnd,
+                                               P1, lastMinA, lastMinB,
+                                               penaltyA, penaltyB, out, sum));
+}
+
+/**
+ * @brief thirty-two costs widened to 16 bits
+ *
+ */
+LIBSM_TARGET_AVX512 static inline __m512i loadCostAVX512(const uint8_t *cost) {
+    return _mm512_cvtepu8_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cost)));
+}
+
+LIBSM_TARGET_AVX512 static inline __m512i
+loadCostAVX512(const uint16_t *cost) {
+    return _mm512_loadu_si512(cost);
+}
+
+template <typename CostT>
+LIBSM_TARGET_AVX512 static int
+updatePathAVX512(const CostT *cost, const uint16_t *last, const int dispBegin,
+                 const int dispEnd, const int P1, const int lastMin,
+                 const int penalty, uint16_t *out, uint16_t *sum) {
+    const __m512i p1 =
+        _mm512_set1_epi16(static_cast<short>(std::min(P1, 65535)));
+    const __m512i lastMinVal = _mm512_set1_epi16(static_cast<short>(lastMin));
+    const __m512i lastElseDispCost = _mm512_set1_epi16(
+        static_cast<short>(std::min(lastMin + penalty, 65535)));
+    __m512i curMin = _mm512_set1_epi16(-1);
+    int d = dispBegin;
+
+    for (; d + 32 <= dispEnd; d += 32) {
+        const __m512i lastCurDispCost = _mm512_loadu_si512(last + d);
+        const __m512i lastPreDispCost =
+            _mm512_adds_epu16(_mm512_loadu_si512(last + d - 1), p1);
+        const __m512i lastAftDispCost =
+            _mm512_adds_epu16(_mm512_loadu_si512(last + d + 1), p1);
+        const __m512i minCost = _mm512_min_epu16(
+            _mm512_min_epu16(lastCurDispCost, lastPreDispCost),
+            _mm512_min_epu16(lastAftDispCost, lastElseDispCost));
+        const __m512i curCost = _mm512_adds_epu16(
+            loadCostAVX512(cost + d), _mm512_sub_epi16(minCost, lastMinVal));
+
+        curMin = _mm512_min_epu16(curMin, curCost);
+        _mm512_storeu_si512(out + d, curCost);
+        _mm512_storeu_si512(
+            sum + d, _mm512_adds_epu16(_mm512_loadu_si512(sum + d), curCost));
+    }
+
+    const __m256i curMin256 =
+        _mm256_min_epu16(_mm512_castsi512_si256(curMin),
+                         _mm512_extracti64x4_epi64(curMin, 1));
+    const int vectorMin = _mm_extract_epi16(
+        _mm_minpos_epu16(_mm_min_epu16(_mm256_castsi256_si128(curMin256),
+                                       _mm256_extracti128_si256(curMin256, 1))),
+        0);
+    return std::min(vectorMin,
+                    updatePathAVX2<CostT>(cost, last, d, dispEnd, P1, lastMin,
+                                          penalty, out, sum));
+}
+/**
+ * @brief thirty-two minimal transitions of the previous pixel minus its
+ * minimum
+ *
+ */
+LIBSM_TARGET_AVX512 static inline __m512i
+minTransitionAVX512(const uint16_t *last, const __m512i p1,
+                    const __m512i lastMin, const __m512i lastElseDispCost) {
+    const __m512i lastCurDispCost = _mm512_loadu_si512(last);
+    const __m512i lastPreDispCost =
+        _mm512_adds_epu16(_mm512_loadu_si512(last - 1), p1);
+    const __m512i lastAftDispCost =
+        _mm512_adds_epu16(_mm512_loadu_si512(last + 1), p1);
+    return _mm512_sub_epi16(
+        _mm512_min_epu16(_mm512_min_epu16(lastCurDispCost, lastPreDispCost),
+                         _mm512_min_epu16(lastAftDispCost, lastElseDispCost)),
+        lastMin);
+}
+
+template <typename CostT>
+LIBSM_TARGET_AVX512 static int
+updatePathPairAVX512(const CostT *cost, const uint16_t *lastA,
+                     const uint16_t *lastB, const int dispBegin,
+                     const int dispEnd, const int P1, const int lastMinA,
+                     const int lastMinB, const int penaltyA,
+                     const int penaltyB, uint16_t *out, uint16_t *sum) {
+    const __m512i p1 =
+        _mm512_set1_epi16(static_cast<short>(std::min(P1, 65535)));
+    const __m512i lastMinValA = _mm512_set1_epi16(static_cast<short>(lastMinA));
+    const __m512i lastMinValB = _mm512_set1_epi16(static_cast<short>(lastMinB));
+    const __m512i lastElseDispCostA = _mm512_set1_epi16(
+        static_cast<short>(std::min(lastMinA + penaltyA, 65535)));
+    const __m512i lastElseDispCostB = _mm512_set1_epi16(
+        static_cast<short>(std::min(lastMinB + penaltyB, 65535)));
+    __m512i curMin = _mm512_set1_epi16(-1);
+    int d = dispBegin;
+
+    for (; d + 32 <= dispEnd; d += 32) {
+        const __m512i minCostA = minTransitionAVX512(
+            lastA + d, p1, lastMinValA, lastElseDispCostA);
+        const __m512i minCostB = minTransitionAVX512(
+            lastB + d, p1, lastMinValB, lastElseDispCostB);
+        const __m512i curCost = _mm512_adds_epu16(
+            loadCostAVX512(cost + d), _mm512_avg_epu16(minCostA, minCostB));
+
+        curMin = _mm512_min_epu16(curMin, curCost);
+        _mm512_storeu_si512(out + d, curCost);
+        _mm512_storeu_si512(
+            sum + d, _mm512_adds_epu16(_mm512_loadu_si512(sum + d), curCost));
+    }
+
+    const __m256i curMin256 =
+        _mm256_min_epu16(_mm512_castsi512_si256(curMin),
+                         _mm512_extracti64x4_epi64(curMin, 1));
+    const int vectorMin = _mm_extract_epi16(
+        _mm_minpos_epu16(_mm_min_epu16(_mm256_castsi256_si128(curMin256),
+                                       _mm256_extracti128_si256(curMin256, 1))),
+        0);
+    return std::min(vectorMin,
+                    updatePathPairAVX2<CostT>(cost, lastA, lastB, d, dispEnd,
+                                              P1, lastMinA, lastMinB, penaltyA,
+                                              penaltyB, out, sum));
+}
+#endif
+
+/**
+ * @brief path update kernel of the 16-bit path costs for the instruction set
+ * level in use
+ *
+ */
+template <typename CostT>
+static UpdatePathFunc<CostT, uint16_t> selectKernel(uint16_t) {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return updatePathAVX512<CostT>;
+    case SimdLevel::AVX2:
+        return updatePathAVX2<CostT>;
+    case SimdLevel::SSE42:
+        return updatePathSSE42<CostT>;
+    default:
+        break;
+    }
+#endif
+    return updatePathScalar<CostT, uint16_t>;
+}
+
+/**
+ * @brief path update kernel of the float path costs
+ *
+ */
+template <typename CostT>
+static UpdatePathFunc<CostT, float> selectKernel(float) {
+    return updatePathScalar<CostT, float>;
+}
+
+template <typename CostT, typename AggT>
+UpdatePathFunc<CostT, AggT> selectUpdatePath() {
+    return selectKernel<CostT>(AggT());
+}
+
+template UpdatePathFunc<uint8_t, uint16_t>
+selectUpdatePath<uint8_t, uint16_t>();
+template UpdatePathFunc<uint16_t, uint16_t>
+selectUpdatePath<uint16_t, uint16_t>();
+template UpdatePathFunc<float, float> selectUpdatePath<float, float>();
+
+/**
+ * @brief MGM path update kernel of the 16-bit path costs for the instruction
+ * set level in use
+ *
+ */
+template <typename CostT>
+static UpdatePathPairFunc<CostT, uint16_t> selectPairKernel(uint16_t) {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return updatePathPairAVX512<CostT>;
+    case SimdLevel::AVX2:
+        return updatePathPairAVX2<CostT>;
+    case SimdLevel::SSE42:
+        return updatePathPairSSE42<CostT>;
+    default:
+        break;
+    }
+#endif
+    return updatePathPairScalar<CostT, uint16_t>;
+}
+
+/**
+ * @brief MGM path update kernel of the float path costs
+ *
+ */
+template <typename CostT>
+static UpdatePathPairFunc<CostT, float> selectPairKernel(float) {
+    return updatePathPairScalar<CostT, float>;
+}
+
+template <typename CostT, typename AggT>
+UpdatePathPairFunc<CostT, AggT> selectUpdatePathPair() {
+    return selectPairKernel<CostT>(AggT());
+}
+
+template UpdatePathPairFunc<uint8_t, uint16_t>
+selectUpdatePathPair<uint8_t, uint16_t>();
+template UpdatePathPairFunc<uint16_t, uint16_t>
+selectUpdatePathPair<uint16_t, uint16_t>();
+template UpdatePathPairFunc<float, float> selectUpdatePathPair<float, float>();
+} // namespace path
+} // namespace libSM
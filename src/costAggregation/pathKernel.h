@@ -0,0 +1,91 @@
+/**
+ * @file pathKernel.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __PATH_KERNEL_H_
+#define __PATH_KERNEL_H_
+
+#include "common/costTraits.h"
+
+namespace libSM {
+namespace path {
+/**
+ * @brief one step of the path recurrence of SGM for the disparities
+ * [dispBegin, dispEnd) of a pixel:
+ *
+ * out[d] = cost[d] + min(last[d], last[d - 1] + P1, last[d + 1] + P1,
+ *                        lastMin + penalty) - lastMin
+ *
+ * saturated to the range of the aggregated cost type, and adds out[d] to the
+ * aggregated cost sum[d] in the same sweep. last points to the path costs of
+ * the previous pixel on the path, last[d] for d in [-1, dispRange] has to be
+ * readable and the disparities out of its band hold
+ * CostTraits<AggT>::invalid().
+ *
+ * @return the minimum of out over the band, CostTraits<AggT>::invalid() for
+ * an empty band
+ */
+template <typename CostT, typename AggT>
+using UpdatePathFunc = typename CostTraits<AggT>::Work (*)(
+    const CostT *cost, const AggT *last, int dispBegin, int dispEnd,
+    typename CostTraits<AggT>::Work P1, typename CostTraits<AggT>::Work lastMin,
+    typename CostTraits<AggT>::Work penalty, AggT *out, AggT *sum);
+
+/**
+ * @brief path update kernel of the instruction set level in use, the 16-bit
+ * path costs are vectorized with saturating arithmetic
+ *
+ * @tparam CostT cost type(uint8_t, uint16_t or float)
+ * @tparam AggT aggregated cost type(uint16_t for integer costs, float for
+ * float costs)
+ * @return UpdatePathFunc<CostT, AggT> kernel
+ */
+template <typename CostT, typename AggT>
+UpdatePathFunc<CostT, AggT> selectUpdatePath();
+
+/**
+ * @brief one step of the path recurrence of MGM for the disparities
+ * [dispBegin, dispEnd) of a pixel, the recurrence of SGM averaged over two
+ * previous pixels a and b:
+ *
+ * out[d] = cost[d] + (m(lastA)[d] + m(lastB)[d]) / 2
+ * m(last)[d] = min(last[d], last[d - 1] + P1, last[d + 1] + P1,
+ *                  lastMin + penalty) - lastMin
+ *
+ * the average of integer path costs is rounded up, the rest is as
+ * UpdatePathFunc.
+ *
+ * @return the minimum of out over the band, CostTraits<AggT>::invalid() for
+ * an empty band
+ */
+template <typename CostT, typename AggT>
+using UpdatePathPairFunc = typename CostTraits<AggT>::Work (*)(
+    const CostT *cost, const AggT *lastA, const AggT *lastB, int dispBegin,
+    int dispEnd, typename CostTraits<AggT>::Work P1,
+    typename CostTraits<AggT>::Work lastMinA,
+    typename CostTraits<AggT>::Work lastMinB,
+    typename CostTraits<AggT>::Work penaltyA,
+    typename CostTraits<AggT>::Work penaltyB, AggT *out, AggT *sum);
+
+/**
+ * @brief MGM path update kernel of the instruction set level in use, the
+ * 16-bit path costs are vectorized with saturating arithmetic
+ *
+ * @tparam CostT cost type(uint8_t, uint16_t or float)
+ * @tparam AggT aggregated cost type(uint16_t for integer costs, float for
+ * float costs)
+ * @return UpdatePathPairFunc<CostT, AggT> kernel
+ */
+template <typename CostT, typename AggT>
+UpdatePathPairFunc<CostT, AggT> selectUpdatePathPair();
+} // namespace path
+} // namespace libSM
+
+#endif //!__PATH_KERNEL_H_
@@ -0,0 +1,39 @@
+#include "pathPenalty.h"
+
+using namespace cv;
+using namespace std;
+
+namespace libSM {
+namespace path {
+template <typename Work>
+Penalties<Work> preparePenalties(const Ptr<PenaltyModel> &model,
+                                 const float P1, const float P2,
+                                 const cv::Mat &left) {
+    Ptr<PenaltyModel> penaltyModel = model;
+    if (!penaltyModel) {
+        auto params = PenaltyModel::Params();
+        params.P2 = P2;
+        params.minP2 = P1;
+        penaltyModel = PenaltyModel::create(params);
+    }
+
+    Penalties<Work> penalties;
+    penaltyModel->guide(left, penalties.guide);
+    CV_Assert_N(penalties.guide.type() == CV_8UC1,
+                penalties.guide.size() == left.size());
+
+    penalties.table.resize(UCHAR_MAX + 1);
+    for (int diff = 0; diff <= UCHAR_MAX; ++diff) {
+        penalties.table[diff] = toWork<Work>(penaltyModel->penalty(diff));
+    }
+    return penalties;
+}
+
+template Penalties<int> preparePenalties<int>(const Ptr<PenaltyModel> &,
+                                              const float, const float,
+                                              const cv::Mat &);
+template Penalties<float> preparePenalties<float>(const Ptr<PenaltyModel> &,
+                                                  const float, const float,
+                                                  const cv::Mat &);
+} // namespace path
+} // namespace libSM
@@ -0,0 +1,65 @@
+/**
+ * @file pathPenalty.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-22
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __PATH_PENALTY_H_
+#define __PATH_PENALTY_H_
+
+#include "penaltyModel.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <type_traits>
+#include <vector>
+
+namespace libSM {
+namespace path {
+/**
+ * @brief convert a penalty to the arithmetic type of the path costs
+ *
+ * @tparam Work arithmetic type of the path costs
+ * @param penalty penalty
+ * @return Work converted penalty
+ */
+template <typename Work> inline Work toWork(const float penalty) {
+    return std::is_integral<Work>::value ? static_cast<Work>(cvRound(penalty))
+                                         : static_cast<Work>(penalty);
+}
+
+/**
+ * @brief penalties of the paths of an image, the penalty of two adjacent
+ * pixels is table[|guide(p) - guide(q)|]
+ *
+ * @tparam Work arithmetic type of the path costs
+ */
+template <typename Work> struct Penalties {
+    cv::Mat guide;           // guide image(CV_8UC1)
+    std::vector<Work> table; // penalty of every absolute guide difference
+};
+
+/**
+ * @brief guide image and penalty table of a penalty model
+ *
+ * @tparam Work arithmetic type of the path costs
+ * @param model penalty model, the inverse gradient model of P1 and P2 if it
+ * is empty
+ * @param P1 penalty coefficient for disparity continuity
+ * @param P2 penalty coefficient for disparity no continuity
+ * @param left left image(CV_8UC1 or CV_8UC3)
+ * @return Penalties<Work> penalties of the paths
+ */
+template <typename Work>
+Penalties<Work> preparePenalties(const Ptr<PenaltyModel> &model,
+                                 const float P1, const float P2,
+                                 const cv::Mat &left);
+} // namespace path
+} // namespace libSM
+
+#endif //!__PATH_PENALTY_H_
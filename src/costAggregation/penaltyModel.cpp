@@ -0,0 +1,78 @@
+#include "penaltyModel.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace libSM {
+class PenaltyModelImpl : public PenaltyModel {
+  public:
+    PenaltyModelImpl(const Params params) : params_(params){};
+    void guide(const cv::Mat &left, cv::Mat &guide) const override;
+    float penalty(const int guideDiff) const override;
+
+  private:
+    /**
+     * @brief edge map of the left image, 255 on the pixels whose neighbours
+     * differ by edgeThreshold or more in a row or in a column, 0 elsewhere
+     *
+     * @param left left image
+     * @param edgeMap edge map
+     */
+    void edgeMap(const cv::Mat &left, cv::Mat &edgeMap) const;
+    Params params_;
+};
+
+void PenaltyModelImpl::edgeMap(const cv::Mat &left, cv::Mat &edgeMap) const {
+    edgeMap.create(left.size(), CV_8UC1);
+
+#pragma omp parallel for schedule(static) default(shared)
+    for (int i = 0; i < left.rows; ++i) {
+        const uchar *ptrUp = left.ptr<uchar>(max(i - 1, 0));
+        const uchar *ptrCur = left.ptr<uchar>(i);
+        const uchar *ptrDown = left.ptr<uchar>(min(i + 1, left.rows - 1));
+        uchar *ptrEdge = edgeMap.ptr<uchar>(i);
+        for (int j = 0; j < left.cols; ++j) {
+            const int gradX = abs(ptrCur[min(j + 1, left.cols - 1)] -
+                                  ptrCur[max(j - 1, 0)]);
+            const int gradY = abs(ptrDown[j] - ptrUp[j]);
+            ptrEdge[j] =
+                max(gradX, gradY) >= params_.edgeThreshold ? UCHAR_MAX : 0;
+        }
+    }
+}
+
+void PenaltyModelImpl::guide(const cv::Mat &left, cv::Mat &guide) const {
+    CV_Assert_N(!left.empty(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3);
+
+    // the penalties of color images go by their intensities
+    Mat gray = left;
+    if (left.channels() == 3) {
+        cvtColor(left, gray, COLOR_BGR2GRAY);
+    }
+
+    if (params_.type == PenaltyType::EdgeMap) {
+        edgeMap(gray, guide);
+    } else {
+        guide = gray;
+    }
+}
+
+float PenaltyModelImpl::penalty(const int guideDiff) const {
+    switch (params_.type) {
+    case PenaltyType::Constant:
+        return params_.P2;
+    case PenaltyType::EdgeMap:
+        return guideDiff > 0 ? params_.edgeP2 : params_.P2;
+    default:
+        return max(params_.P2 / max(guideDiff, 1), params_.minP2);
+    }
+}
+
+Ptr<PenaltyModel> PenaltyModel::create(const Params params) {
+    return Ptr<PenaltyModel>(new PenaltyModelImpl(params));
+}
+
+} // namespace libSM
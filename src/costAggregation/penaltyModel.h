@@ -0,0 +1,84 @@
+/**
+ * @file penaltyModel.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-22
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __PENALTY_MODEL_H_
+#define __PENALTY_MODEL_H_
+
+#include <typeDef.h>
+
+namespace cv {
+class Mat;
+}
+
+namespace libSM {
+/**
+ * @brief penalty models of the built-in aggregation penalties
+ *
+ */
+enum class PenaltyType {
+    Constant,        // P2 everywhere
+    InverseGradient, // P2 divided by the intensity difference of adjacent
+                     // pixels, never below minP2
+    EdgeMap          // P2, edgeP2 on steps into or out of the edges of the
+                     // left image
+};
+
+/**
+ * @brief penalty P2 of disparity changes larger than one pixel between two
+ * adjacent pixels of a path. A model turns the left image into a guide image,
+ * the penalty of two adjacent pixels only depends on the absolute difference
+ * of their guide values, so that the paths look it up in a table of the 256
+ * differences whatever the model. Derive from it for models of your own.
+ *
+ */
+class LIBSM_API PenaltyModel {
+  public:
+    /**
+     * @brief parameters of the built-in penalty models
+     *
+     */
+    struct Params {
+        Params()
+            : type(PenaltyType::InverseGradient), P2(150.f), minP2(10.f),
+              edgeP2(30.f), edgeThreshold(20) {}
+        PenaltyType type;  // penalty model
+        float P2;          // penalty coefficient for disparity no continuity
+        float minP2;       // lower bound of the inverse gradient penalty
+        float edgeP2;      // penalty across the edges of the edge map
+        int edgeThreshold; // intensity difference of the neighbours of a
+                           // pixel on an edge of the edge map
+    };
+    virtual ~PenaltyModel() {}
+    /**
+     * @brief create a built-in penalty model
+     *
+     * @param params penalty model parameters
+     * @return Ptr<PenaltyModel> PenaltyModel's Ptr
+     */
+    static Ptr<PenaltyModel> create(IN const Params params);
+    /**
+     * @brief guide image the penalties are looked up by
+     *
+     * @param left left image(CV_8UC1 or CV_8UC3)
+     * @param guide guide image(CV_8UC1 of the size of left)
+     */
+    virtual void guide(IN const cv::Mat &left, OUT cv::Mat &guide) const = 0;
+    /**
+     * @brief penalty of two adjacent pixels
+     *
+     * @param guideDiff absolute difference of their guide values in [0, 255]
+     * @return float penalty
+     */
+    virtual float penalty(IN const int guideDiff) const = 0;
+};
+} // namespace libSM
+
+#endif //!__PENALTY_MODEL_H_
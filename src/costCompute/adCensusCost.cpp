@@ -1,12 +1,15 @@
 #include "adCensusCost.h"
-#include "adCost.h"
-#include "censusCost.h"
+#include "adKernel.h"
+#include "censusKernel.h"
+#include "common/costTraits.h"
+#include "common/dispRange.h"
 
 #include <omp.h>
 
 #include <opencv2/opencv.hpp>
 
 using namespace cv;
+using namespace std;
 
 namespace libSM {
 /**
@@ -15,65 +18,202 @@ namespace libSM {
  */
 class ADCensusCostImpl : public ADCensusCost {
   public:
-    ADCensusCostImpl(const Params params) : params_(params) {}
+    ADCensusCostImpl(const Params params)
+        : params_(params),
+          transform_(census::specializedTransform(CensusPattern::Dense,
+                                                  params.windowWidth,
+                                                  params.windowHeight)) {}
     void compute(const Mat &left, const Mat &right, Mat &out) override;
+    void compute(const Mat &left, const Mat &right, CostVolume &out) override;
+    int windowHeight() const override { return params_.windowHeight; }
 
   private:
+    /**
+     * @brief compute the AD and census cost and combine them in one sweep
+     *
+     * @tparam T cost type
+     * @param left rectified left image
+     * @param right rectified right image
+     * @param scale quantization scale of the combined cost
+     * @param out cost volume of any layout
+     */
+    template <typename T>
+    void fusedCost(const Mat &left, const Mat &right, const float scale,
+                   CostVolume &out);
+    /**
+     * @brief combined cost of the cost type into an allocated volume
+     *
+     * @param left rectified left image
+     * @param right rectified right image
+     * @param out cost volume
+     */
+    void adCensusCost(const Mat &left, const Mat &right, CostVolume &out);
+    /**
+     * @brief dense census transform, the specialized kernel of the window if
+     * there is one
+     *
+     * @param img gray image
+     * @param out census image
+     */
+    void censusTransform(const Mat &img, Mat &out) const;
     Params params_;
+    census::TransformFunc transform_;
 };
 
-void ADCensusCostImpl::compute(const Mat &left, const Mat &right, Mat &out) {
-    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size);
-
-    Mat adCost, censusCost;
-
-    {
-        ADCost::Params adParams;
-        adParams.minDisp = params_.minDisp;
-        adParams.maxDisp = params_.maxDisp;
-        adParams.minDisp = params_.minDisp;
-        adParams.maxDisp = params_.maxDisp;
-        auto adCostComputor = ADCost::create(adParams);
-        adCostComputor->compute(left, right, adCost);
+void ADCensusCostImpl::censusTransform(const Mat &img, Mat &out) const {
+    if (transform_) {
+        transform_(img, out);
+    } else {
+        census::transform(img, out, params_.windowWidth, params_.windowHeight);
     }
+}
+
+void ADCensusCostImpl::compute(const Mat &left, const Mat &right, Mat &out) {
+    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size,
+                left.type() == right.type(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3,
+                params_.costType == CV_8U || params_.costType == CV_16U ||
+                    params_.costType == CV_32F);
+
+    const int dispRange = params_.maxDisp - params_.minDisp;
+
+    out.create(left.size(), CV_MAKETYPE(params_.costType, dispRange));
+
+    CostVolume volume(out);
+    adCensusCost(left, right, volume);
+}
 
-    {
-        CensusCost::Params censusParams;
-        censusParams.minDisp = params_.minDisp;
-        censusParams.maxDisp = params_.maxDisp;
-        censusParams.minDisp = params_.minDisp;
-        censusParams.maxDisp = params_.maxDisp;
-        auto censusCostComputor = CensusCost::create(censusParams);
-        censusCostComputor->compute(left, right, censusCost);
+void ADCensusCostImpl::compute(const Mat &left, const Mat &right,
+                               CostVolume &out) {
+    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size,
+                left.type() == right.type(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3,
+                params_.costType == CV_8U || params_.costType == CV_16U ||
+                    params_.costType == CV_32F);
+
+    createVolume(out, left.rows, left.cols, params_.windowWidth,
+                 params_.windowHeight, params_.minDisp,
+                 params_.maxDisp - params_.minDisp, params_.costType);
+
+    adCensusCost(left, right, out);
+}
+
+void ADCensusCostImpl::adCensusCost(const Mat &left, const Mat &right,
+                                    CostVolume &out) {
+    if (params_.costType == CV_8U) {
+        fusedCost<uint8_t>(left, right, ADCENSUS_COST_SCALE_8U, out);
+    } else if (params_.costType == CV_16U) {
+        fusedCost<uint16_t>(left, right, ADCENSUS_COST_SCALE_16U, out);
+    } else {
+        fusedCost<float>(left, right, 1.f, out);
     }
+}
 
+template <typename T>
+void ADCensusCostImpl::fusedCost(const Mat &left, const Mat &right,
+                                 const float scale, CostVolume &out) {
     const int halfWidth = params_.windowWidth / 2;
     const int halfHeight = params_.windowHeight / 2;
     const int dispRange = params_.maxDisp - params_.minDisp;
+    const int words = census::wordCount(
+        CensusPattern::Dense, params_.windowWidth, params_.windowHeight);
+    const T invalid = CostTraits<T>::invalid();
+
+    // both robust terms are functions of integers, the window sum of the
+    // absolute differences(summed over the channels) and the hamming distance
+    const int maxAdSum =
+        255 * left.channels() * params_.windowWidth * params_.windowHeight;
+    vector<double> adTable(maxAdSum + 1);
+    for (int sum = 0; sum <= maxAdSum; ++sum) {
+        adTable[sum] = exp(static_cast<double>(
+            -(static_cast<float>(sum) / left.channels()) / params_.adWeight));
+    }
 
-    if (out.empty())
-        out = Mat(left.size(), CV_32FC(dispRange));
+    vector<double> censusTable(UCHAR_MAX + 1);
+    for (int distance = 0; distance <= UCHAR_MAX; ++distance) {
+        censusTable[distance] = exp(static_cast<double>(
+            -static_cast<float>(distance) / params_.censusWeight));
+    }
 
-#pragma omp parallel for default(shared) schedule(static)
-    for (int i = 0; i < out.rows; ++i) {
-        for (int j = 0; j < out.cols; ++j) {
+    // the maximum of both terms, used where the matched window leaves the
+    // right image
+    const T outsideCost = saturate_cast<T>(2.f * scale);
 
-            if (j < halfWidth || j > out.cols - halfWidth - 1 ||
-                i < halfHeight || i > out.rows - halfHeight - 1) {
-                for (int d = 0; d < dispRange; ++d) {
-                    out.ptr<float>(i)[dispRange * j + d] = FLT_MAX;
+    Mat leftGray, rightGray;
+    if (left.type() == CV_8UC3) {
+        cvtColor(left, leftGray, COLOR_BGR2GRAY);
+        cvtColor(right, rightGray, COLOR_BGR2GRAY);
+    } else {
+        leftGray = left;
+        rightGray = right;
+    }
+
+    Mat leftCensus, rightCensus;
+    censusTransform(leftGray, leftCensus);
+    censusTransform(rightGray, rightCensus);
+
+    for (int i = 0; i < out.rows(); ++i) {
+        if (i < halfHeight || i > out.rows() - halfHeight - 1) {
+            for (int j = 0; j < out.cols(); ++j) {
+                for (int d = out.dispBegin(i, j); d < out.dispEnd(i, j); ++d) {
+                    out.at<T>(i, j, d) = invalid;
                 }
-                continue;
             }
+        }
+    }
+
+    const int validRows = max(out.rows() - 2 * halfHeight, 0);
+    const int bandCount = min(validRows, omp_get_max_threads() * 4);
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+    for (int band = 0; band < bandCount; ++band) {
+        const int beginRow = halfHeight + validRows * band / bandCount;
+        const int endRow = halfHeight + validRows * (band + 1) / bandCount;
+        ad::WindowSum windowSum(left, right, params_.windowWidth,
+                                params_.windowHeight, params_.minDisp,
+                                dispRange);
+        vector<uint8_t> distance(static_cast<size_t>(out.cols()) * dispRange);
+
+        for (int i = beginRow; i < endRow; ++i) {
+            const int *ptrSum = windowSum.row(i);
+            census::costRow(leftCensus.ptr<uint64_t>(i),
+                            rightCensus.ptr<uint64_t>(i), words, out.cols(),
+                            halfWidth, params_.minDisp, dispRange, dispRange,
+                            distance.data());
 
-            for (int d = 0; d < dispRange; ++d) {
-                out.ptr<float>(i)[dispRange * j + d] =
-                    1 -
-                    exp(-adCost.ptr<float>(i)[dispRange * j + d] /
-                        params_.adWeight) +
-                    1 -
-                    exp(-censusCost.ptr<float>(i)[dispRange * j + d] /
-                        params_.censusWeight);
+            for (int j = 0; j < out.cols(); ++j) {
+                const ptrdiff_t dispStep = out.dispStep();
+                auto ptrCost = out.ptr<T>(i, j);
+                const int dispBegin = out.dispBegin(i, j);
+                const int dispEnd = out.dispEnd(i, j);
+
+                if (j < halfWidth || j > out.cols() - halfWidth - 1) {
+                    for (int d = dispBegin; d < dispEnd; ++d) {
+                        ptrCost[d * dispStep] = invalid;
+                    }
+                    continue;
+                }
+
+                int beginDisp, endDisp;
+                validDispRange(j, out.cols(), halfWidth, params_.minDisp,
+                               dispRange, beginDisp, endDisp);
+                beginDisp = min(max(beginDisp, dispBegin), dispEnd);
+                endDisp = min(max(endDisp, beginDisp), dispEnd);
+
+                const int *ptrPixelSum = ptrSum + dispRange * j;
+                const uint8_t *ptrDistance = distance.data() + dispRange * j;
+
+                for (int d = dispBegin; d < beginDisp; ++d) {
+                    ptrCost[d * dispStep] = outsideCost;
+                }
+                for (int d = beginDisp; d < endDisp; ++d) {
+                    ptrCost[d * dispStep] = saturate_cast<T>(
+                        scale * (1 - adTable[ptrPixelSum[d]] + 1 -
+                                 censusTable[ptrDistance[d]]));
+                }
+                for (int d = endDisp; d < dispEnd; ++d) {
+                    ptrCost[d * dispStep] = outsideCost;
+                }
             }
         }
     }
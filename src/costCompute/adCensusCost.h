@@ -16,6 +16,9 @@
 
 #include "costCompute.h"
 
+#define ADCENSUS_COST_SCALE_8U 127.f
+#define ADCENSUS_COST_SCALE_16U 1024.f
+
 namespace libSM {
 /**
  * @brief ADCensus Cost Calculator
@@ -30,14 +33,18 @@ class LIBSM_API ADCensusCost : public CostComputer {
     struct Params {
         Params()
             : windowWidth(9), windowHeight(7), minDisp(0), maxDisp(128),
-              adWeight(10), censusWeight(30) {}
+              adWeight(10), censusWeight(30), costType(CV_32F) {}
         int windowWidth;    // the width of the cost calculation window
         int windowHeight;   // the height of the cost calculation window
         int minDisp;        // minimum disparity value
         int maxDisp;        // maximum disparity value.
         float adWeight;     // weight of ad
         float censusWeight; // weight of census
+        int costType; // element type of the cost space, CV_32F keeps the cost
+                      // in [0, 2], CV_8U and CV_16U store it quantized by
+                      // ADCENSUS_COST_SCALE_8U and ADCENSUS_COST_SCALE_16U
     };
+    using CostComputer::compute;
     virtual ~ADCensusCost() {}
     /**
      * @brief create a cost calculator
@@ -1,10 +1,14 @@
 #include "adCost.h"
+#include "adKernel.h"
+#include "common/costTraits.h"
+#include "common/dispRange.h"
 
 #include <omp.h>
 
 #include <opencv2/opencv.hpp>
 
 using namespace cv;
+using namespace std;
 
 namespace libSM {
 /**
@@ -15,88 +19,126 @@ class ADCostImpl : public ADCost {
   public:
     ADCostImpl(const Params params) : params_(params) {}
     void compute(const Mat &left, const Mat &right, Mat &out) override;
+    void compute(const Mat &left, const Mat &right, CostVolume &out) override;
+    int windowHeight() const override { return params_.windowHeight; }
 
   private:
     /**
-     * @brief clculate the AD cost within the window
+     * @brief calculate the AD cost of all the stored cells
      *
-     * @param leftROI Left image ROI
-     * @param right right image
-     * @param rx right image x-coordinate
-     * @param ry right image y-coordinate
-     * @return float ad cost of the window
+     * @tparam T cost type
+     * @param left rectified left image
+     * @param right rectified right image
+     * @param out cost volume of any layout
      */
-    float getWindowPixelsCost(const Mat &leftROI, const Mat &right,
-                              const int rx, const int ry);
+    template <typename T>
+    void windowCost(const Mat &left, const Mat &right, CostVolume &out);
     Params params_;
 };
 
-float ADCostImpl::getWindowPixelsCost(const Mat &leftROI, const Mat &right,
-                                      const int rx, const int ry) {
+template <typename T>
+void ADCostImpl::windowCost(const Mat &left, const Mat &right,
+                            CostVolume &out) {
+    const int dispRange = params_.maxDisp - params_.minDisp;
     const int halfWidth = params_.windowWidth / 2;
     const int halfHeight = params_.windowHeight / 2;
-
-    float cost = 0.f;
-
-    for (int i = -halfHeight; i <= halfHeight; ++i) {
-        for (int j = -halfWidth; j <= halfWidth; ++j) {
-            if (leftROI.type() == CV_8UC3) {
-                auto leftPixel =
-                    leftROI.ptr<Vec3b>(halfHeight + i)[halfWidth + j];
-                auto rightPixel = right.ptr<Vec3b>(ry + i)[rx + j];
-                cost +=
-                    (abs(static_cast<float>(leftPixel[0]) - rightPixel[0]) +
-                     abs(static_cast<float>(leftPixel[1]) - rightPixel[1]) +
-                     abs(static_cast<float>(leftPixel[2]) - rightPixel[2])) /
-                    3.f;
-            } else {
-                cost += abs(static_cast<float>(leftROI.ptr<uchar>(
-                                halfHeight + i)[halfWidth + j]) -
-                            right.ptr<uchar>(ry + i)[rx + j]);
+    // the window sums are summed over the channels, the cost is their mean.
+    // The sums of windows whose largest sum does not fit below the invalid
+    // cost are scaled down to fit, so that a valid cost is never invalid
+    const T invalid = CostTraits<T>::invalid();
+    const T maxCost = static_cast<T>(invalid - 1);
+    const float maxSum = 255.f * params_.windowWidth * params_.windowHeight;
+    const float scale =
+        min(1.f, static_cast<float>(maxCost) / maxSum) / left.channels();
+
+    for (int i = 0; i < out.rows(); ++i) {
+        if (i < halfHeight || i > out.rows() - halfHeight - 1) {
+            for (int j = 0; j < out.cols(); ++j) {
+                for (int d = out.dispBegin(i, j); d < out.dispEnd(i, j); ++d) {
+                    out.at<T>(i, j, d) = invalid;
+                }
             }
         }
     }
 
-    return cost;
+    // every band of rows slides its own window down, the window sums cover
+    // all the disparities as the column sums are shared by the rows
+    const int validRows = max(out.rows() - 2 * halfHeight, 0);
+    const int bandCount = min(validRows, omp_get_max_threads() * 4);
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+    for (int band = 0; band < bandCount; ++band) {
+        const int beginRow = halfHeight + validRows * band / bandCount;
+        const int endRow = halfHeight + validRows * (band + 1) / bandCount;
+        ad::WindowSum windowSum(left, right, params_.windowWidth,
+                                params_.windowHeight, params_.minDisp,
+                                dispRange);
+
+        for (int i = beginRow; i < endRow; ++i) {
+            const int *ptrSum = windowSum.row(i);
+
+            for (int j = 0; j < out.cols(); ++j) {
+                const ptrdiff_t dispStep = out.dispStep();
+                auto ptrCost = out.ptr<T>(i, j);
+                const int dispBegin = out.dispBegin(i, j);
+                const int dispEnd = out.dispEnd(i, j);
+
+                int beginDisp = dispBegin, endDisp = dispBegin;
+                if (j >= halfWidth && j <= out.cols() - halfWidth - 1) {
+                    validDispRange(j, out.cols(), halfWidth, params_.minDisp,
+                                   dispRange, beginDisp, endDisp);
+                    beginDisp = min(max(beginDisp, dispBegin), dispEnd);
+                    endDisp = min(max(endDisp, beginDisp), dispEnd);
+                }
+
+                for (int d = dispBegin; d < beginDisp; ++d) {
+                    ptrCost[d * dispStep] = invalid;
+                }
+                for (int d = beginDisp; d < endDisp; ++d) {
+                    ptrCost[d * dispStep] = min(
+                        saturate_cast<T>(ptrSum[dispRange * j + d] * scale),
+                        maxCost);
+                }
+                for (int d = endDisp; d < dispEnd; ++d) {
+                    ptrCost[d * dispStep] = invalid;
+                }
+            }
+        }
+    }
 }
 
 void ADCostImpl::compute(const Mat &left, const Mat &right, Mat &out) {
-    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size);
+    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size,
+                left.type() == right.type(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3,
+                params_.costType == CV_16U || params_.costType == CV_32F);
 
     const int dispRange = params_.maxDisp - params_.minDisp;
 
-    if (out.empty())
-        out = Mat(left.size(), CV_32FC(dispRange), Scalar(0.f));
+    out.create(left.size(), CV_MAKETYPE(params_.costType, dispRange));
 
-    const int halfWidth = params_.windowWidth / 2;
-    const int halfHeight = params_.windowHeight / 2;
-
-#pragma omp parallel for default(shared) schedule(static)
-    for (int i = 0; i < out.rows; ++i) {
-        for (int j = 0; j < out.cols; ++j) {
-
-            if (j < halfWidth || j > out.cols - halfWidth - 1 ||
-                i < halfHeight || i > out.rows - halfHeight - 1) {
-                for (int d = 0; d < dispRange; ++d) {
-                    out.ptr<float>(i)[dispRange * j + d] = FLT_MAX;
-                }
-                continue;
-            }
+    CostVolume volume(out);
+    if (params_.costType == CV_16U) {
+        windowCost<uint16_t>(left, right, volume);
+    } else {
+        windowCost<float>(left, right, volume);
+    }
+}
 
-            auto leftROI =
-                left(Rect(j - halfWidth, i - halfHeight, params_.windowWidth,
-                          params_.windowHeight));
+void ADCostImpl::compute(const Mat &left, const Mat &right, CostVolume &out) {
+    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size,
+                left.type() == right.type(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3,
+                params_.costType == CV_16U || params_.costType == CV_32F);
 
-            for (int d = 0; d < dispRange; ++d) {
-                if (j - d < halfWidth || j - d > out.cols - halfWidth) {
-                    out.ptr<float>(i)[dispRange * j + d] = FLT_MAX;
-                    continue;
-                }
+    createVolume(out, left.rows, left.cols, params_.windowWidth,
+                 params_.windowHeight, params_.minDisp,
+                 params_.maxDisp - params_.minDisp, params_.costType);
 
-                out.ptr<float>(i)[dispRange * j + d] =
-                    getWindowPixelsCost(leftROI, right, j - d, i);
-            }
-        }
+    if (params_.costType == CV_16U) {
+        windowCost<uint16_t>(left, right, out);
+    } else {
+        windowCost<float>(left, right, out);
     }
 }
 
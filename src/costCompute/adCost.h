@@ -28,12 +28,19 @@ class LIBSM_API ADCost : public CostComputer {
      *
      */
     struct Params {
-        Params() : windowWidth(9), windowHeight(7), minDisp(0), maxDisp(128) {}
+        Params()
+            : windowWidth(9), windowHeight(7), minDisp(0), maxDisp(128),
+              costType(CV_32F) {}
         int windowWidth;  // the width of the cost calculation window
         int windowHeight; // the height of the cost calculation window
         int minDisp;      // minimum disparity value
         int maxDisp;      // maximum disparity value
+        int costType; // element type of the cost space(CV_16U or CV_32F),
+                      // CV_16U scales the window sums down to fit below the
+                      // invalid cost if 255 * windowWidth * windowHeight
+                      // does not
     };
+    using CostComputer::compute;
     virtual ~ADCost() {}
     /**
      * @brief create a cost calculator
@@ -0,0 +1,96 @@
+#include "adKernel.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+
+namespace libSM {
+namespace ad {
+WindowSum::WindowSum(const Mat &left, const Mat &right, const int windowWidth,
+                     const int windowHeight, const int minDisp,
+                     const int dispRange)
+    : left_(left), right_(right), halfWidth_(windowWidth / 2),
+      halfHeight_(windowHeight / 2), minDisp_(minDisp), dispRange_(dispRange),
+      curRow_(-1), colSum_(static_cast<size_t>(left.cols) * dispRange, 0),
+      rowSum_(static_cast<size_t>(left.cols) * dispRange, 0) {
+    CV_Assert_N(left.type() == right.type(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3);
+
+    accumulate_ = left.type() == CV_8UC3 ? &WindowSum::accumulate<3>
+                                         : &WindowSum::accumulate<1>;
+}
+
+template <int CN> void WindowSum::accumulate(const int y, const int sign) {
+    const uchar *ptrLeft = left_.ptr<uchar>(y);
+    const uchar *ptrRight = right_.ptr<uchar>(y);
+    const int cols = left_.cols;
+
+    for (int x = 0; x < cols; ++x) {
+        int *ptrColSum = colSum_.data() + static_cast<size_t>(dispRange_) * x;
+        const uchar *ptrLeftPixel = ptrLeft + CN * x;
+        // only the disparities whose right pixel lies inside the image
+        const int endDisp = std::min(std::max(x - minDisp_ + 1, 0), dispRange_);
+        const int beginDisp = std::min(std::max(x - minDisp_ - cols + 1, 0),
+                                       endDisp);
+
+        for (int d = beginDisp; d < endDisp; ++d) {
+            const uchar *ptrRightPixel = ptrRight + CN * (x - minDisp_ - d);
+            int diff = 0;
+            for (int c = 0; c < CN; ++c) {
+                diff += std::abs(static_cast<int>(ptrLeftPixel[c]) -
+                                 ptrRightPixel[c]);
+            }
+            ptrColSum[d] += sign * diff;
+        }
+    }
+}
+
+const int *WindowSum::row(const int y) {
+    CV_DbgAssert(y > curRow_);
+
+    if (curRow_ < 0 || y - curRow_ > 2 * halfHeight_) {
+        std::fill(colSum_.begin(), colSum_.end(), 0);
+        for (int k = y - halfHeight_; k <= y + halfHeight_; ++k) {
+            (this->*accumulate_)(k, 1);
+        }
+    } else {
+        for (int k = curRow_; k < y; ++k) {
+            (this->*accumulate_)(k - halfHeight_, -1);
+            (this->*accumulate_)(k + halfHeight_ + 1, 1);
+        }
+    }
+    curRow_ = y;
+
+    const int cols = left_.cols;
+    if (cols < 2 * halfWidth_ + 1) {
+        return rowSum_.data();
+    }
+
+    int *ptrRowSum = rowSum_.data() + static_cast<size_t>(dispRange_) *
+                                          halfWidth_;
+    std::fill(ptrRowSum, ptrRowSum + dispRange_, 0);
+    for (int x = 0; x <= 2 * halfWidth_; ++x) {
+        const int *ptrColSum = colSum_.data() + static_cast<size_t>(dispRange_) *
+                                                    x;
+        for (int d = 0; d < dispRange_; ++d) {
+            ptrRowSum[d] += ptrColSum[d];
+        }
+    }
+
+    for (int x = halfWidth_ + 1; x < cols - halfWidth_; ++x) {
+        const int *ptrEnter =
+            colSum_.data() + static_cast<size_t>(dispRange_) * (x + halfWidth_);
+        const int *ptrLeave = colSum_.data() + static_cast<size_t>(dispRange_) *
+                                                   (x - halfWidth_ - 1);
+        const int *ptrPre = ptrRowSum;
+        ptrRowSum += dispRange_;
+
+        for (int d = 0; d < dispRange_; ++d) {
+            ptrRowSum[d] = ptrPre[d] + ptrEnter[d] - ptrLeave[d];
+        }
+    }
+
+    return rowSum_.data();
+}
+} // namespace ad
+} // namespace libSM
@@ -0,0 +1,82 @@
+/**
+ * @file adKernel.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __AD_KERNEL_H_
+#define __AD_KERNEL_H_
+
+#include <typeDef.h>
+
+#include <vector>
+
+namespace cv {
+class Mat;
+}
+
+namespace libSM {
+namespace ad {
+/**
+ * @brief window sums of the absolute differences for all the disparities of a
+ * row. The window slides down one row at a time: the column sums are updated
+ * with the entering and the leaving row and the row sums are running sums over
+ * the columns, so each row costs O(cols * dispRange) whatever the window size.
+ *
+ */
+class WindowSum {
+  public:
+    /**
+     * @brief construct the window sum of a pair of images
+     *
+     * @param left rectified left image(CV_8UC1 or CV_8UC3)
+     * @param right rectified right image(CV_8UC1 or CV_8UC3)
+     * @param windowWidth the width of the window
+     * @param windowHeight the height of the window
+     * @param minDisp minimum disparity value
+     * @param dispRange disparity range
+     */
+    WindowSum(IN const cv::Mat &left, IN const cv::Mat &right,
+              IN const int windowWidth, IN const int windowHeight,
+              IN const int minDisp, IN const int dispRange);
+    /**
+     * @brief window sums of row y, the rows of one instance have to be
+     * requested in increasing order
+     *
+     * @param y image y-coordinate in [halfHeight, rows - halfHeight - 1]
+     * @return const int* dispRange sums per pixel(summed over the channels),
+     * only the cells whose matched window lies inside the right image and
+     * whose pixel is not on the border are valid
+     */
+    const int *row(IN const int y);
+
+  private:
+    /**
+     * @brief add sign * |left - right| of image row y to the column sums
+     *
+     * @tparam CN number of channels
+     * @param y image y-coordinate
+     * @param sign 1 or -1
+     */
+    template <int CN> void accumulate(const int y, const int sign);
+    typedef void (WindowSum::*AccumulateFunc)(const int y, const int sign);
+    const cv::Mat &left_;
+    const cv::Mat &right_;
+    const int halfWidth_;
+    const int halfHeight_;
+    const int minDisp_;
+    const int dispRange_;
+    int curRow_;
+    AccumulateFunc accumulate_;
+    std::vector<int> colSum_;
+    std::vector<int> rowSum_;
+};
+} // namespace ad
+} // namespace libSM
+
+#endif //!__AD_KERNEL_H_
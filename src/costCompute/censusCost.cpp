@@ -1,4 +1,6 @@
 #include "censusCost.h"
+#include "censusKernel.h"
+#include "common/costTraits.h"
 
 #include <omp.h>
 
@@ -13,118 +15,132 @@ namespace libSM {
  */
 class CensusCostImpl : public CensusCost {
   public:
-    CensusCostImpl(const Params params) : params_(params) {}
+    CensusCostImpl(const Params params)
+        : params_(params),
+          transform_(census::specializedTransform(
+              params.pattern, params.windowWidth, params.windowHeight)) {}
     void compute(const Mat &left, const Mat &right, Mat &out) override;
+    void compute(const Mat &left, const Mat &right, CostVolume &out) override;
+    int windowHeight() const override { return params_.windowHeight; }
 
   private:
     /**
-     * @brief clculate the AD cost within the window
+     * @brief hamming distance of the census images
      *
-     * @param img image
-     * @param x image x-coordinate
-     * @param y image y-coordinate
-     * @return uint64_t census of the window
+     * @tparam T cost type
+     * @param leftCensus left census image
+     * @param rightCensus right census image
+     * @param out cost volume of any layout
      */
-    uint64_t getWindowPixelsCensus(const Mat &img, const int x, const int y);
+    template <typename T>
+    void hammingCost(const Mat &leftCensus, const Mat &rightCensus,
+                     CostVolume &out);
     /**
-     * @brief calculate hamming distance
+     * @brief census transform and hamming distance into an allocated volume
      *
-     * @param lhs left census
-     * @param rhs right census
-     * @return uint64_t
+     * @param left rectified left image
+     * @param right rectified right image
+     * @param out cost volume
      */
-    uint8_t hammingDistance(uint64_t lhs, uint64_t rhs);
+    void censusCost(const Mat &left, const Mat &right, CostVolume &out);
+    /**
+     * @brief census transform, the specialized kernel of the window if there
+     * is one
+     *
+     * @param img gray image
+     * @param out census image
+     */
+    void censusTransform(const Mat &img, Mat &out) const;
     Params params_;
+    census::TransformFunc transform_;
 };
 
-uint64_t CensusCostImpl::getWindowPixelsCensus(const Mat &img, const int x,
-                                               const int y) {
+void CensusCostImpl::censusTransform(const Mat &img, Mat &out) const {
+    if (transform_) {
+        transform_(img, out);
+    } else {
+        census::transform(img, out, params_.windowWidth, params_.windowHeight,
+                          params_.pattern);
+    }
+}
+
+template <typename T>
+void CensusCostImpl::hammingCost(const Mat &leftCensus, const Mat &rightCensus,
+                                 CostVolume &out) {
+    const int dispRange = params_.maxDisp - params_.minDisp;
     const int halfWidth = params_.windowWidth / 2;
     const int halfHeight = params_.windowHeight / 2;
+    const int words = census::wordCount(params_.pattern, params_.windowWidth,
+                                        params_.windowHeight);
 
-    const uchar centerGray = img.ptr<uchar>(y)[x];
-    uint64_t census = 0;
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < out.rows(); ++i) {
+        if (i < halfHeight || i > out.rows() - halfHeight - 1) {
+            for (int j = 0; j < out.cols(); ++j) {
+                for (int d = out.dispBegin(i, j); d < out.dispEnd(i, j); ++d) {
+                    out.at<T>(i, j, d) = CostTraits<T>::invalid();
+                }
+            }
+            continue;
+        }
 
-    for (int i = -halfHeight; i <= halfHeight; ++i) {
-        for (int j = -halfWidth; j <= halfWidth; ++j) {
-            census += (img.ptr<uchar>(y + i)[x + j] > centerGray);
-            if (i != halfHeight || j != halfWidth) {
-                census <<= 1;
+        if (out.layout() != CostLayout::DispMajor) {
+            census::costRow<T>(leftCensus.ptr<uint64_t>(i),
+                               rightCensus.ptr<uint64_t>(i), words, halfWidth,
+                               params_.minDisp, i, out);
+        } else {
+            // a slice per disparity, vectorized across the pixels
+            for (int d = 0; d < dispRange; ++d) {
+                census::costSlice(leftCensus.ptr<uint64_t>(i),
+                                  rightCensus.ptr<uint64_t>(i), words,
+                                  out.cols(), halfWidth, params_.minDisp + d,
+                                  out.ptr<T>(i) + d * out.dispStep());
             }
         }
     }
-
-    return census;
 }
 
-uint8_t CensusCostImpl::hammingDistance(uint64_t lhs, uint64_t rhs) {
-    uint8_t distance = 0;
-    const int itemCount = params_.windowHeight * params_.windowWidth;
-    int iterationCount = 0;
-
-    while (iterationCount++ < itemCount) {
-        distance += (lhs & 0x01) ^ (rhs & 0x01);
-        lhs >>= 1;
-        rhs >>= 1;
+void CensusCostImpl::censusCost(const Mat &left, const Mat &right,
+                                CostVolume &out) {
+    Mat leftCensus, rightCensus;
+    censusTransform(left, leftCensus);
+    censusTransform(right, rightCensus);
+
+    if (params_.costType == CV_8U) {
+        hammingCost<uint8_t>(leftCensus, rightCensus, out);
+    } else if (params_.costType == CV_16U) {
+        hammingCost<uint16_t>(leftCensus, rightCensus, out);
+    } else {
+        hammingCost<float>(leftCensus, rightCensus, out);
     }
-
-    return distance;
 }
 
 void CensusCostImpl::compute(const Mat &left, const Mat &right, Mat &out) {
     CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size,
-                left.type() == CV_8UC1, right.type() == CV_8UC1);
+                left.type() == CV_8UC1, right.type() == CV_8UC1,
+                params_.costType == CV_8U || params_.costType == CV_16U ||
+                    params_.costType == CV_32F);
 
     const int dispRange = params_.maxDisp - params_.minDisp;
 
-    if (out.empty())
-        out = Mat(left.size(), CV_32FC(dispRange), Scalar(0.f));
-
-    Mat leftCensus = Mat(left.size(), CV_8UC(8), Scalar(0));
-    Mat rightCensus = Mat(right.size(), CV_8UC(8), Scalar(0));
-
-    const int halfWidth = params_.windowWidth / 2;
-    const int halfHeight = params_.windowHeight / 2;
-
-#pragma omp parallel for default(shared) schedule(static)
-    for (int i = halfHeight; i < out.rows - halfHeight; ++i) {
-        auto ptrLeftCensus = leftCensus.ptr<uint64_t>(i);
-        auto ptrRightCensus = rightCensus.ptr<uint64_t>(i);
-        for (int j = halfWidth; j < out.cols - halfWidth; ++j) {
-            ptrLeftCensus[j] = getWindowPixelsCensus(left, j, i);
-            ptrRightCensus[j] = getWindowPixelsCensus(right, j, i);
-        }
-    }
-
-#pragma omp parallel for default(shared) schedule(static)
-    for (int i = 0; i < out.rows; ++i) {
-        auto ptrLeftCensus = leftCensus.ptr<uint64_t>(i);
-        auto ptrRightCensus = rightCensus.ptr<uint64_t>(i);
-
-        for (int j = 0; j < out.cols; ++j) {
-
-            if (j < halfWidth || j > out.cols - halfWidth - 1 ||
-                i < halfHeight || i > out.rows - halfHeight - 1) {
-                for (int d = 0; d < dispRange; ++d) {
-                    out.ptr<float>(i)[dispRange * j + d] = FLT_MAX;
-                }
-                continue;
-            }
+    out.create(left.size(), CV_MAKETYPE(params_.costType, dispRange));
 
-            auto leftCensusVal = ptrLeftCensus[j];
+    CostVolume volume(out);
+    censusCost(left, right, volume);
+}
 
-            for (int d = 0; d < dispRange; ++d) {
+void CensusCostImpl::compute(const Mat &left, const Mat &right,
+                             CostVolume &out) {
+    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size,
+                left.type() == CV_8UC1, right.type() == CV_8UC1,
+                params_.costType == CV_8U || params_.costType == CV_16U ||
+                    params_.costType == CV_32F);
 
-                if (j - d < halfWidth || j - d > out.cols - halfWidth) {
-                    out.ptr<float>(i)[dispRange * j + d] = FLT_MAX;
-                    continue;
-                }
+    createVolume(out, left.rows, left.cols, params_.windowWidth,
+                 params_.windowHeight, params_.minDisp,
+                 params_.maxDisp - params_.minDisp, params_.costType);
 
-                out.ptr<float>(i)[dispRange * j + d] =
-                    hammingDistance(leftCensusVal, ptrRightCensus[j - d]);
-            }
-        }
-    }
+    censusCost(left, right, out);
 }
 
 Ptr<CostComputer> CensusCost::create(const Params params) {
@@ -17,6 +17,17 @@
 #include "costCompute.h"
 
 namespace libSM {
+/**
+ * @brief sampling pattern of the census window
+ *
+ */
+enum class CensusPattern {
+    Dense,          // every pixel of the window is compared with the center
+    Sparse,         // checkerboard, every other pixel is compared with the
+                    // center
+    CenterSymmetric // pixels are compared with their mirror about the center
+};
+
 /**
  * @brief Census Cost Calculator
  *
@@ -28,12 +39,20 @@ class LIBSM_API CensusCost : public CostComputer {
      *
      */
     struct Params {
-        Params() : windowWidth(9), windowHeight(7), minDisp(0), maxDisp(128) {}
+        Params()
+            : windowWidth(9), windowHeight(7), minDisp(0), maxDisp(128),
+              costType(CV_32F), pattern(CensusPattern::Dense) {}
         int windowWidth;  // the width of the cost calculation window
         int windowHeight; // the height of the cost calculation window
         int minDisp;      // minimum disparity value
         int maxDisp;      // maximum disparity value.
+        int costType;     // element type of the cost space(CV_8U, CV_16U or
+                          // CV_32F)
+        CensusPattern pattern; // sampling pattern, the descriptor takes
+                               // 64, 128 or 256 bits depending on the number
+                               // of comparisons(at most 255)
     };
+    using CostComputer::compute;
     virtual ~CensusCost() {}
     /**
      * @brief create a cost calculator
@@ -0,0 +1,1046 @@
+#include "censusKernel.h"
+#include "common/costTraits.h"
+#include "common/cpuFeatures.h"
+#include "common/dispRange.h"
+
+#include <omp.h>
+
+#include <opencv2/opencv.hpp>
+
+#ifdef LIBSM_X86
+#include <immintrin.h>
+#endif
+
+using namespace cv;
+
+namespace libSM {
+namespace census {
+/**
+ * @brief a single comparison of the census window, the bit is set if pixel A
+ * is greater than pixel B
+ *
+ */
+struct Comparison {
+    int rowA; // window row of pixel A
+    int colA; // x offset of pixel A
+    int rowB; // window row of pixel B
+    int colB; // x offset of pixel B
+};
+
+/**
+ * @brief comparisons of a sampling pattern in the order they are shifted in
+ *
+ * @param pattern sampling pattern
+ * @param windowWidth the width of the census window
+ * @param windowHeight the height of the census window
+ * @return std::vector<Comparison> comparisons
+ */
+static std::vector<Comparison> comparisons(const CensusPattern pattern,
+                                           const int windowWidth,
+                                           const int windowHeight) {
+    const int halfWidth = windowWidth / 2;
+    const int halfHeight = windowHeight / 2;
+    std::vector<Comparison> list;
+
+    for (int i = 0; i < windowHeight; ++i) {
+        for (int j = -halfWidth; j <= halfWidth; ++j) {
+            switch (pattern) {
+            case CensusPattern::Dense:
+                list.push_back({i, j, halfHeight, 0});
+                break;
+            case CensusPattern::Sparse:
+                if ((i - halfHeight + j) % 2 == 0 &&
+                    (i != halfHeight || j != 0)) {
+                    list.push_back({i, j, halfHeight, 0});
+                }
+                break;
+            case CensusPattern::CenterSymmetric:
+                // only the half before the center, the other half mirrors it
+                if (i < halfHeight || (i == halfHeight && j < 0)) {
+                    list.push_back({i, j, windowHeight - 1 - i, -j});
+                }
+                break;
+            }
+        }
+    }
+
+    return list;
+}
+
+/**
+ * @brief census word of a single pixel, the comparisons are shifted in one
+ * after another so that the first comparison ends in the most significant bit
+ *
+ * @param rows pointers to the rows of the window
+ * @param list comparisons of the word
+ * @param count number of comparisons of the word(at most 64)
+ * @param x image x-coordinate
+ * @return uint64_t census word
+ */
+static inline uint64_t pixelCensus(const uchar *const *rows,
+                                   const Comparison *list, const int count,
+                                   const int x) {
+    uint64_t census = 0;
+
+    for (int c = 0; c < count; ++c) {
+        census = (census << 1) | (rows[list[c].rowA][x + list[c].colA] >
+                                  rows[list[c].rowB][x + list[c].colB]);
+    }
+
+    return census;
+}
+
+/**
+ * @brief portable population count
+ *
+ * @param val value
+ * @return int number of set bits
+ */
+static inline int popcount64(uint64_t val) {
+    val = val - ((val >> 1) & 0x5555555555555555ULL);
+    val = (val & 0x3333333333333333ULL) + ((val >> 2) & 0x3333333333333333ULL);
+    val = (val + (val >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return static_cast<int>((val * 0x0101010101010101ULL) >> 56);
+}
+
+/**
+ * @brief one census word of pixels [x, endX) of one row
+ *
+ */
+typedef void (*TransformRowFunc)(const uchar *const *rows,
+                                 const Comparison *list, int count, int x,
+                                 int endX, uint64_t *out);
+
+/**
+ * @brief hamming cost cost[k] = sum over the words w of
+ * popcount(left[w * stride] ^ right[w * stride - k]), k in [0, n)
+ *
+ */
+template <typename T>
+using HammingSpanFunc = void (*)(const uint64_t *left, const uint64_t *right,
+                                 int words, ptrdiff_t stride, int n, T *cost);
+
+/**
+ * @brief hamming cost of one disparity cost[k] = sum over the words w of
+ * popcount(left[w * stride + k] ^ right[w * stride + k]), k in [0, n)
+ *
+ */
+template <typename T>
+using HammingSliceFunc = void (*)(const uint64_t *left, const uint64_t *right,
+                                  int words, ptrdiff_t stride, int n, T *cost);
+
+static void transformRowScalar(const uchar *const *rows,
+                               const Comparison *list, const int count, int x,
+                               const int endX, uint64_t *out) {
+    for (; x < endX; ++x) {
+        out[x] = pixelCensus(rows, list, count, x);
+    }
+}
+
+template <typename T>
+static void hammingSpanScalar(const uint64_t *left, const uint64_t *right,
+                              const int words, const ptrdiff_t stride,
+                              const int n, T *cost) {
+    for (int k = 0; k < n; ++k) {
+        int count = 0;
+        for (int w = 0; w < words; ++w) {
+            count += popcount64(left[w * stride] ^ right[w * stride - k]);
+        }
+        cost[k] = static_cast<T>(count);
+    }
+}
+
+template <typename T>
+static void hammingSliceScalar(const uint64_t *left, const uint64_t *right,
+                               const int words, const ptrdiff_t stride,
+                               const int n, T *cost) {
+    for (int k = 0; k < n; ++k) {
+        int count = 0;
+        for (int w = 0; w < words; ++w) {
+            count += popcount64(left[w * stride + k] ^ right[w * stride + k]);
+        }
+        cost[k] = static_cast<T>(count);
+    }
+}
+
+#ifdef LIBSM_X86
+/**
+ * @brief shift the comparison mask of 16 pixels into their census words
+ *
+ * @param census census words of the pixels, two per register
+ * @param mask comparison mask, each byte is 0 or -1
+ */
+LIBSM_TARGET_SSE42 static inline void shiftInSSE42(__m128i *census,
+                                                   const __m128i mask) {
+    // census = (census << 1) - mask
+    census[0] = _mm_sub_epi64(_mm_slli_epi64(census[0], 1),
+                              _mm_cvtepi8_epi64(mask));
+    census[1] = _mm_sub_epi64(_mm_slli_epi64(census[1], 1),
+                              _mm_cvtepi8_epi64(_mm_srli_si128(mask, 2)));
+    census[2] = _mm_sub_epi64(_mm_slli_epi64(census[2], 1),
+                              _mm_cvtepi8_epi64(_mm_srli_si128(mask, 4)));
+    census[3] = _mm_sub_epi64(_mm_slli_epi64(census[3], 1),
+                              _mm_cvtepi8_epi64(_mm_srli_si128(mask, 6)));
+    census[4] = _mm_sub_epi64(_mm_slli_epi64(census[4], 1),
+                              _mm_cvtepi8_epi64(_mm_srli_si128(mask, 8)));
+    census[5] = _mm_sub_epi64(_mm_slli_epi64(census[5], 1),
+                              _mm_cvtepi8_epi64(_mm_srli_si128(mask, 10)));
+    census[6] = _mm_sub_epi64(_mm_slli_epi64(census[6], 1),
+                              _mm_cvtepi8_epi64(_mm_srli_si128(mask, 12)));
+    census[7] = _mm_sub_epi64(_mm_slli_epi64(census[7], 1),
+                              _mm_cvtepi8_epi64(_mm_srli_si128(mask, 14)));
+}
+
+LIBSM_TARGET_SSE42 static void
+transformRowSSE42(const uchar *const *rows, const Comparison *list,
+                  const int count, int x, const int endX, uint64_t *out) {
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+
+    for (; x + 16 <= endX; x += 16) {
+        __m128i census[8];
+        for (int g = 0; g < 8; ++g) {
+            census[g] = _mm_setzero_si128();
+        }
+
+        for (int c = 0; c < count; ++c) {
+            // unsigned comparison is performed as signed one after flipping
+            // the sign bit
+            const __m128i pixelA = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+                    rows[list[c].rowA] + x + list[c].colA)),
+                sign);
+            const __m128i pixelB = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+                    rows[list[c].rowB] + x + list[c].colB)),
+                sign);
+            shiftInSSE42(census, _mm_cmpgt_epi8(pixelA, pixelB));
+        }
+
+        for (int g = 0; g < 8; ++g) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x + 2 * g),
+                             census[g]);
+        }
+    }
+
+    transformRowScalar(rows, list, count, x, endX, out);
+}
+
+template <typename T>
+LIBSM_TARGET_SSE42 static void
+hammingSpanSSE42(const uint64_t *left, const uint64_t *right, const int words,
+                 const ptrdiff_t stride, const int n, T *cost) {
+    for (int k = 0; k < n; ++k) {
+        long long count = 0;
+        for (int w = 0; w < words; ++w) {
+            count += _mm_popcnt_u64(left[w * stride] ^ right[w * stride - k]);
+        }
+        cost[k] = static_cast<T>(count);
+    }
+}
+
+template <typename T>
+LIBSM_TARGET_SSE42 static void
+hammingSliceSSE42(const uint64_t *left, const uint64_t *right, const int words,
+                  const ptrdiff_t stride, const int n, T *cost) {
+    for (int k = 0; k < n; ++k) {
+        long long count = 0;
+        for (int w = 0; w < words; ++w) {
+            count +=
+                _mm_popcnt_u64(left[w * stride + k] ^ right[w * stride + k]);
+        }
+        cost[k] = static_cast<T>(count);
+    }
+}
+
+/**
+ * @brief number of set bits of each byte
+ *
+ */
+LIBSM_TARGET_AVX2 static inline __m256i popcountEpi8AVX2(const __m256i val) {
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2,
+                                         3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                         2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(val, lowMask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(val, 4), lowMask);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo),
+                           _mm256_shuffle_epi8(lut, hi));
+}
+
+/**
+ * @brief store eight 32-bit counts
+ *
+ */
+LIBSM_TARGET_AVX2 static inline void storeCountsAVX2(const __m256i count,
+                                                     float *cost) {
+    _mm256_storeu_ps(cost, _mm256_cvtepi32_ps(count));
+}
+
+LIBSM_TARGET_AVX2 static inline void storeCountsAVX2(const __m256i count,
+                                                     uint16_t *cost) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(cost),
+                     _mm_packus_epi32(_mm256_castsi256_si128(count),
+                                      _mm256_extracti128_si256(count, 1)));
+}
+
+LIBSM_TARGET_AVX2 static inline void storeCountsAVX2(const __m256i count,
+                                                     uint8_t *cost) {
+    const __m128i count16 =
+        _mm_packus_epi32(_mm256_castsi256_si128(count),
+                         _mm256_extracti128_si256(count, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(cost),
+                     _mm_packus_epi16(count16, count16));
+}
+
+/**
+ * @brief shift the comparison mask of 32 pixels into their census words
+ *
+ * @param census census words of the pixels, four per register
+ * @param mask comparison mask, each byte is 0 or -1
+ */
+LIBSM_TARGET_AVX2 static inline void shiftInAVX2(__m256i *census,
+                                                 const __m256i mask) {
+    const __m128i lo = _mm256_castsi256_si128(mask);
+    const __m128i hi = _mm256_extracti128_si256(mask, 1);
+    census[0] = _mm256_sub_epi64(_mm256_slli_epi64(census[0], 1),
+                                 _mm256_cvtepi8_epi64(lo));
+    census[1] = _mm256_sub_epi64(_mm256_slli_epi64(census[1], 1),
+                                 _mm256_cvtepi8_epi64(_mm_srli_si128(lo, 4)));
+    census[2] = _mm256_sub_epi64(_mm256_slli_epi64(census[2], 1),
+                                 _mm256_cvtepi8_epi64(_mm_srli_si128(lo, 8)));
+    census[3] = _mm256_sub_epi64(_mm256_slli_epi64(census[3], 1),
+                                 _mm256_cvtepi8_epi64(_mm_srli_si128(lo, 12)));
+    census[4] = _mm256_sub_epi64(_mm256_slli_epi64(census[4], 1),
+                                 _mm256_cvtepi8_epi64(hi));
+    census[5] = _mm256_sub_epi64(_mm256_slli_epi64(census[5], 1),
+                                 _mm256_cvtepi8_epi64(_mm_srli_si128(hi, 4)));
+    census[6] = _mm256_sub_epi64(_mm256_slli_epi64(census[6], 1),
+                                 _mm256_cvtepi8_epi64(_mm_srli_si128(hi, 8)));
+    census[7] = _mm256_sub_epi64(_mm256_slli_epi64(census[7], 1),
+                                 _mm256_cvtepi8_epi64(_mm_srli_si128(hi, 12)));
+}
+
+LIBSM_TARGET_AVX2 static void
+transformRowAVX2(const uchar *const *rows, const Comparison *list,
+                 const int count, int x, const int endX, uint64_t *out) {
+    const __m256i sign = _mm256_set1_epi8(static_cast<char>(0x80));
+
+    for (; x + 32 <= endX; x += 32) {
+        __m256i census[8];
+        for (int g = 0; g < 8; ++g) {
+            census[g] = _mm256_setzero_si256();
+        }
+
+        for (int c = 0; c < count; ++c) {
+            const __m256i pixelA = _mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(
+                    rows[list[c].rowA] + x + list[c].colA)),
+                sign);
+            const __m256i pixelB = _mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(
+                    rows[list[c].rowB] + x + list[c].colB)),
+                sign);
+            shiftInAVX2(census, _mm256_cmpgt_epi8(pixelA, pixelB));
+        }
+
+        for (int g = 0; g < 8; ++g) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x + 4 * g),
+                                census[g]);
+        }
+    }
+
+    transformRowScalar(rows, list, count, x, endX, out);
+}
+
+template <typename T>
+LIBSM_TARGET_AVX2 static void
+hammingSpanAVX2(const uint64_t *left, const uint64_t *right, const int words,
+                const ptrdiff_t stride, const int n, T *cost) {
+    const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    int k = 0;
+
+    for (; k + 8 <= n; k += 8) {
+        // the byte counts of all the words are summed before the horizontal
+        // reduction, at most 4 * 8 per byte
+        __m256i bytes0 = _mm256_setzero_si256();
+        __m256i bytes1 = _mm256_setzero_si256();
+        for (int w = 0; w < words; ++w) {
+            const __m256i leftVal =
+                _mm256_set1_epi64x(static_cast<long long>(left[w * stride]));
+            const uint64_t *rightWord = right + w * stride - k;
+            // right[-3 .. 0] reversed to right[0 .. -3]
+            const __m256i right0 = _mm256_permute4x64_epi64(
+                _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(rightWord - 3)),
+                0x1b);
+            const __m256i right1 = _mm256_permute4x64_epi64(
+                _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(rightWord - 7)),
+                0x1b);
+            bytes0 = _mm256_add_epi8(
+                bytes0, popcountEpi8AVX2(_mm256_xor_si256(leftVal, right0)));
+            bytes1 = _mm256_add_epi8(
+                bytes1, popcountEpi8AVX2(_mm256_xor_si256(leftVal, right1)));
+        }
+        const __m256i count0 = _mm256_sad_epu8(bytes0, _mm256_setzero_si256());
+        const __m256i count1 = _mm256_sad_epu8(bytes1, _mm256_setzero_si256());
+        const __m256i count = _mm256_permutevar8x32_epi32(
+            _mm256_or_si256(count0, _mm256_slli_epi64(count1, 32)), order);
+        storeCountsAVX2(count, cost + k);
+    }
+
+    for (; k < n; ++k) {
+        long long count = 0;
+        for (int w = 0; w < words; ++w) {
+            count += _mm_popcnt_u64(left[w * stride] ^ right[w * stride - k]);
+        }
+        cost[k] = static_cast<T>(count);
+    }
+}
+
+template <typename T>
+LIBSM_TARGET_AVX2 static void
+hammingSliceAVX2(const uint64_t *left, const uint64_t *right, const int words,
+                 const ptrdiff_t stride, const int n, T *cost) {
+    const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    int k = 0;
+
+    for (; k + 8 <= n; k += 8) {
+        __m256i bytes0 = _mm256_setzero_si256();
+        __m256i bytes1 = _mm256_setzero_si256();
+        for (int w = 0; w < words; ++w) {
+            const uint64_t *leftWord = left + w * stride + k;
+            const uint64_t *rightWord = right + w * stride + k;
+            bytes0 = _mm256_add_epi8(
+                bytes0,
+                popcountEpi8AVX2(_mm256_xor_si256(
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(leftWord)),
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(rightWord)))));
+            bytes1 = _mm256_add_epi8(
+                bytes1,
+                popcountEpi8AVX2(_mm256_xor_si256(
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(leftWord + 4)),
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(rightWord + 4)))));
+        }
+        const __m256i count0 = _mm256_sad_epu8(bytes0, _mm256_setzero_si256());
+        const __m256i count1 = _mm256_sad_epu8(bytes1, _mm256_setzero_si256());
+        const __m256i count = _mm256_permutevar8x32_epi32(
+            _mm256_or_si256(count0, _mm256_slli_epi64(count1, 32)), order);
+        storeCountsAVX2(count, cost + k);
+    }
+
+    hammingSliceSSE42(left + k, right + k, words, stride, n - k, cost + k);
+}
+
+/**
+ * @brief number of set bits of each byte
+ *
+ */
+LIBSM_TARGET_AVX512 static inline __m512i
+popcountEpi8AVX512(const __m512i val) {
+    const __m512i lut = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+    const __m512i lowMask = _mm512_set1_epi8(0x0f);
+    const __m512i lo = _mm512_and_si512(val, lowMask);
+    const __m512i hi = _mm512_and_si512(_mm512_srli_epi16(val, 4), lowMask);
+    return _mm512_add_epi8(_mm512_shuffle_epi8(lut, lo),
+                           _mm512_shuffle_epi8(lut, hi));
+}
+
+/**
+ * @brief store eight 64-bit counts
+ *
+ */
+LIBSM_TARGET_AVX512 static inline void storeCountsAVX512(const __m512i count,
+                                                         float *cost) {
+    _mm256_storeu_ps(cost, _mm256_cvtepi32_ps(_mm512_cvtepi64_epi32(count)));
+}
+
+LIBSM_TARGET_AVX512 static inline void storeCountsAVX512(const __m512i count,
+                                                         uint16_t *cost) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(cost),
+                     _mm512_cvtepi64_epi16(count));
+}
+
+LIBSM_TARGET_AVX512 static inline void storeCountsAVX512(const __m512i count,
+                                                         uint8_t *cost) {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(cost),
+                     _mm512_cvtepi64_epi8(count));
+}
+
+/**
+ * @brief shift the comparison mask of 64 pixels into their census words
+ *
+ * @param census census words of the pixels, eight per register
+ * @param mask comparison mask, one bit per pixel
+ */
+LIBSM_TARGET_AVX512 static inline void shiftInAVX512(__m512i *census,
+                                                     const __mmask64 mask) {
+    const __m512i one = _mm512_set1_epi64(1);
+    for (int g = 0; g < 8; ++g) {
+        const __m512i shifted = _mm512_slli_epi64(census[g], 1);
+        census[g] = _mm512_mask_or_epi64(
+            shifted, static_cast<__mmask8>(mask >> (8 * g)), shifted, one);
+    }
+}
+
+LIBSM_TARGET_AVX512 static void
+transformRowAVX512(const uchar *const *rows, const Comparison *list,
+                   const int count, int x, const int endX, uint64_t *out) {
+    for (; x + 64 <= endX; x += 64) {
+        __m512i census[8];
+        for (int g = 0; g < 8; ++g) {
+            census[g] = _mm512_setzero_si512();
+        }
+
+        for (int c = 0; c < count; ++c) {
+            const __m512i pixelA =
+                _mm512_loadu_si512(rows[list[c].rowA] + x + list[c].colA);
+            const __m512i pixelB =
+                _mm512_loadu_si512(rows[list[c].rowB] + x + list[c].colB);
+            shiftInAVX512(census, _mm512_cmpgt_epu8_mask(pixelA, pixelB));
+        }
+
+        for (int g = 0; g < 8; ++g) {
+            _mm512_storeu_si512(out + x + 8 * g, census[g]);
+        }
+    }
+
+    transformRowAVX2(rows, list, count, x, endX, out);
+}
+
+template <typename T>
+LIBSM_TARGET_AVX512 static void
+hammingSpanAVX512(const uint64_t *left, const uint64_t *right, const int words,
+                  const ptrdiff_t stride, const int n, T *cost) {
+    const __m512i reverse = _mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    int k = 0;
+
+    for (; k + 8 <= n; k += 8) {
+        __m512i bytes = _mm512_setzero_si512();
+        for (int w = 0; w < words; ++w) {
+            const __m512i leftVal =
+                _mm512_set1_epi64(static_cast<long long>(left[w * stride]));
+            const __m512i rightVal = _mm512_permutexvar_epi64(
+                reverse, _mm512_loadu_si512(right + w * stride - k - 7));
+            bytes = _mm512_add_epi8(
+                bytes, popcountEpi8AVX512(_mm512_xor_si512(leftVal, rightVal)));
+        }
+        storeCountsAVX512(_mm512_sad_epu8(bytes, _mm512_setzero_si512()),
+                          cost + k);
+    }
+
+    hammingSpanAVX2(left, right - k, words, stride, n - k, cost + k);
+}
+
+template <typename T>
+LIBSM_TARGET_AVX512 static void
+hammingSliceAVX512(const uint64_t *left, const uint64_t *right,
+                   const int words, const ptrdiff_t stride, const int n,
+                   T *cost) {
+    int k = 0;
+
+    for (; k + 8 <= n; k += 8) {
+        __m512i bytes = _mm512_setzero_si512();
+        for (int w = 0; w < words; ++w) {
+            bytes = _mm512_add_epi8(
+                bytes, popcountEpi8AVX512(_mm512_xor_si512(
+                           _mm512_loadu_si512(left + w * stride + k),
+                           _mm512_loadu_si512(right + w * stride + k))));
+        }
+        storeCountsAVX512(_mm512_sad_epu8(bytes, _mm512_setzero_si512()),
+                          cost + k);
+    }
+
+    hammingSliceAVX2(left + k, right + k, words, stride, n - k, cost + k);
+}
+#endif
+
+
+/**
+ * @brief all the census words of pixels [x, endX) of one row of a dense
+ * window known at compile time. The center is loaded once per pixel and the
+ * window is walked row by row with constant offsets, word w of pixel x is
+ * stored at out[w * wordStride + x]
+ *
+ */
+typedef void (*DenseRowFunc)(const uchar *const *rows, int x, int endX,
+                             ptrdiff_t wordStride, uint64_t *out);
+
+/**
+ * @brief number of words of a dense census window known at compile time
+ *
+ * @tparam W the width of the census window
+ * @tparam H the height of the census window
+ */
+template <int W, int H> struct DenseWindow {
+    static_assert(W % 2 == 1 && H % 2 == 1 && W * H <= 128,
+                  "dense windows of one or two words");
+    static constexpr int words = (W * H + 63) / 64;
+};
+
+template <int W, int H>
+static void denseRowScalar(const uchar *const *rows, int x, const int endX,
+                           const ptrdiff_t wordStride, uint64_t *out) {
+    for (; x < endX; ++x) {
+        const uchar center = rows[H / 2][x];
+        uint64_t census = 0;
+        int c = 0;
+
+        for (int r = 0; r < H; ++r) {
+            const uchar *row = rows[r] + x - W / 2;
+            for (int k = 0; k < W; ++k) {
+                census = (census << 1) | (row[k] > center);
+                // a word is complete after every 64 comparisons
+                if (++c % 64 == 0) {
+                    out[(c / 64 - 1) * wordStride + x] = census;
+                    census = 0;
+                }
+            }
+        }
+
+        if (c % 64 != 0) {
+            out[c / 64 * wordStride + x] = census;
+        }
+    }
+}
+
+#ifdef LIBSM_X86
+/**
+ * @brief store the census words of 16 pixels and clear them for the next word
+ *
+ */
+LIBSM_TARGET_SSE42 static inline void storeCensusSSE42(__m128i *census,
+                                                       uint64_t *out) {
+    for (int g = 0; g < 8; ++g) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * g), census[g]);
+        census[g] = _mm_setzero_si128();
+    }
+}
+
+template <int W, int H>
+LIBSM_TARGET_SSE42 static void
+denseRowSSE42(const uchar *const *rows, int x, const int endX,
+              const ptrdiff_t wordStride, uint64_t *out) {
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+
+    for (; x + 16 <= endX; x += 16) {
+        const __m128i center = _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[H / 2] + x)),
+            sign);
+        __m128i census[8];
+        for (int g = 0; g < 8; ++g) {
+            census[g] = _mm_setzero_si128();
+        }
+        int c = 0;
+
+        for (int r = 0; r < H; ++r) {
+            const uchar *row = rows[r] + x - W / 2;
+            for (int k = 0; k < W; ++k) {
+                const __m128i pixel = _mm_xor_si128(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + k)),
+                    sign);
+                shiftInSSE42(census, _mm_cmpgt_epi8(pixel, center));
+                if (++c % 64 == 0) {
+                    storeCensusSSE42(census,
+                                     out + (c / 64 - 1) * wordStride + x);
+                }
+            }
+        }
+
+        if (c % 64 != 0) {
+            storeCensusSSE42(census, out + c / 64 * wordStride + x);
+        }
+    }
+
+    denseRowScalar<W, H>(rows, x, endX, wordStride, out);
+}
+
+/**
+ * @brief store the census words of 32 pixels and clear them for the next word
+ *
+ */
+LIBSM_TARGET_AVX2 static inline void storeCensusAVX2(__m256i *census,
+                                                     uint64_t *out) {
+    for (int g = 0; g < 8; ++g) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 4 * g),
+                            census[g]);
+        census[g] = _mm256_setzero_si256();
+    }
+}
+
+template <int W, int H>
+LIBSM_TARGET_AVX2 static void
+denseRowAVX2(const uchar *const *rows, int x, const int endX,
+             const ptrdiff_t wordStride, uint64_t *out) {
+    const __m256i sign = _mm256_set1_epi8(static_cast<char>(0x80));
+
+    for (; x + 32 <= endX; x += 32) {
+        const __m256i center = _mm256_xor_si256(
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(rows[H / 2] + x)),
+            sign);
+        __m256i census[8];
+        for (int g = 0; g < 8; ++g) {
+            census[g] = _mm256_setzero_si256();
+        }
+        int c = 0;
+
+        for (int r = 0; r < H; ++r) {
+            const uchar *row = rows[r] + x - W / 2;
+            for (int k = 0; k < W; ++k) {
+                const __m256i pixel = _mm256_xor_si256(
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(row + k)),
+                    sign);
+                shiftInAVX2(census, _mm256_cmpgt_epi8(pixel, center));
+                if (++c % 64 == 0) {
+                    storeCensusAVX2(census,
+                                    out + (c / 64 - 1) * wordStride + x);
+                }
+            }
+        }
+
+        if (c % 64 != 0) {
+            storeCensusAVX2(census, out + c / 64 * wordStride + x);
+        }
+    }
+
+    denseRowSSE42<W, H>(rows, x, endX, wordStride, out);
+}
+
+/**
+ * @brief store the census words of 64 pixels and clear them for the next word
+ *
+ */
+LIBSM_TARGET_AVX512 static inline void storeCensusAVX512(__m512i *census,
+                                                         uint64_t *out) {
+    for (int g = 0; g < 8; ++g) {
+        _mm512_storeu_si512(out + 8 * g, census[g]);
+        census[g] = _mm512_setzero_si512();
+    }
+}
+
+template <int W, int H>
+LIBSM_TARGET_AVX512 static void
+denseRowAVX512(const uchar *const *rows, int x, const int endX,
+               const ptrdiff_t wordStride, uint64_t *out) {
+    for (; x + 64 <= endX; x += 64) {
+        const __m512i center = _mm512_loadu_si512(rows[H / 2] + x);
+        __m512i census[8];
+        for (int g = 0; g < 8; ++g) {
+            census[g] = _mm512_setzero_si512();
+        }
+        int c = 0;
+
+        for (int r = 0; r < H; ++r) {
+            const uchar *row = rows[r] + x - W / 2;
+            for (int k = 0; k < W; ++k) {
+                shiftInAVX512(census, _mm512_cmpgt_epu8_mask(
+                                          _mm512_loadu_si512(row + k), center));
+                if (++c % 64 == 0) {
+                    storeCensusAVX512(census,
+                                      out + (c / 64 - 1) * wordStride + x);
+                }
+            }
+        }
+
+        if (c % 64 != 0) {
+            storeCensusAVX512(census, out + c / 64 * wordStride + x);
+        }
+    }
+
+    denseRowAVX2<W, H>(rows, x, endX, wordStride, out);
+}
+#endif
+
+/**
+ * @brief row transform kernel of the instruction set level in use
+ *
+ * @return TransformRowFunc kernel
+ */
+static TransformRowFunc selectTransformRow() {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return transformRowAVX512;
+    case SimdLevel::AVX2:
+        return transformRowAVX2;
+    case SimdLevel::SSE42:
+        return transformRowSSE42;
+    default:
+        break;
+    }
+#endif
+    return transformRowScalar;
+}
+
+/**
+ * @brief dense row kernel of the window for the instruction set level in use
+ *
+ * @return DenseRowFunc kernel
+ */
+template <int W, int H> static DenseRowFunc selectDenseRow() {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return denseRowAVX512<W, H>;
+    case SimdLevel::AVX2:
+        return denseRowAVX2<W, H>;
+    case SimdLevel::SSE42:
+        return denseRowSSE42<W, H>;
+    default:
+        break;
+    }
+#endif
+    return denseRowScalar<W, H>;
+}
+
+/**
+ * @brief hamming kernel of the instruction set level in use
+ *
+ * @return HammingSpanFunc kernel
+ */
+template <typename T> static HammingSpanFunc<T> selectHammingSpan() {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return hammingSpanAVX512<T>;
+    case SimdLevel::AVX2:
+        return hammingSpanAVX2<T>;
+    case SimdLevel::SSE42:
+        return hammingSpanSSE42<T>;
+    default:
+        break;
+    }
+#endif
+    return hammingSpanScalar<T>;
+}
+
+/**
+ * @brief hamming slice kernel of the instruction set level in use
+ *
+ * @return HammingSliceFunc kernel
+ */
+template <typename T> static HammingSliceFunc<T> selectHammingSlice() {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return hammingSliceAVX512<T>;
+    case SimdLevel::AVX2:
+        return hammingSliceAVX2<T>;
+    case SimdLevel::SSE42:
+        return hammingSliceSSE42<T>;
+    default:
+        break;
+    }
+#endif
+    return hammingSliceScalar<T>;
+}
+
+int comparisonCount(const CensusPattern pattern, const int windowWidth,
+                    const int windowHeight) {
+    const int area = windowWidth * windowHeight;
+    switch (pattern) {
+    case CensusPattern::Sparse:
+        return (area + 1) / 2 - 1;
+    case CensusPattern::CenterSymmetric:
+        return area / 2;
+    default:
+        return area;
+    }
+}
+
+int wordCount(const CensusPattern pattern, const int windowWidth,
+              const int windowHeight) {
+    const int count = comparisonCount(pattern, windowWidth, windowHeight);
+    return count <= 64 ? 1 : (count <= 128 ? 2 : 4);
+}
+
+void transform(const Mat &img, Mat &out, const int windowWidth,
+               const int windowHeight, const CensusPattern pattern) {
+    const std::vector<Comparison> list =
+        comparisons(pattern, windowWidth, windowHeight);
+    const int count = static_cast<int>(list.size());
+    CV_Assert_N(!img.empty(), img.type() == CV_8UC1, windowWidth % 2 == 1,
+                windowHeight % 2 == 1, count > 0, count <= 255,
+                count == comparisonCount(pattern, windowWidth, windowHeight));
+
+    const int words = wordCount(pattern, windowWidth, windowHeight);
+    out.create(img.rows, img.cols * words, CV_8UC(8));
+    out.setTo(Scalar::all(0));
+
+    const int halfWidth = windowWidth / 2;
+    const int halfHeight = windowHeight / 2;
+    const TransformRowFunc transformRow = selectTransformRow();
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = halfHeight; i < img.rows - halfHeight; ++i) {
+        std::vector<const uchar *> rows(windowHeight);
+        for (int k = 0; k < windowHeight; ++k) {
+            rows[k] = img.ptr<uchar>(i - halfHeight + k);
+        }
+
+        uint64_t *ptrOut = out.ptr<uint64_t>(i);
+        for (int w = 0; w < words; ++w) {
+            const int begin = 64 * w;
+            transformRow(rows.data(), list.data() + begin,
+                         std::min(count - begin, 64), halfWidth,
+                         img.cols - halfWidth,
+                         ptrOut + static_cast<ptrdiff_t>(w) * img.cols);
+        }
+    }
+}
+
+/**
+ * @brief census transform of a dense window known at compile time, same
+ * output as transform()
+ *
+ * @tparam W the width of the census window
+ * @tparam H the height of the census window
+ * @param img gray image
+ * @param out census image
+ */
+template <int W, int H> static void denseTransform(const Mat &img, Mat &out) {
+    CV_Assert_N(!img.empty(), img.type() == CV_8UC1);
+
+    out.create(img.rows, img.cols * DenseWindow<W, H>::words, CV_8UC(8));
+    out.setTo(Scalar::all(0));
+
+    const DenseRowFunc denseRow = selectDenseRow<W, H>();
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = H / 2; i < img.rows - H / 2; ++i) {
+        const uchar *rows[H];
+        for (int k = 0; k < H; ++k) {
+            rows[k] = img.ptr<uchar>(i - H / 2 + k);
+        }
+
+        denseRow(rows, W / 2, img.cols - W / 2, img.cols,
+                 out.ptr<uint64_t>(i));
+    }
+}
+
+TransformFunc specializedTransform(const CensusPattern pattern,
+                                   const int windowWidth,
+                                   const int windowHeight) {
+    if (pattern != CensusPattern::Dense) {
+        return nullptr;
+    }
+
+    if (windowWidth == 5 && windowHeight == 5) {
+        return denseTransform<5, 5>;
+    } else if (windowWidth == 7 && windowHeight == 7) {
+        return denseTransform<7, 7>;
+    } else if (windowWidth == 9 && windowHeight == 7) {
+        return denseTransform<9, 7>;
+    } else if (windowWidth == 11 && windowHeight == 11) {
+        return denseTransform<11, 11>;
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief hamming distance cost of the disparities [dispBegin, dispEnd) of one
+ * pixel, the cells whose windows exceed the image are invalid
+ *
+ * @param cost cost of the pixel(cell d at cost[d])
+ */
+template <typename T>
+static inline void costPixel(const HammingSpanFunc<T> hammingSpan,
+                             const uint64_t *leftCensus,
+                             const uint64_t *rightCensus, const int words,
+                             const int cols, const int halfWidth,
+                             const int minDisp, const int dispRange,
+                             const int j, const int dispBegin,
+                             const int dispEnd, T *cost) {
+    const T invalid = CostTraits<T>::invalid();
+
+    if (j < halfWidth || j > cols - halfWidth - 1) {
+        std::fill(cost + dispBegin, cost + dispEnd, invalid);
+        return;
+    }
+
+    int beginDisp, endDisp;
+    validDispRange(j, cols, halfWidth, minDisp, dispRange, beginDisp, endDisp);
+    beginDisp = std::min(std::max(beginDisp, dispBegin), dispEnd);
+    endDisp = std::min(std::max(endDisp, beginDisp), dispEnd);
+
+    std::fill(cost + dispBegin, cost + beginDisp, invalid);
+    hammingSpan(leftCensus + j, rightCensus + j - minDisp - beginDisp, words,
+                cols, endDisp - beginDisp, cost + beginDisp);
+    std::fill(cost + endDisp, cost + dispEnd, invalid);
+}
+
+template <typename T>
+void costRow(const uint64_t *leftCensus, const uint64_t *rightCensus,
+             const int words, const int cols, const int halfWidth,
+             const int minDisp, const int dispRange, const ptrdiff_t pixelStep,
+             T *cost) {
+    const HammingSpanFunc<T> hammingSpan = selectHammingSpan<T>();
+
+    for (int j = 0; j < cols; ++j) {
+        costPixel(hammingSpan, leftCensus, rightCensus, words, cols,
+                  halfWidth, minDisp, dispRange, j, 0, dispRange,
+                  cost + pixelStep * j);
+    }
+}
+
+template <typename T>
+void costRow(const uint64_t *leftCensus, const uint64_t *rightCensus,
+             const int words, const int halfWidth, const int minDisp,
+             const int i, CostVolume &cost) {
+    const HammingSpanFunc<T> hammingSpan = selectHammingSpan<T>();
+
+    for (int j = 0; j < cost.cols(); ++j) {
+        costPixel(hammingSpan, leftCensus, rightCensus, words, cost.cols(),
+                  halfWidth, minDisp, cost.dispRange(), j,
+                  cost.dispBegin(i, j), cost.dispEnd(i, j),
+                  cost.ptr<T>(i, j));
+    }
+}
+
+template <typename T>
+void costSlice(const uint64_t *leftCensus, const uint64_t *rightCensus,
+               const int words, const int cols, const int halfWidth,
+               const int disp, T *cost) {
+    const HammingSliceFunc<T> hammingSlice = selectHammingSlice<T>();
+    const T invalid = CostTraits<T>::invalid();
+
+    // both the left pixel j and the right pixel j - disp keep the window
+    // inside the image
+    const int beginX = std::min(std::max(halfWidth, halfWidth + disp), cols);
+    const int endX =
+        std::max(std::min(cols - halfWidth, cols - halfWidth + disp), beginX);
+
+    std::fill(cost, cost + beginX, invalid);
+    hammingSlice(leftCensus + beginX, rightCensus + beginX - disp, words, cols,
+                 endX - beginX, cost + beginX);
+    std::fill(cost + endX, cost + cols, invalid);
+}
+
+template void costRow<uint8_t>(const uint64_t *, const uint64_t *, int, int,
+                               int, int, int, ptrdiff_t, uint8_t *);
+template void costRow<uint16_t>(const uint64_t *, const uint64_t *, int, int,
+                                int, int, int, ptrdiff_t, uint16_t *);
+template void costRow<float>(const uint64_t *, const uint64_t *, int, int, int,
+                             int, int, ptrdiff_t, float *);
+template void costRow<uint8_t>(const uint64_t *, const uint64_t *, int, int,
+                               int, int, CostVolume &);
+template void costRow<uint16_t>(const uint64_t *, const uint64_t *, int, int,
+                                int, int, CostVolume &);
+template void costRow<float>(const uint64_t *, const uint64_t *, int, int, int,
+                             int, CostVolume &);
+template void costSlice<uint8_t>(const uint64_t *, const uint64_t *, int, int,
+                                 int, int, uint8_t *);
+template void costSlice<uint16_t>(const uint64_t *, const uint64_t *, int, int,
+                                  int, int, uint16_t *);
+template void costSlice<float>(const uint64_t *, const uint64_t *, int, int,
+                               int, int, float *);
+} // namespace census
+} // namespace libSM
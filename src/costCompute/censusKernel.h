@@ -0,0 +1,145 @@
+/**
+ * @file censusKernel.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __CENSUS_KERNEL_H_
+#define __CENSUS_KERNEL_H_
+
+#include "censusCost.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cv {
+class Mat;
+}
+
+namespace libSM {
+namespace census {
+/**
+ * @brief number of comparisons(bits) of a census descriptor
+ *
+ * @param pattern sampling pattern
+ * @param windowWidth the width of the census window
+ * @param windowHeight the height of the census window
+ * @return int number of comparisons
+ */
+int comparisonCount(IN const CensusPattern pattern, IN const int windowWidth,
+                    IN const int windowHeight);
+
+/**
+ * @brief number of 64-bit words of a census descriptor(1, 2 or 4)
+ *
+ * @param pattern sampling pattern
+ * @param windowWidth the width of the census window
+ * @param windowHeight the height of the census window
+ * @return int number of words
+ */
+int wordCount(IN const CensusPattern pattern, IN const int windowWidth,
+              IN const int windowHeight);
+
+/**
+ * @brief census transform of the whole image. Row y of the output holds the
+ * word planes of the image row one after another, i.e. word w of pixel x is
+ * the (w * cols + x)-th uint64_t of the row. Within a word the comparisons are
+ * shifted in one after another, so that the first comparison ends in the most
+ * significant bit. Pixels whose window exceeds the image are set to zero.
+ *
+ * @param img gray image
+ * @param out census image(CV_8UC(8) of cols * wordCount columns)
+ * @param windowWidth the width of the census window
+ * @param windowHeight the height of the census window
+ * @param pattern sampling pattern
+ */
+void transform(IN const cv::Mat &img, OUT cv::Mat &out, IN const int windowWidth,
+               IN const int windowHeight,
+               IN const CensusPattern pattern = CensusPattern::Dense);
+
+/**
+ * @brief census transform of a window fixed at compile time, same output as
+ * transform()
+ *
+ */
+typedef void (*TransformFunc)(const cv::Mat &img, cv::Mat &out);
+
+/**
+ * @brief census transform specialized for the window, the dense 5x5, 7x7, 9x7
+ * and 11x11 windows have kernels with compile-time comparison offsets
+ *
+ * @param pattern sampling pattern
+ * @param windowWidth the width of the census window
+ * @param windowHeight the height of the census window
+ * @return TransformFunc the specialized transform, nullptr if the window has
+ * none and transform() has to be used
+ */
+TransformFunc specializedTransform(IN const CensusPattern pattern,
+                                   IN const int windowWidth,
+                                   IN const int windowHeight);
+
+/**
+ * @brief hamming distance cost of one row
+ *
+ * @tparam T cost type(uint8_t, uint16_t or float)
+ * @param leftCensus census of the left image row
+ * @param rightCensus census of the right image row
+ * @param words number of words of the descriptor
+ * @param cols number of image columns
+ * @param halfWidth half width of the census window
+ * @param minDisp minimum disparity value
+ * @param dispRange disparity range
+ * @param pixelStep number of elements between adjacent pixels of the cost
+ * @param cost cost of the row, dispRange values per pixel, invalid cells are
+ * set to CostTraits<T>::invalid()
+ */
+template <typename T>
+void costRow(IN const uint64_t *leftCensus, IN const uint64_t *rightCensus,
+             IN const int words, IN const int cols, IN const int halfWidth,
+             IN const int minDisp, IN const int dispRange,
+             IN const ptrdiff_t pixelStep, OUT T *cost);
+
+/**
+ * @brief hamming distance cost of one row of a pixel-major or ragged volume,
+ * only the stored disparities of every pixel are computed
+ *
+ * @tparam T cost type(uint8_t, uint16_t or float)
+ * @param leftCensus census of the left image row
+ * @param rightCensus census of the right image row
+ * @param words number of words of the descriptor
+ * @param halfWidth half width of the census window
+ * @param minDisp minimum disparity value
+ * @param i image y-coordinate
+ * @param cost cost volume, invalid cells are set to CostTraits<T>::invalid()
+ */
+template <typename T>
+void costRow(IN const uint64_t *leftCensus, IN const uint64_t *rightCensus,
+             IN const int words, IN const int halfWidth, IN const int minDisp,
+             IN const int i, OUT CostVolume &cost);
+
+/**
+ * @brief hamming distance cost of one row at a single disparity
+ *
+ * @tparam T cost type(uint8_t, uint16_t or float)
+ * @param leftCensus census of the left image row
+ * @param rightCensus census of the right image row
+ * @param words number of words of the descriptor
+ * @param cols number of image columns
+ * @param halfWidth half width of the census window
+ * @param disp disparity value
+ * @param cost cost of the cols pixels, invalid cells are set to
+ * CostTraits<T>::invalid()
+ */
+template <typename T>
+void costSlice(IN const uint64_t *leftCensus, IN const uint64_t *rightCensus,
+               IN const int words, IN const int cols, IN const int halfWidth,
+               IN const int disp, OUT T *cost);
+} // namespace census
+} // namespace libSM
+
+#endif //!__CENSUS_KERNEL_H_
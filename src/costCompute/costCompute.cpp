@@ -0,0 +1,32 @@
+#include "costCompute.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+
+namespace libSM {
+void CostComputer::compute(const Mat &left, const Mat &right,
+                           CostVolume &out) {
+    Mat cost;
+    compute(left, right, cost);
+    CostVolume(cost).copyTo(out);
+}
+
+int CostComputer::windowHeight() const { return 1; }
+
+void CostComputer::prepare(const Mat &left, const Mat &right) {}
+
+void CostComputer::createVolume(CostVolume &out, const int rows,
+                                const int cols, const int windowWidth,
+                                const int windowHeight, const int minDisp,
+                                const int dispRange, const int depth) {
+    if (out.layout() == CostLayout::Ragged && out.empty()) {
+        Mat bands;
+        validBands(rows, cols, windowWidth / 2, windowHeight / 2, minDisp,
+                   dispRange, bands);
+        out.create(bands, dispRange, depth);
+    } else {
+        out.create(rows, cols, dispRange, depth);
+    }
+}
+} // namespace libSM
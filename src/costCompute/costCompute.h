@@ -13,6 +13,9 @@
 #define __COST_COMPUTE_H_
 
 #include <typeDef.h>
+#include <common/costVolume.h>
+
+#include <opencv2/core/hal/interface.h>
 
 namespace cv {
 class Mat;
@@ -35,6 +38,55 @@ class LIBSM_API CostComputer {
      */
     virtual void compute(IN const cv::Mat &left, IN const cv::Mat &right,
                          OUT cv::Mat &out) = 0;
+    /**
+     * @brief cost calculation into a cost volume, the volume keeps its layout.
+     * The default implementation converts the cv::Mat result.
+     *
+     * @param left rectified left image
+     * @param right rectified right image
+     * @param out cost three-dimensional space
+     */
+    virtual void compute(IN const cv::Mat &left, IN const cv::Mat &right,
+                         OUT CostVolume &out);
+    /**
+     * @brief height of the cost window, the cost of a pixel depends on the
+     * image rows up to half of it above and below the pixel. A computer of a
+     * windowed cost must report its window, the costs of a band of rows are
+     * only those of the whole image with that many rows around the band.
+     *
+     * @return int window height, 1 for a pixel-wise cost
+     */
+    virtual int windowHeight() const;
+    /**
+     * @brief prepare the state a computer derives from the whole image pair,
+     * such as a mutual information table, so that compute() on bands of rows
+     * of the pair gives the costs of the whole image. The state is used until
+     * the next prepare(), empty images drop it. The default keeps no state.
+     *
+     * @param left rectified left image
+     * @param right rectified right image
+     */
+    virtual void prepare(IN const cv::Mat &left, IN const cv::Mat &right);
+
+  protected:
+    /**
+     * @brief allocate the output volume of a windowed cost. An unallocated
+     * ragged volume only stores the cells whose windows lie inside both
+     * images, the bands of an allocated one are kept.
+     *
+     * @param out cost volume
+     * @param rows number of image rows
+     * @param cols number of image columns
+     * @param windowWidth the width of the cost window
+     * @param windowHeight the height of the cost window
+     * @param minDisp minimum disparity value
+     * @param dispRange disparity range
+     * @param depth element type of the cost
+     */
+    static void createVolume(OUT CostVolume &out, IN const int rows,
+                             IN const int cols, IN const int windowWidth,
+                             IN const int windowHeight, IN const int minDisp,
+                             IN const int dispRange, IN const int depth);
 };
 } // namespace libSM
 
@@ -0,0 +1,413 @@
+#include "miCost.h"
+#include "common/costTraits.h"
+#include "common/dispRange.h"
+#include "costAggregation/multipathAggregation.h"
+#include "dispCompute/dispCompute.h"
+
+#include <omp.h>
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace libSM {
+/**
+ * @brief number of intensity levels of the entropy tables
+ *
+ */
+static const int INTENSITY_LEVELS = 256;
+
+/**
+ * @brief implementation class for the MICost interface.
+ *
+ */
+class MICostImpl : public MICost {
+  public:
+    MICostImpl(const Params params) : params_(params) {}
+    void compute(const Mat &left, const Mat &right, Mat &out) override;
+    void prepare(const Mat &left, const Mat &right) override;
+
+  private:
+    /**
+     * @brief mutual information cost table of an image pair, estimated on
+     * the pyramid of the pair
+     *
+     * @param left rectified left gray image
+     * @param right rectified right gray image
+     * @param table cost of the pair (left, right) stored at
+     * left * INTENSITY_LEVELS + right
+     */
+    void pyramidTable(const Mat &left, const Mat &right,
+                      vector<float> &table);
+    /**
+     * @brief mutual information cost table of the intensity pairs matched by
+     * a disparity map
+     *
+     * @param left rectified left gray image
+     * @param right rectified right gray image
+     * @param disp disparity map of the left image(CV_32FC1), occluded,
+     * mismatched and unmatched(NONE_PIXEL) pixels are skipped
+     * @param table cost of the pair (left, right) stored at
+     * left * INTENSITY_LEVELS + right
+     */
+    void costTable(const Mat &left, const Mat &right, const Mat &disp,
+                   vector<float> &table);
+    /**
+     * @brief match one pyramid level with the cost table
+     *
+     * @param left rectified left gray image
+     * @param right rectified right gray image
+     * @param table cost table
+     * @param minDisp minimum disparity value of the level
+     * @param maxDisp maximum disparity value of the level
+     * @param disp disparity map of the left image
+     */
+    void match(const Mat &left, const Mat &right, const vector<float> &table,
+               const int minDisp, const int maxDisp, Mat &disp);
+    /**
+     * @brief cost of all the cells as a lookup of the cost table
+     *
+     * @tparam T cost type
+     * @param left rectified left gray image
+     * @param right rectified right gray image
+     * @param table cost table, multiplied by scale for the cost type
+     * @param minDisp minimum disparity value
+     * @param maxDisp maximum disparity value
+     * @param out cost three-dimensional space
+     */
+    template <typename T>
+    void lookupCost(const Mat &left, const Mat &right,
+                    const vector<float> &table, const float scale,
+                    const int minDisp, const int maxDisp, Mat &out);
+    Params params_;
+    vector<float> preparedTable_; // cost table of the prepared image pair
+};
+
+/**
+ * @brief 7-tap gaussian smoothing of a one-dimensional table, the border is
+ * reflected
+ *
+ * @param table table to smooth
+ */
+static void smoothTable(vector<float> &table) {
+    const int halfSize = 3;
+    float weights[2 * halfSize + 1], weightSum = 0.f;
+    for (int t = -halfSize; t <= halfSize; ++t) {
+        weights[t + halfSize] = exp(-0.5f * t * t);
+        weightSum += weights[t + halfSize];
+    }
+
+    const int size = static_cast<int>(table.size());
+    vector<float> source(table);
+    for (int i = 0; i < size; ++i) {
+        float sum = 0.f;
+        for (int t = -halfSize; t <= halfSize; ++t) {
+            int k = i + t;
+            k = k < 0 ? -k : (k >= size ? 2 * size - k - 2 : k);
+            sum += weights[t + halfSize] * source[k];
+        }
+        table[i] = sum / weightSum;
+    }
+}
+
+void MICostImpl::costTable(const Mat &left, const Mat &right, const Mat &disp,
+                           vector<float> &table) {
+    const int bins = INTENSITY_LEVELS * INTENSITY_LEVELS;
+    const int threads = omp_get_max_threads();
+    // every thread counts into its own joint histogram
+    vector<vector<int>> histograms(threads, vector<int>(bins, 0));
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < left.rows; ++i) {
+        auto &histogram = histograms[omp_get_thread_num()];
+        auto ptrLeft = left.ptr<uchar>(i);
+        auto ptrRight = right.ptr<uchar>(i);
+        auto ptrDisp = disp.ptr<float>(i);
+
+        for (int j = 0; j < left.cols; ++j) {
+            if (IS_OCCLUDED_PIXEL(ptrDisp[j]) ||
+                IS_MISMATCHED_PIXEL(ptrDisp[j]) || IS_NONE_PIXEL(ptrDisp[j])) {
+                continue;
+            }
+
+            const int rightX = j - cvRound(ptrDisp[j]);
+            if (rightX < 0 || rightX > left.cols - 1) {
+                continue;
+            }
+
+            ++histogram[ptrLeft[j] * INTENSITY_LEVELS + ptrRight[rightX]];
+        }
+    }
+
+    vector<int> joint(bins, 0);
+#pragma omp parallel for default(shared) schedule(static)
+    for (int k = 0; k < bins; ++k) {
+        for (int t = 0; t < threads; ++t) {
+            joint[k] += histograms[t][k];
+        }
+    }
+
+    double matched = 0;
+    for (int k = 0; k < bins; ++k) {
+        matched += joint[k];
+    }
+
+    table.assign(bins, 0.f);
+    if (matched == 0) {
+        return;
+    }
+
+    // probability of the intensity pairs, smoothed by the Parzen window
+    Mat probability(INTENSITY_LEVELS, INTENSITY_LEVELS, CV_32FC1);
+    for (int i = 0; i < INTENSITY_LEVELS; ++i) {
+        auto ptrProbability = probability.ptr<float>(i);
+        for (int k = 0; k < INTENSITY_LEVELS; ++k) {
+            ptrProbability[k] = static_cast<float>(
+                joint[i * INTENSITY_LEVELS + k] / matched);
+        }
+    }
+    GaussianBlur(probability, probability, Size(7, 7), 1.0);
+
+    const float minProbability = 1e-7f;
+    vector<float> leftEntropy(INTENSITY_LEVELS, 0.f),
+        rightEntropy(INTENSITY_LEVELS, 0.f);
+    Mat jointEntropy(INTENSITY_LEVELS, INTENSITY_LEVELS, CV_32FC1);
+    for (int i = 0; i < INTENSITY_LEVELS; ++i) {
+        auto ptrProbability = probability.ptr<float>(i);
+        auto ptrEntropy = jointEntropy.ptr<float>(i);
+        for (int k = 0; k < INTENSITY_LEVELS; ++k) {
+            leftEntropy[i] += ptrProbability[k];
+            rightEntropy[k] += ptrProbability[k];
+            ptrEntropy[k] = -log(max(ptrProbability[k], minProbability));
+        }
+    }
+
+    for (int i = 0; i < INTENSITY_LEVELS; ++i) {
+        leftEntropy[i] = -log(max(leftEntropy[i], minProbability));
+        rightEntropy[i] = -log(max(rightEntropy[i], minProbability));
+    }
+    GaussianBlur(jointEntropy, jointEntropy, Size(7, 7), 1.0);
+    smoothTable(leftEntropy);
+    smoothTable(rightEntropy);
+
+    // mi = h(left) + h(right) - h(left, right), the cost is its distance to
+    // the maximum so that it is non-negative
+    float maxInformation = -FLT_MAX;
+    for (int i = 0; i < INTENSITY_LEVELS; ++i) {
+        auto ptrEntropy = jointEntropy.ptr<float>(i);
+        for (int k = 0; k < INTENSITY_LEVELS; ++k) {
+            const float information =
+                leftEntropy[i] + rightEntropy[k] - ptrEntropy[k];
+            table[i * INTENSITY_LEVELS + k] = information;
+            maxInformation = max(maxInformation, information);
+        }
+    }
+
+    for (auto &cost : table) {
+        cost = params_.costScale * (maxInformation - cost);
+    }
+}
+
+void MICostImpl::match(const Mat &left, const Mat &right,
+                       const vector<float> &table, const int minDisp,
+                       const int maxDisp, Mat &disp) {
+    Mat cost;
+    lookupCost<float>(left, right, table, 1.f, minDisp, maxDisp, cost);
+
+    Mat aggregatedCost;
+    {
+        auto params = MultipathAggregation::Params();
+        params.P1 = params_.P1;
+        params.P2 = params_.P2;
+
+        auto multipathAggregator = MultipathAggregation::create(params);
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+    }
+
+    cost.release();
+
+    {
+        auto params = DispComputeParams();
+        params.enableLRCheck = true;
+        params.enableUniqueCheck = false;
+        params.enableSubpixelFitting = false;
+        params.minDisp = minDisp;
+        params.maxDisp = maxDisp;
+
+        disp.release();
+        winnerTakesAll(aggregatedCost, disp, params);
+    }
+}
+
+template <typename T>
+void MICostImpl::lookupCost(const Mat &left, const Mat &right,
+                            const vector<float> &table, const float scale,
+                            const int minDisp, const int maxDisp, Mat &out) {
+    const int dispRange = maxDisp - minDisp;
+    const T invalid = CostTraits<T>::invalid();
+
+    // a valid cost stays below the invalid one
+    vector<T> lookup(table.size());
+    for (size_t k = 0; k < table.size(); ++k) {
+        lookup[k] = min(saturate_cast<T>(table[k] * scale),
+                        static_cast<T>(invalid - 1));
+    }
+
+    out.create(left.size(), CV_MAKETYPE(DataType<T>::depth, dispRange));
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < out.rows; ++i) {
+        auto ptrLeft = left.ptr<uchar>(i);
+        auto ptrRight = right.ptr<uchar>(i);
+        auto ptrOut = out.ptr<T>(i);
+
+        for (int j = 0; j < out.cols; ++j) {
+            auto ptrCost = ptrOut + dispRange * j;
+            const T *ptrLookup = lookup.data() + ptrLeft[j] * INTENSITY_LEVELS;
+            const uchar *ptrMatched = ptrRight + j - minDisp;
+
+            int beginDisp, endDisp;
+            validDispRange(j, out.cols, 0, minDisp, dispRange, beginDisp,
+                           endDisp);
+
+            std::fill(ptrCost, ptrCost + beginDisp, invalid);
+            for (int d = beginDisp; d < endDisp; ++d) {
+                ptrCost[d] = ptrLookup[ptrMatched[-d]];
+            }
+            std::fill(ptrCost + endDisp, ptrCost + dispRange, invalid);
+        }
+    }
+}
+
+/**
+ * @brief gray images of a rectified image pair
+ *
+ * @param left rectified left image(CV_8UC1 or CV_8UC3)
+ * @param right rectified right image of the same type
+ * @param leftGray left gray image
+ * @param rightGray right gray image
+ */
+static void grayImages(const Mat &left, const Mat &right, Mat &leftGray,
+                       Mat &rightGray) {
+    if (left.type() == CV_8UC3) {
+        cvtColor(left, leftGray, COLOR_BGR2GRAY);
+        cvtColor(right, rightGray, COLOR_BGR2GRAY);
+    } else {
+        leftGray = left;
+        rightGray = right;
+    }
+}
+
+void MICostImpl::pyramidTable(const Mat &left, const Mat &right,
+                              vector<float> &table) {
+    Mat disp; // disparity map of the previous(coarser) level
+
+    for (int level = params_.pyramidLevels; level >= 0; --level) {
+        const int scale = 1 << level;
+        Mat leftLevel, rightLevel;
+        if (level > 0) {
+            const Size size(max(left.cols / scale, 1),
+                            max(left.rows / scale, 1));
+            resize(left, leftLevel, size, 0, 0, INTER_AREA);
+            resize(right, rightLevel, size, 0, 0, INTER_AREA);
+        } else {
+            leftLevel = left;
+            rightLevel = right;
+        }
+
+        const int minDisp =
+            cvFloor(params_.minDisp / static_cast<float>(scale));
+        const int maxDisp = max(
+            cvCeil(params_.maxDisp / static_cast<float>(scale)), minDisp + 1);
+
+        // the prior disparity of the level, random on the coarsest one
+        Mat prior(leftLevel.size(), CV_32FC1);
+        if (disp.empty()) {
+            RNG rng(0x4d49);
+            for (int i = 0; i < prior.rows; ++i) {
+                auto ptrPrior = prior.ptr<float>(i);
+                for (int j = 0; j < prior.cols; ++j) {
+                    ptrPrior[j] =
+                        static_cast<float>(rng.uniform(minDisp, maxDisp));
+                }
+            }
+        } else {
+            const float dispScale = static_cast<float>(prior.cols) / disp.cols;
+            for (int i = 0; i < prior.rows; ++i) {
+                auto ptrDisp = disp.ptr<float>(
+                    min(i * disp.rows / prior.rows, disp.rows - 1));
+                auto ptrPrior = prior.ptr<float>(i);
+                for (int j = 0; j < prior.cols; ++j) {
+                    const float val =
+                        ptrDisp[min(j * disp.cols / prior.cols, disp.cols - 1)];
+                    ptrPrior[j] =
+                        IS_OCCLUDED_PIXEL(val) || IS_MISMATCHED_PIXEL(val)
+                            ? val
+                            : val * dispScale;
+                }
+            }
+        }
+
+        const int iterations = disp.empty() ? params_.coarseIterations : 1;
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            costTable(leftLevel, rightLevel, prior, table);
+            // the table of the full resolution is only used for the cost
+            if (level > 0 || iteration < iterations - 1) {
+                match(leftLevel, rightLevel, table, minDisp, maxDisp, prior);
+            }
+        }
+
+        disp = prior;
+    }
+}
+
+void MICostImpl::prepare(const Mat &left, const Mat &right) {
+    preparedTable_.clear();
+    if (left.empty()) {
+        return;
+    }
+
+    CV_Assert_N(!right.empty(), left.size == right.size,
+                left.type() == right.type(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3,
+                params_.maxDisp > params_.minDisp, params_.pyramidLevels >= 0,
+                params_.coarseIterations >= 1);
+
+    Mat leftGray, rightGray;
+    grayImages(left, right, leftGray, rightGray);
+    pyramidTable(leftGray, rightGray, preparedTable_);
+}
+
+void MICostImpl::compute(const Mat &left, const Mat &right, Mat &out) {
+    CV_Assert_N(!left.empty(), !right.empty(), left.size == right.size,
+                left.type() == right.type(),
+                left.type() == CV_8UC1 || left.type() == CV_8UC3,
+                params_.maxDisp > params_.minDisp, params_.pyramidLevels >= 0,
+                params_.coarseIterations >= 1,
+                params_.costType == CV_16U || params_.costType == CV_32F);
+
+    Mat leftGray, rightGray;
+    grayImages(left, right, leftGray, rightGray);
+
+    // the table of a prepared pair is shared by all the bands of its rows
+    vector<float> table;
+    if (preparedTable_.empty()) {
+        pyramidTable(leftGray, rightGray, table);
+    }
+    const vector<float> &costs =
+        preparedTable_.empty() ? table : preparedTable_;
+
+    if (params_.costType == CV_16U) {
+        lookupCost<uint16_t>(leftGray, rightGray, costs, MI_COST_SCALE_16U,
+                             params_.minDisp, params_.maxDisp, out);
+    } else {
+        lookupCost<float>(leftGray, rightGray, costs, 1.f, params_.minDisp,
+                          params_.maxDisp, out);
+    }
+}
+
+Ptr<CostComputer> MICost::create(const Params params) {
+    return Ptr<MICostImpl>(new MICostImpl(params));
+}
+} // namespace libSM
@@ -0,0 +1,75 @@
+/**
+ * @file miCost.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __MI_COST_H_
+#define __MI_COST_H_
+
+#include <libStereoMatchConfig.h>
+
+#include "costCompute.h"
+
+#define MI_COST_SCALE_16U 32.f
+
+namespace libSM {
+/**
+ * @brief Hierarchical Mutual Information Cost Calculator
+ *
+ * The joint entropy of the intensities is estimated on an image pyramid: the
+ * coarsest level starts from random disparities and is matched a few times,
+ * every finer level is matched once using the disparity of the previous level.
+ * The full-resolution cost of a cell is a lookup of the mutual information
+ * table of its intensity pair. prepare() estimates the table of a whole pair
+ * once, compute() on bands of its rows then only looks the costs up.
+ */
+class LIBSM_API MICost : public CostComputer {
+  public:
+    /**
+     * @brief parameters in the MI cost calculator.
+     *
+     */
+    struct Params {
+        Params()
+            : minDisp(0), maxDisp(128), pyramidLevels(3), coarseIterations(3),
+              costScale(2.f), P1(10.f), P2(150.f), costType(CV_32F) {}
+        int minDisp;          // minimum disparity value
+        int maxDisp;          // maximum disparity value
+        int pyramidLevels;    // number of halvings of the coarsest level
+        int coarseIterations; // number of matchings of the coarsest level
+        float costScale;      // scale of the mutual information(in nats)
+        float P1; // penalty for disparity continuity of the coarse matchings
+        float P2; // penalty for disparity no continuity of the coarse
+                  // matchings
+        int costType; // element type of the cost space, CV_16U stores the
+                      // float cost quantized by MI_COST_SCALE_16U
+    };
+    using CostComputer::compute;
+    virtual ~MICost() {}
+    /**
+     * @brief create a cost calculator
+     *
+     * @param params parameters
+     * @return Ptr<CostComputer> cost calculator
+     */
+    static Ptr<CostComputer>
+    create(IN const Params params); // create a cost calculator
+    /**
+     * @brief cost calculation
+     *
+     * @param left rectified left image
+     * @param right rectified right image
+     * @param out cost three-dimensional space
+     */
+    virtual void compute(IN const cv::Mat &left, IN const cv::Mat &right,
+                         OUT cv::Mat &out) override = 0;
+};
+} // namespace libSM
+
+#endif //! __MI_COST_H_
@@ -1,4 +1,6 @@
 #include "dispCompute.h"
+#include "dispKernel.h"
+#include "common/costTraits.h"
 
 #include <opencv2/opencv.hpp>
 
@@ -7,132 +9,274 @@ using namespace std;
 
 namespace libSM {
 /**
- * @brief check if the difference in value is too small
+ * @brief winner-takes-all algorithm of a pixel-major or ragged cost volume,
+ * only the stored disparities of a pixel are candidates
  *
- * @param majorMinCost      minimum cost
- * @param minorMinCost      sub minimum cost
- * @param uniquenessRatio   uniqueness ratio
- * @return true             pass
- * @return false            not passed
+ * @tparam T cost type
+ * @param costMap cost space
+ * @param dispMap disparity map
+ * @param rightDispMap right disparity map, nullptr if not wanted
+ * @param confidenceMap confidence map, nullptr if not wanted
+ * @param params disparity computation control parameters
  */
-bool uniqueCheck(const float majorMinCost, const float minorMinCost,
-                 const float uniquenessRatio = 0.8f) {
-    return (minorMinCost - majorMinCost) >
-           majorMinCost * (1.f - uniquenessRatio);
+template <typename T>
+void winnerTakesAllImpl(const CostVolume &costMap, Mat &dispMap,
+                        Mat *rightDispMap, Mat *confidenceMap,
+                        const DispComputeParams params) {
+    const int cols = costMap.cols();
+    const bool needRight = wta::needRightWinners(
+        params, rightDispMap != nullptr, confidenceMap != nullptr);
+    const wta::FindWinnerFunc<T> findWinner = wta::selectFindWinner<T>();
+
+#pragma omp parallel default(shared)
+    {
+        vector<wta::Winner> winners(cols);
+        wta::RightWinners<T> rightWinners(cols, costMap.dispRange());
+
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < costMap.rows(); ++i) {
+            auto ptrDispMap = dispMap.ptr<float>(i);
+            auto ptrConfidenceMap =
+                confidenceMap != nullptr ? confidenceMap->ptr<float>(i)
+                                         : nullptr;
+            rightWinners.reset();
+
+            // one pass over the row finds the winners of the left and of the
+            // right pixels
+            for (int j = 0; j < cols; ++j) {
+                auto ptrCost = costMap.ptr<T>(i, j);
+                const int dispBegin = costMap.dispBegin(i, j);
+                const int dispEnd = costMap.dispEnd(i, j);
+
+                if (dispBegin == dispEnd) {
+                    winners[j].disp = -1;
+                    continue;
+                }
+
+                winners[j] = findWinner(ptrCost, dispBegin, dispEnd);
+                if (needRight) {
+                    rightWinners.add(j, ptrCost, dispBegin, dispEnd);
+                }
+            }
+
+            for (int j = 0; j < cols; ++j) {
+                if (winners[j].disp < 0) {
+                    ptrDispMap[j] = NONE_PIXEL;
+                    if (ptrConfidenceMap != nullptr) {
+                        ptrConfidenceMap[j] = 0.f;
+                    }
+                    continue;
+                }
+
+                const int rightDisp =
+                    needRight ? rightWinners.match(j, winners[j].disp) : -1;
+                ptrDispMap[j] = wta::pickDisparity(
+                    winners[j], j, rightDisp, params,
+                    ptrConfidenceMap != nullptr ? ptrConfidenceMap + j
+                                                : nullptr);
+            }
+
+            if (rightDispMap != nullptr) {
+                rightWinners.copyTo(rightDispMap->ptr<float>(i),
+                                    params.minDisp);
+            }
+        }
+    }
 }
 
 /**
- * @brief left and right consistency test
+ * @brief winner-takes-all algorithm of a disparity-major cost volume, every
+ * disparity slice is scanned along the row so that the minimum search and the
+ * right image scan of the left-right check run across the pixels
  *
- * @param ptrCostMap        the cost of the current line
- * @param leftBestDisp      left image best parallax
- * @param lx                left image x-coordinate
- * @param rx                matched right image x-coordinate
- * @param dispRange         parallax interval
- * @param cols              number of image columns
- * @param lrCheckThreshod   left and right consistency threshold
- * @return pair<bool, bool> first: pass or no pass, second: is occlusions or
- * mismatches
+ * @tparam T cost type
+ * @param costMap cost space
+ * @param dispMap disparity map
+ * @param rightDispMap right disparity map, nullptr if not wanted
+ * @param confidenceMap confidence map, nullptr if not wanted
+ * @param params disparity computation control parameters
  */
-pair<bool, bool> lrCheck(const float *ptrCostMap, const int lx, const int rx,
-                         const int minDisp, const int maxDisp, const int cols,
-                         const int lrCheckThreshod = 1) {
-    int rightBestDisp = lx - rx;
-    float minCost = FLT_MAX;
-    const int dispRange = maxDisp - minDisp;
-
-    for (int d = -dispRange + 1; d <= 0; ++d) {
-        auto curLx = rx - d + minDisp;
-        if (curLx < 0 || curLx > cols - 1) {
-            continue;
-        }
+template <typename T>
+void winnerTakesAllDispMajor(const CostVolume &costMap, Mat &dispMap,
+                             Mat *rightDispMap, Mat *confidenceMap,
+                             const DispComputeParams params) {
+    const int cols = costMap.cols();
+    const int dispRange = costMap.dispRange();
+    const ptrdiff_t dispStep = costMap.dispStep();
+    const bool needRight = wta::needRightWinners(
+        params, rightDispMap != nullptr, confidenceMap != nullptr);
+
+#pragma omp parallel default(shared)
+    {
+        vector<T> majorMinCost(cols), minorMinCost(cols);
+        vector<int> majorDisp(cols);
+        wta::RightWinners<T> rightWinners(cols, dispRange);
+
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < costMap.rows(); ++i) {
+            auto ptrCostMap = costMap.ptr<T>(i);
+            auto ptrDispMap = dispMap.ptr<float>(i);
+            auto ptrConfidenceMap =
+                confidenceMap != nullptr ? confidenceMap->ptr<float>(i)
+                                         : nullptr;
+            std::fill(majorMinCost.begin(), majorMinCost.end(),
+                      CostTraits<T>::invalid());
+            std::fill(minorMinCost.begin(), minorMinCost.end(),
+                      CostTraits<T>::invalid());
+            std::fill(majorDisp.begin(), majorDisp.end(), 0);
+
+            for (int d = 0; d < dispRange; ++d) {
+                const T *ptrSlice = ptrCostMap + d * dispStep;
+                for (int j = 0; j < cols; ++j) {
+                    const bool better = ptrSlice[j] < majorMinCost[j];
+                    majorMinCost[j] = better ? ptrSlice[j] : majorMinCost[j];
+                    majorDisp[j] = better ? d : majorDisp[j];
+                }
+            }
+
+            // the neighbours of the minimum belong to the same match
+            for (int d = 0; d < dispRange; ++d) {
+                const T *ptrSlice = ptrCostMap + d * dispStep;
+                for (int j = 0; j < cols; ++j) {
+                    const bool other = abs(d - majorDisp[j]) > 1;
+                    minorMinCost[j] = other && ptrSlice[j] < minorMinCost[j]
+                                          ? ptrSlice[j]
+                                          : minorMinCost[j];
+                }
+            }
+
+            if (needRight) {
+                rightWinners.reset();
+                for (int d = 0; d < dispRange; ++d) {
+                    rightWinners.addSlice(d, ptrCostMap + d * dispStep);
+                }
+            }
 
-        auto curCost = ptrCostMap[dispRange * curLx - d];
-        if (curCost < minCost) {
-            minCost = curCost;
-            rightBestDisp = d;
+            for (int j = 0; j < cols; ++j) {
+                wta::Winner winner;
+                winner.disp = majorDisp[j];
+                winner.cost = majorMinCost[j];
+                winner.minorCost = minorMinCost[j];
+                winner.inside =
+                    majorDisp[j] != 0 && majorDisp[j] != dispRange - 1;
+                winner.preCost =
+                    winner.inside
+                        ? ptrCostMap[(majorDisp[j] - 1) * dispStep + j]
+                        : 0.f;
+                winner.aftCost =
+                    winner.inside
+                        ? ptrCostMap[(majorDisp[j] + 1) * dispStep + j]
+                        : 0.f;
+
+                const int rightDisp =
+                    needRight ? rightWinners.match(j, winner.disp) : -1;
+                ptrDispMap[j] = wta::pickDisparity(
+                    winner, j, rightDisp, params,
+                    ptrConfidenceMap != nullptr ? ptrConfidenceMap + j
+                                                : nullptr);
+            }
+
+            if (rightDispMap != nullptr) {
+                rightWinners.copyTo(rightDispMap->ptr<float>(i),
+                                    params.minDisp);
+            }
         }
     }
-
-    return make_pair(abs(rx - rightBestDisp + minDisp - lx) <= lrCheckThreshod,
-                     (lx - rx) < abs(rightBestDisp));
 }
 
 /**
- * @brief sub-pixel fitting
+ * @brief winner-takes-all of a cost volume of any layout and cost type
  *
- * @param ptrCostMap the cost of the current line
- * @param lx         left image x-coordinate
- * @param disp       parallax of current left image pixels
- * @param minCost    the minimum cost of pixels in the current left image
- * @param dispRange  parallax interval
- * @return float     sub-pixel parallax
+ * @param costVolume cost volume
+ * @param dispMap disparity map
+ * @param rightDispMap right disparity map, nullptr if not wanted
+ * @param confidenceMap confidence map, nullptr if not wanted
+ * @param params disparity computation control parameters
  */
-float subpixelFitting(const float *ptrCostMap, const int lx, const int disp,
-                      const float minCost, const int dispRange) {
-    auto preCost = ptrCostMap[dispRange * lx + disp - 1];
-    auto aftCost = ptrCostMap[dispRange * lx + disp + 1];
-    auto denom = max(0.001f, preCost + aftCost - 2 * minCost);
-    return disp + (preCost - aftCost) / (denom * 2.f);
+static void winnerTakesAllVolume(const CostVolume &costVolume, Mat &dispMap,
+                                 Mat *rightDispMap, Mat *confidenceMap,
+                                 const DispComputeParams params) {
+    CV_Assert_N(!costVolume.empty(), costVolume.depth() == CV_8U ||
+                                         costVolume.depth() == CV_16U ||
+                                         costVolume.depth() == CV_32F);
+
+    if (dispMap.empty())
+        dispMap = Mat(costVolume.rows(), costVolume.cols(), CV_32FC1,
+                      cv::Scalar(0.f));
+    if (rightDispMap != nullptr)
+        rightDispMap->create(costVolume.rows(), costVolume.cols(), CV_32FC1);
+    if (confidenceMap != nullptr)
+        confidenceMap->create(costVolume.rows(), costVolume.cols(), CV_32FC1);
+
+    if (costVolume.layout() == CostLayout::DispMajor) {
+        if (costVolume.depth() == CV_8U) {
+            winnerTakesAllDispMajor<uint8_t>(costVolume, dispMap, rightDispMap,
+                                             confidenceMap, params);
+        } else if (costVolume.depth() == CV_16U) {
+            winnerTakesAllDispMajor<uint16_t>(costVolume, dispMap,
+                                              rightDispMap, confidenceMap,
+                                              params);
+        } else {
+            winnerTakesAllDispMajor<float>(costVolume, dispMap, rightDispMap,
+                                           confidenceMap, params);
+        }
+    } else if (costVolume.depth() == CV_8U) {
+        winnerTakesAllImpl<uint8_t>(costVolume, dispMap, rightDispMap,
+                                    confidenceMap, params);
+    } else if (costVolume.depth() == CV_16U) {
+        winnerTakesAllImpl<uint16_t>(costVolume, dispMap, rightDispMap,
+                                     confidenceMap, params);
+    } else {
+        winnerTakesAllImpl<float>(costVolume, dispMap, rightDispMap,
+                                  confidenceMap, params);
+    }
 }
 
 void winnerTakesAll(const Mat &costMap, Mat &dispMap,
                     const DispComputeParams params) {
-    CV_Assert_N(!costMap.empty());
-
-    if (dispMap.empty())
-        dispMap = Mat(costMap.size(), CV_32FC1, cv::Scalar(0.f));
+    CV_Assert_N(!costMap.empty(), costMap.depth() == CV_8U ||
+                                      costMap.depth() == CV_16U ||
+                                      costMap.depth() == CV_32F);
 
-#pragma omp parallel for schedule(dynamic) default(shared)
-    for (int i = 0; i < costMap.rows; ++i) {
-
-        auto ptrCostMap = costMap.ptr<float>(i);
-        auto ptrDispMap = dispMap.ptr<float>(i);
+    winnerTakesAllVolume(CostVolume(costMap), dispMap, nullptr, nullptr,
+                         params);
+}
 
-        for (int j = 0; j < costMap.cols; ++j) {
+void winnerTakesAll(const Mat &costMap, Mat &dispMap, Mat &rightDispMap,
+                    const DispComputeParams params) {
+    CV_Assert_N(!costMap.empty(), costMap.depth() == CV_8U ||
+                                      costMap.depth() == CV_16U ||
+                                      costMap.depth() == CV_32F);
 
-            float majorMinCost = FLT_MAX, minorMinCost = FLT_MAX;
-            int majorDisp = 0;
+    winnerTakesAllVolume(CostVolume(costMap), dispMap, &rightDispMap, nullptr,
+                         params);
+}
 
-            for (int d = 0; d < costMap.channels(); ++d) {
-                auto curCost = ptrCostMap[costMap.channels() * j + d];
-                if (curCost < majorMinCost) {
-                    minorMinCost = majorMinCost;
-                    majorMinCost = curCost;
-                    majorDisp = d;
-                }
-            }
+void winnerTakesAll(const CostVolume &costVolume, Mat &dispMap,
+                    const DispComputeParams params) {
+    winnerTakesAllVolume(costVolume, dispMap, nullptr, nullptr, params);
+}
 
-            if (params.enableUniqueCheck &&
-                !uniqueCheck(majorMinCost, minorMinCost,
-                             params.uniquenessRatio)) {
-                ptrDispMap[j] = NONE_PIXEL;
-                continue;
-            }
+void winnerTakesAll(const CostVolume &costVolume, Mat &dispMap,
+                    Mat &rightDispMap, const DispComputeParams params) {
+    winnerTakesAllVolume(costVolume, dispMap, &rightDispMap, nullptr,
+                         params);
+}
 
-            if (params.enableLRCheck) {
-                auto lrCheckResult =
-                    lrCheck(ptrCostMap, j, j - (majorDisp + params.minDisp),
-                            params.minDisp, params.maxDisp, costMap.cols,
-                            params.lrCheckThreshod);
+void winnerTakesAll(const Mat &costMap, Mat &dispMap, Mat &rightDispMap,
+                    Mat &confidenceMap, const DispComputeParams params) {
+    CV_Assert_N(!costMap.empty(), costMap.depth() == CV_8U ||
+                                      costMap.depth() == CV_16U ||
+                                      costMap.depth() == CV_32F);
 
-                if (!lrCheckResult.first) {
-                    ptrDispMap[j] = lrCheckResult.second ? OCCLUDED_PIXEL
-                                                         : MISMATCHED_PIXEL;
-                    continue;
-                }
-            }
+    winnerTakesAllVolume(CostVolume(costMap), dispMap, &rightDispMap,
+                         &confidenceMap, params);
+}
 
-            if (params.enableSubpixelFitting &&
-                (majorDisp != 0 && majorDisp != costMap.channels() - 1)) {
-                ptrDispMap[j] =
-                    subpixelFitting(ptrCostMap, j, majorDisp, majorMinCost,
-                                    costMap.channels()) +
-                    params.minDisp;
-            } else {
-                ptrDispMap[j] = majorDisp + params.minDisp;
-            }
-        }
-    }
+void winnerTakesAll(const CostVolume &costVolume, Mat &dispMap,
+                    Mat &rightDispMap, Mat &confidenceMap,
+                    const DispComputeParams params) {
+    winnerTakesAllVolume(costVolume, dispMap, &rightDispMap, &confidenceMap,
+                         params);
 }
-} // namespace libSM
\ No newline at end of file
+} // namespace libSM
@@ -13,12 +13,28 @@
 #define __DISP_COMPUTE_H_
 
 #include <typeDef.h>
+#include <common/costVolume.h>
 
 namespace cv {
 class Mat;
 }
 
 namespace libSM {
+/**
+ * @brief measure of the confidence of the disparity of a pixel, taken from
+ * the costs its disparity is chosen from
+ *
+ */
+enum class ConfidenceType {
+    PeakRatio,          // 1 - c1 / c2 of the minimal cost c1 and the minimal
+                        // cost c2 more than one disparity away, in [0, 1]
+    Curvature,          // c(d - 1) + c(d + 1) - 2 * c(d) at the minimum, 0 at
+                        // the ends of the disparity range
+    LeftRightDifference // 1 / (1 + |d - dr|) of the disparity d and the
+                        // disparity dr of the right pixel it matches, in
+                        // (0, 1]
+};
+
 /**
  * @brief disparity computation control parameters
  *
@@ -26,7 +42,8 @@ namespace libSM {
 struct DispComputeParams {
     DispComputeParams()
         : enableLRCheck(true), enableUniqueCheck(true), enableSubpixelFitting(true), minDisp(0),
-          maxDisp(64), uniquenessRatio(0.95f), lrCheckThreshod(1) {}
+          maxDisp(64), uniquenessRatio(0.95f), lrCheckThreshod(1),
+          confidenceType(ConfidenceType::PeakRatio) {}
     bool enableLRCheck;          // left-right consistency check
     bool enableUniqueCheck;      // consistency check
     bool enableSubpixelFitting;  // subpixel fitting
@@ -34,16 +51,94 @@ struct DispComputeParams {
     int lrCheckThreshod;   // left and right consistency threshold
     int minDisp;           // minimum disparity value
     int maxDisp;           // maximum disparity value
+    ConfidenceType confidenceType; // measure of the confidence map
 };
 
 /**
  * @brief winner-takes-all algorithm
  *
- * @param costMap //cost space
+ * @param costMap //cost space(CV_8U, CV_16U or CV_32F)
+ * @param dispMap //disparity map
+ * @param params  //disparity computation control parameters
+ */
+void LIBSM_API winnerTakesAll(IN const cv::Mat &costMap, OUT cv::Mat &dispMap,
+                              IN const DispComputeParams params);
+
+/**
+ * @brief winner-takes-all algorithm of a cost volume, the disparity-major
+ * layout is scanned slice by slice and the pixels of a ragged volume only
+ * choose among their stored disparities
+ *
+ * @param costVolume //cost volume(CV_8U, CV_16U or CV_32F)
+ * @param dispMap //disparity map
+ * @param params  //disparity computation control parameters
+ */
+void LIBSM_API winnerTakesAll(IN const CostVolume &costVolume,
+                              OUT cv::Mat &dispMap,
+                              IN const DispComputeParams params);
+
+/**
+ * @brief winner-takes-all algorithm which gives the disparities of the right
+ * image pixels as well, the right disparity of a pixel is the disparity of
+ * its minimal cost without the checks and the sub-pixel fitting
+ *
+ * @param costMap //cost space(CV_8U, CV_16U or CV_32F)
+ * @param dispMap //disparity map
+ * @param rightDispMap //right disparity map, NONE_PIXEL where a right pixel
+ * has no valid cost
+ * @param params  //disparity computation control parameters
+ */
+void LIBSM_API winnerTakesAll(IN const cv::Mat &costMap, OUT cv::Mat &dispMap,
+                              OUT cv::Mat &rightDispMap,
+                              IN const DispComputeParams params);
+
+/**
+ * @brief winner-takes-all algorithm of a cost volume which gives the
+ * disparities of the right image pixels as well
+ *
+ * @param costVolume //cost volume(CV_8U, CV_16U or CV_32F)
  * @param dispMap //disparity map
+ * @param rightDispMap //right disparity map, NONE_PIXEL where a right pixel
+ * has no valid cost
+ * @param params  //disparity computation control parameters
+ */
+void LIBSM_API winnerTakesAll(IN const CostVolume &costVolume,
+                              OUT cv::Mat &dispMap, OUT cv::Mat &rightDispMap,
+                              IN const DispComputeParams params);
+
+/**
+ * @brief winner-takes-all algorithm which gives the right disparities and the
+ * confidence of every disparity as well, from the costs the disparity is
+ * chosen from, so the cost space is scanned once
+ *
+ * @param costMap //cost space(CV_8U, CV_16U or CV_32F)
+ * @param dispMap //disparity map
+ * @param rightDispMap //right disparity map, NONE_PIXEL where a right pixel
+ * has no valid cost
+ * @param confidenceMap //confidence map(CV_32F) of params.confidenceType, 0
+ * where the checks reject the disparity
  * @param params  //disparity computation control parameters
  */
 void LIBSM_API winnerTakesAll(IN const cv::Mat &costMap, OUT cv::Mat &dispMap,
+                              OUT cv::Mat &rightDispMap,
+                              OUT cv::Mat &confidenceMap,
+                              IN const DispComputeParams params);
+
+/**
+ * @brief winner-takes-all algorithm of a cost volume which gives the right
+ * disparities and the confidence of every disparity as well
+ *
+ * @param costVolume //cost volume(CV_8U, CV_16U or CV_32F)
+ * @param dispMap //disparity map
+ * @param rightDispMap //right disparity map, NONE_PIXEL where a right pixel
+ * has no valid cost
+ * @param confidenceMap //confidence map(CV_32F) of params.confidenceType, 0
+ * where the checks reject the disparity
+ * @param params  //disparity computation control parameters
+ */
+void LIBSM_API winnerTakesAll(IN const CostVolume &costVolume,
+                              OUT cv::Mat &dispMap, OUT cv::Mat &rightDispMap,
+                              OUT cv::Mat &confidenceMap,
                               IN const DispComputeParams params);
 } // namespace libSM
 
@@ -0,0 +1,347 @@
+#include "dispKernel.h"
+#include "common/cpuFeatures.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef LIBSM_X86
+#include <immintrin.h>
+#endif
+
+namespace libSM {
+namespace wta {
+/**
+ * @brief winner of the lanes of a vector sweep. A lane holds its minimal cost
+ * with the first disparity of it and the minimum of its other costs, the
+ * disparities the sweep left over are added to the lanes they would have been
+ * in. The neighbours of the winner are in other lanes than the winner, so
+ * that the minimum of the costs more than one away from the winner is the
+ * second best cost of the lanes whose best disparity is next to the winner
+ * and the best cost of the others.
+ *
+ * @tparam T cost type
+ * @tparam Lanes vector lanes
+ * @param cost costs of the pixel(cell d at cost[d])
+ * @param dispBegin band begin of the pixel
+ * @param dispEnd band end of the pixel
+ * @param d first disparity not swept
+ * @param best minimal cost of every lane
+ * @param second minimal cost of every lane without its best disparity
+ * @param index best disparity of every lane
+ * @return Winner winner of the pixel
+ */
+template <typename T, int Lanes>
+static Winner laneWinner(const T *cost, const int dispBegin, const int dispEnd,
+                         int d, T (&best)[Lanes], T (&second)[Lanes],
+                         int (&index)[Lanes]) {
+    for (; d < dispEnd; ++d) {
+        const int lane = (d - dispBegin) % Lanes;
+        if (cost[d] < best[lane]) {
+            second[lane] = best[lane];
+            best[lane] = cost[d];
+            index[lane] = d;
+        } else {
+            second[lane] = std::min(second[lane], cost[d]);
+        }
+    }
+
+    // the smaller disparity wins ties, a lane without a valid cost has the
+    // index -1
+    Winner winner;
+    T majorMinCost = CostTraits<T>::invalid();
+    winner.disp = dispBegin;
+    for (int lane = 0; lane < Lanes; ++lane) {
+        if (best[lane] < majorMinCost ||
+            (best[lane] == majorMinCost && index[lane] >= 0 &&
+             index[lane] < winner.disp)) {
+            majorMinCost = best[lane];
+            winner.disp = index[lane];
+        }
+    }
+
+    T minorMinCost = CostTraits<T>::invalid();
+    for (int lane = 0; lane < Lanes; ++lane) {
+        minorMinCost =
+            std::min(minorMinCost, std::abs(index[lane] - winner.disp) <= 1
+                                       ? second[lane]
+                                       : best[lane]);
+    }
+
+    winner.cost = majorMinCost;
+    winner.minorCost = minorMinCost;
+    winner.inside = winner.disp != dispBegin && winner.disp != dispEnd - 1;
+    winner.preCost = winner.inside ? cost[winner.disp - 1] : 0.f;
+    winner.aftCost = winner.inside ? cost[winner.disp + 1] : 0.f;
+    return winner;
+}
+
+#ifdef LIBSM_X86
+/**
+ * @brief the 16-bit lanes of a sweep, the costs were swept with their sign
+ * bit flipped so that the signed compares order them
+ *
+ */
+template <int Lanes>
+static Winner laneWinner16(const uint16_t *cost, const int dispBegin,
+                           const int dispEnd, const int d,
+                           const int16_t *biasedBest,
+                           const int16_t *biasedSecond, const int16_t *index) {
+    uint16_t best[Lanes], second[Lanes];
+    int laneIndex[Lanes];
+    for (int lane = 0; lane < Lanes; ++lane) {
+        best[lane] = static_cast<uint16_t>(biasedBest[lane] ^ 0x8000);
+        second[lane] = static_cast<uint16_t>(biasedSecond[lane] ^ 0x8000);
+        laneIndex[lane] = index[lane];
+    }
+    return laneWinner<uint16_t, Lanes>(cost, dispBegin, dispEnd, d, best,
+                                       second, laneIndex);
+}
+
+LIBSM_TARGET_SSE42 static Winner
+findWinnerSSE42(const uint16_t *cost, const int dispBegin, const int dispEnd) {
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+    __m128i best = _mm_set1_epi16(0x7fff), second = best;
+    __m128i index = _mm_set1_epi16(-1);
+    __m128i disp = _mm_add_epi16(_mm_set1_epi16(static_cast<short>(dispBegin)),
+                                 _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m128i step = _mm_set1_epi16(8);
+    int d = dispBegin;
+
+    for (; d + 8 <= dispEnd; d += 8) {
+        const __m128i curCost = _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(cost + d)),
+            bias);
+        const __m128i better = _mm_cmplt_epi16(curCost, best);
+        second =
+            _mm_blendv_epi8(_mm_min_epi16(second, curCost), best, better);
+        best = _mm_min_epi16(best, curCost);
+        index = _mm_blendv_epi8(index, disp, better);
+        disp = _mm_add_epi16(disp, step);
+    }
+
+    int16_t bestLanes[8], secondLanes[8], indexLanes[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(bestLanes), best);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(secondLanes), second);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(indexLanes), index);
+    return laneWinner16<8>(cost, dispBegin, dispEnd, d, bestLanes,
+                           secondLanes, indexLanes);
+}
+
+LIBSM_TARGET_SSE42 static Winner
+findWinnerSSE42(const float *cost, const int dispBegin, const int dispEnd) {
+    __m128 best = _mm_set1_ps(CostTraits<float>::invalid()), second = best;
+    __m128i index = _mm_set1_epi32(-1);
+    __m128i disp =
+        _mm_add_epi32(_mm_set1_epi32(dispBegin), _mm_setr_epi32(0, 1, 2, 3));
+    const __m128i step = _mm_set1_epi32(4);
+    int d = dispBegin;
+
+    for (; d + 4 <= dispEnd; d += 4) {
+        const __m128 curCost = _mm_loadu_ps(cost + d);
+        const __m128 better = _mm_cmplt_ps(curCost, best);
+        second = _mm_blendv_ps(_mm_min_ps(second, curCost), best, better);
+        best = _mm_min_ps(best, curCost);
+        index = _mm_castps_si128(_mm_blendv_ps(
+            _mm_castsi128_ps(index), _mm_castsi128_ps(disp), better));
+        disp = _mm_add_epi32(disp, step);
+    }
+
+    float bestLanes[4], secondLanes[4];
+    int indexLanes[4];
+    _mm_storeu_ps(bestLanes, best);
+    _mm_storeu_ps(secondLanes, second);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(indexLanes), index);
+    return laneWinner<float, 4>(cost, dispBegin, dispEnd, d, bestLanes,
+                                secondLanes, indexLanes);
+}
+
+LIBSM_TARGET_AVX2 static Winner
+findWinnerAVX2(const uint16_t *cost, const int dispBegin, const int dispEnd) {
+    const __m256i bias = _mm256_set1_epi16(static_cast<short>(0x8000));
+    __m256i best = _mm256_set1_epi16(0x7fff), second = best;
+    __m256i index = _mm256_set1_epi16(-1);
+    __m256i disp = _mm256_add_epi16(
+        _mm256_set1_epi16(static_cast<short>(dispBegin)),
+        _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                          15));
+    const __m256i step = _mm256_set1_epi16(16);
+    int d = dispBegin;
+
+    for (; d + 16 <= dispEnd; d += 16) {
+        const __m256i curCost = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cost + d)),
+            bias);
+        const __m256i better = _mm256_cmpgt_epi16(best, curCost);
+        second = _mm256_blendv_epi8(_mm256_min_epi16(second, curCost), best,
+                                    better);
+        best = _mm256_min_epi16(best, curCost);
+        index = _mm256_blendv_epi8(index, disp, better);
+        disp = _mm256_add_epi16(disp, step);
+    }
+
+    int16_t bestLanes[16], secondLanes[16], indexLanes[16];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(bestLanes), best);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(secondLanes), second);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(indexLanes), index);
+    _mm256_zeroupper();
+    return laneWinner16<16>(cost, dispBegin, dispEnd, d, bestLanes,
+                            secondLanes, indexLanes);
+}
+
+LIBSM_TARGET_AVX2 static Winner
+findWinnerAVX2(const float *cost, const int dispBegin, const int dispEnd) {
+    __m256 best = _mm256_set1_ps(CostTraits<float>::invalid()), second = best;
+    __m256i index = _mm256_set1_epi32(-1);
+    __m256i disp = _mm256_add_epi32(_mm256_set1_epi32(dispBegin),
+                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i step = _mm256_set1_epi32(8);
+    int d = dispBegin;
+
+    for (; d + 8 <= dispEnd; d += 8) {
+        const __m256 curCost = _mm256_loadu_ps(cost + d);
+        const __m256 better = _mm256_cmp_ps(curCost, best, _CMP_LT_OQ);
+        second =
+            _mm256_blendv_ps(_mm256_min_ps(second, curCost), best, better);
+        best = _mm256_min_ps(best, curCost);
+        index = _mm256_castps_si256(_mm256_blendv_ps(
+            _mm256_castsi256_ps(index), _mm256_castsi256_ps(disp), better));
+        disp = _mm256_add_epi32(disp, step);
+    }
+
+    float bestLanes[8], secondLanes[8];
+    int indexLanes[8];
+    _mm256_storeu_ps(bestLanes, best);
+    _mm256_storeu_ps(secondLanes, second);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(indexLanes), index);
+    _mm256_zeroupper();
+    return laneWinner<float, 8>(cost, dispBegin, dispEnd, d, bestLanes,
+                                secondLanes, indexLanes);
+}
+
+LIBSM_TARGET_AVX512 static Winner
+findWinnerAVX512(const uint16_t *cost, const int dispBegin,
+                 const int dispEnd) {
+    const __m512i bias = _mm512_set1_epi16(static_cast<short>(0x8000));
+    __m512i best = _mm512_set1_epi16(0x7fff), second = best;
+    __m512i index = _mm512_set1_epi16(-1);
+    __m512i disp = _mm512_add_epi16(
+        _mm512_set1_epi16(static_cast<short>(dispBegin)),
+        _mm512_set_epi16(31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19,
+                         18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4,
+                         3, 2, 1, 0));
+    const __m512i step = _mm512_set1_epi16(32);
+    int d = dispBegin;
+
+    for (; d + 32 <= dispEnd; d += 32) {
+        const __m512i curCost =
+            _mm512_xor_si512(_mm512_loadu_si512(cost + d), bias);
+        const __mmask32 better = _mm512_cmplt_epi16_mask(curCost, best);
+        second = _mm512_mask_mov_epi16(_mm512_min_epi16(second, curCost),
+                                       better, best);
+        best = _mm512_min_epi16(best, curCost);
+        index = _mm512_mask_mov_epi16(index, better, disp);
+        disp = _mm512_add_epi16(disp, step);
+    }
+
+    int16_t bestLanes[32], secondLanes[32], indexLanes[32];
+    _mm512_storeu_si512(bestLanes, best);
+    _mm512_storeu_si512(secondLanes, second);
+    _mm512_storeu_si512(indexLanes, index);
+    _mm256_zeroupper();
+    return laneWinner16<32>(cost, dispBegin, dispEnd, d, bestLanes,
+                            secondLanes, indexLanes);
+}
+
+LIBSM_TARGET_AVX512 static Winner
+findWinnerAVX512(const float *cost, const int dispBegin, const int dispEnd) {
+    __m512 best = _mm512_set1_ps(CostTraits<float>::invalid()), second = best;
+    __m512i index = _mm512_set1_epi32(-1);
+    __m512i disp = _mm512_add_epi32(
+        _mm512_set1_epi32(dispBegin),
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                          15));
+    const __m512i step = _mm512_set1_epi32(16);
+    int d = dispBegin;
+
+    for (; d + 16 <= dispEnd; d += 16) {
+        const __m512 curCost = _mm512_loadu_ps(cost + d);
+        const __mmask16 better = _mm512_cmp_ps_mask(curCost, best, _CMP_LT_OQ);
+        second =
+            _mm512_mask_mov_ps(_mm512_min_ps(second, curCost), better, best);
+        best = _mm512_min_ps(best, curCost);
+        index = _mm512_mask_mov_epi32(index, better, disp);
+        disp = _mm512_add_epi32(disp, step);
+    }
+
+    float bestLanes[16], secondLanes[16];
+    int indexLanes[16];
+    _mm512_storeu_ps(bestLanes, best);
+    _mm512_storeu_ps(secondLanes, second);
+    _mm512_storeu_si512(indexLanes, index);
+    _mm256_zeroupper();
+    return laneWinner<float, 16>(cost, dispBegin, dispEnd, d, bestLanes,
+                                 secondLanes, indexLanes);
+}
+#endif
+
+/**
+ * @brief winner kernel of the 8-bit costs, whose pixels are short enough for
+ * the scalar sweep
+ *
+ */
+static FindWinnerFunc<uint8_t> selectKernel(uint8_t) {
+    return findWinner<uint8_t>;
+}
+
+/**
+ * @brief winner kernel of the 16-bit costs for the instruction set level in
+ * use
+ *
+ */
+static FindWinnerFunc<uint16_t> selectKernel(uint16_t) {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return findWinnerAVX512;
+    case SimdLevel::AVX2:
+        return findWinnerAVX2;
+    case SimdLevel::SSE42:
+        return findWinnerSSE42;
+    default:
+        break;
+    }
+#endif
+    return findWinner<uint16_t>;
+}
+
+/**
+ * @brief winner kernel of the float costs for the instruction set level in
+ * use
+ *
+ */
+static FindWinnerFunc<float> selectKernel(float) {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return findWinnerAVX512;
+    case SimdLevel::AVX2:
+        return findWinnerAVX2;
+    case SimdLevel::SSE42:
+        return findWinnerSSE42;
+    default:
+        break;
+    }
+#endif
+    return findWinner<float>;
+}
+
+template <typename T> FindWinnerFunc<T> selectFindWinner() {
+    return selectKernel(T());
+}
+
+template FindWinnerFunc<uint8_t> selectFindWinner<uint8_t>();
+template FindWinnerFunc<uint16_t> selectFindWinner<uint16_t>();
+template FindWinnerFunc<float> selectFindWinner<float>();
+} // namespace wta
+} // namespace libSM
@@ -0,0 +1,320 @@
+/**
+ * @file dispKernel.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-23
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __DISP_KERNEL_H_
+#define __DISP_KERNEL_H_
+
+#include "dispCompute.h"
+#include "common/costTraits.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace libSM {
+namespace wta {
+/**
+ * @brief the minimum of the costs of a pixel and what the uniqueness check
+ * and the sub-pixel fitting need of the other costs
+ *
+ */
+struct Winner {
+    int disp;        // disparity index of the minimum cost
+    float cost;      // minimum cost
+    float minorCost; // minimum cost of the disparities more than one away
+                     // from disp, the neighbours of the minimum belong to
+                     // the same match
+    float preCost;   // cost at disp - 1
+    float aftCost;   // cost at disp + 1
+    bool inside;     // disp has a neighbour on both sides in the band
+};
+
+/**
+ * @brief winner of the costs of a pixel, the smaller disparity wins ties
+ *
+ * @tparam T cost type
+ * @param cost costs of the pixel(cell d at cost[d])
+ * @param dispBegin band begin of the pixel
+ * @param dispEnd band end of the pixel, larger than dispBegin
+ * @return Winner winner of the pixel
+ */
+template <typename T>
+inline Winner findWinner(const T *cost, const int dispBegin,
+                         const int dispEnd) {
+    Winner winner;
+    T majorMinCost = CostTraits<T>::invalid();
+    winner.disp = dispBegin;
+    for (int d = dispBegin; d < dispEnd; ++d) {
+        if (cost[d] < majorMinCost) {
+            majorMinCost = cost[d];
+            winner.disp = d;
+        }
+    }
+
+    T minorMinCost = CostTraits<T>::invalid();
+    for (int d = dispBegin; d < dispEnd; ++d) {
+        if (std::abs(d - winner.disp) > 1) {
+            minorMinCost = std::min(minorMinCost, cost[d]);
+        }
+    }
+
+    winner.cost = majorMinCost;
+    winner.minorCost = minorMinCost;
+    winner.inside = winner.disp != dispBegin && winner.disp != dispEnd - 1;
+    winner.preCost = winner.inside ? cost[winner.disp - 1] : 0.f;
+    winner.aftCost = winner.inside ? cost[winner.disp + 1] : 0.f;
+    return winner;
+}
+
+/**
+ * @brief winner of the costs of a pixel, the same as findWinner
+ *
+ */
+template <typename T>
+using FindWinnerFunc = Winner (*)(const T *cost, int dispBegin, int dispEnd);
+
+/**
+ * @brief winner kernel of the instruction set level in use, the 16-bit and
+ * the float costs are swept once with the best and the second best cost of
+ * every vector lane
+ *
+ * @tparam T cost type(uint8_t, uint16_t or float)
+ * @return FindWinnerFunc<T> kernel
+ */
+template <typename T> FindWinnerFunc<T> selectFindWinner();
+
+/**
+ * @brief uniqueness check of a winner
+ *
+ * @param winner winner of the pixel
+ * @param uniquenessRatio uniqueness ratio
+ * @return true the minimum is distinct enough from the other costs
+ */
+inline bool isUnique(const Winner &winner, const float uniquenessRatio) {
+    return (winner.minorCost - winner.cost) >
+           winner.cost * (1.f - uniquenessRatio);
+}
+
+/**
+ * @brief whether the right winners of a row are wanted
+ *
+ * @param params disparity computation control parameters
+ * @param rightDispMap the right disparity map is wanted
+ * @param confidenceMap the confidence map is wanted
+ * @return true the left-right check or one of the maps needs them
+ */
+inline bool needRightWinners(const DispComputeParams &params,
+                             const bool rightDispMap,
+                             const bool confidenceMap) {
+    return params.enableLRCheck || rightDispMap ||
+           (confidenceMap &&
+            params.confidenceType == ConfidenceType::LeftRightDifference);
+}
+
+/**
+ * @brief confidence of the disparity of a winner
+ *
+ * @param winner winner of the pixel
+ * @param rightDisp disparity index of the minimal cost of the right pixel the
+ * winner matches, -1 if it has no valid cell
+ * @param type confidence measure
+ * @return float confidence
+ */
+inline float confidence(const Winner &winner, const int rightDisp,
+                        const ConfidenceType type) {
+    switch (type) {
+    case ConfidenceType::PeakRatio:
+        return winner.minorCost > 0.f ? 1.f - winner.cost / winner.minorCost
+                                      : 0.f;
+    case ConfidenceType::Curvature:
+        return winner.inside
+                   ? winner.preCost + winner.aftCost - 2 * winner.cost
+                   : 0.f;
+    default:
+        return rightDisp < 0
+                   ? 0.f
+                   : 1.f / (1 + std::abs(winner.disp - rightDisp));
+    }
+}
+
+/**
+ * @brief disparity of a pixel from its winner, after the uniqueness check,
+ * the left-right check and the sub-pixel fitting of params
+ *
+ * @param winner winner of the pixel
+ * @param x image x-coordinate of the pixel
+ * @param rightDisp disparity index of the minimal cost of the right pixel the
+ * winner matches, the larger disparity wins ties, -1 if it has no valid cell
+ * @param params disparity computation control parameters
+ * @param conf confidence of params.confidenceType of the disparity, 0 if the
+ * checks reject it, nullptr if not wanted
+ * @return float disparity or one of the invalid pixel values
+ */
+inline float pickDisparity(const Winner &winner, const int x,
+                           const int rightDisp,
+                           const DispComputeParams &params,
+                           float *conf = nullptr) {
+    if (conf != nullptr) {
+        *conf = 0.f;
+    }
+
+    if (params.enableUniqueCheck &&
+        !isUnique(winner, params.uniquenessRatio)) {
+        return NONE_PIXEL;
+    }
+
+    if (params.enableLRCheck) {
+        const int rx = x - (winner.disp + params.minDisp);
+        const int rightBestDisp = rightDisp < 0 ? x - rx : -rightDisp;
+
+        if (std::abs(rx - rightBestDisp + params.minDisp - x) >
+            params.lrCheckThreshod) {
+            return (x - rx) < std::abs(rightBestDisp) ? OCCLUDED_PIXEL
+                                                      : MISMATCHED_PIXEL;
+        }
+    }
+
+    if (conf != nullptr) {
+        *conf = confidence(winner, rightDisp, params.confidenceType);
+    }
+
+    if (params.enableSubpixelFitting && winner.inside) {
+        const float denom = std::max(
+            0.001f, winner.preCost + winner.aftCost - 2 * winner.cost);
+        return winner.disp + (winner.preCost - winner.aftCost) / (denom * 2.f) +
+               params.minDisp;
+    }
+    return static_cast<float>(winner.disp + params.minDisp);
+}
+
+/**
+ * @brief bits of a cost which order like the cost
+ *
+ */
+inline uint32_t orderBits(const uint8_t cost) { return cost; }
+inline uint32_t orderBits(const uint16_t cost) { return cost; }
+inline uint32_t orderBits(const float cost) {
+    uint32_t bits;
+    std::memcpy(&bits, &cost, sizeof(bits));
+    // the negative floats order backwards
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+/**
+ * @brief best disparities of the right pixels of a row, gathered in one pass
+ * over the costs of the left pixels, so that the left-right check of a left
+ * pixel is a lookup. A cell of disparity index d is a key of its cost above
+ * dispRange - 1 - d, so that the minimal key of a right pixel holds its
+ * minimal cost and the larger disparity wins ties. The cells of left pixel x
+ * at d belong to right pixel x - d - minDisp, whose key is at
+ * cols - 1 - x + d, so that the disparities of a left pixel run forward
+ * through the keys.
+ *
+ * @tparam T cost type
+ */
+template <typename T> class RightWinners {
+  public:
+    typedef typename std::conditional<std::is_same<T, float>::value,
+                                      uint64_t, uint32_t>::type Key;
+
+    RightWinners(const int cols, const int dispRange)
+        : cols_(cols), dispRange_(dispRange), keys_(cols + dispRange - 1) {}
+
+    /**
+     * @brief start a row, no right pixel has a valid cell
+     *
+     */
+    void reset() {
+        std::fill(keys_.begin(), keys_.end(), makeKey(CostTraits<T>::invalid(),
+                                                      dispRange_ - 1));
+    }
+
+    /**
+     * @brief add the costs of a left pixel
+     *
+     * @param x image x-coordinate of the left pixel
+     * @param cost costs of the pixel(cell d at cost[d])
+     * @param dispBegin band begin of the pixel
+     * @param dispEnd band end of the pixel
+     */
+    void add(const int x, const T *cost, const int dispBegin,
+             const int dispEnd) {
+        Key *keys = keys_.data() + cols_ - 1 - x;
+        for (int d = dispBegin; d < dispEnd; ++d) {
+            keys[d] = std::min(keys[d], makeKey(cost[d], d));
+        }
+    }
+
+    /**
+     * @brief add a disparity slice of the left pixels
+     *
+     * @param d disparity index of the slice
+     * @param slice costs of the left pixels at d(pixel x at slice[x])
+     */
+    void addSlice(const int d, const T *slice) {
+        Key *keys = keys_.data() + cols_ - 1 + d;
+        for (int x = 0; x < cols_; ++x) {
+            keys[-x] = std::min(keys[-x], makeKey(slice[x], d));
+        }
+    }
+
+    /**
+     * @brief best disparity of the right pixel a left pixel matches
+     *
+     * @param x image x-coordinate of the left pixel
+     * @param d disparity index of the match
+     * @return int disparity index of the right pixel, -1 if it has no valid
+     * cell
+     */
+    int match(const int x, const int d) const {
+        return keyDisp(keys_[cols_ - 1 - x + d]);
+    }
+
+    /**
+     * @brief disparities of the right pixels of the row
+     *
+     * @param ptrRightDispMap right disparity map row, NONE_PIXEL where a right
+     * pixel has no valid cell
+     * @param minDisp minimum disparity value
+     */
+    void copyTo(float *ptrRightDispMap, const int minDisp) const {
+        for (int x = 0; x < cols_; ++x) {
+            const int k = cols_ - 1 - x - minDisp;
+            const int disp = k >= 0 && k < static_cast<int>(keys_.size())
+                                 ? keyDisp(keys_[k])
+                                 : -1;
+            ptrRightDispMap[x] =
+                disp < 0 ? NONE_PIXEL : static_cast<float>(disp + minDisp);
+        }
+    }
+
+  private:
+    Key makeKey(const T cost, const int d) const {
+        return static_cast<Key>(orderBits(cost)) << 16 |
+               static_cast<Key>(dispRange_ - 1 - d);
+    }
+
+    int keyDisp(const Key key) const {
+        return (key >> 16) == orderBits(CostTraits<T>::invalid())
+                   ? -1
+                   : dispRange_ - 1 - static_cast<int>(key & 0xffff);
+    }
+
+    const int cols_, dispRange_;
+    std::vector<Key> keys_;
+};
+} // namespace wta
+} // namespace libSM
+
+#endif //!__DISP_KERNEL_H_
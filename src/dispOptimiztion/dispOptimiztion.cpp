@@ -1,4 +1,5 @@
 #include "dispOptimiztion.h"
+#include "medianKernel.h"
 
 #include <opencv2/opencv.hpp>
 
@@ -10,7 +11,77 @@ using namespace std;
 namespace libSM {
 
 /**
- * @brief remove small connected domains
+ * @brief image rows of a band of the connected component labelling, the bands
+ * are labelled in parallel and merged along their borders afterwards
+ *
+ */
+static const int CCL_BAND_ROWS = 32;
+
+/**
+ * @brief root of the component of a pixel, the path is compressed
+ *
+ * @param parent parent of every pixel
+ * @param p pixel index
+ * @return int root of the pixel
+ */
+static int findRoot(vector<int> &parent, int p) {
+    int root = p;
+    while (parent[root] != root) {
+        root = parent[root];
+    }
+    while (parent[p] != root) {
+        const int next = parent[p];
+        parent[p] = root;
+        p = next;
+    }
+    return root;
+}
+
+/**
+ * @brief merge the components of two pixels, the smaller root is the root of
+ * the merged component
+ *
+ * @param parent parent of every pixel
+ * @param p pixel index
+ * @param q pixel index
+ */
+static void unite(vector<int> &parent, const int p, const int q) {
+    const int rootP = findRoot(parent, p);
+    const int rootQ = findRoot(parent, q);
+    if (rootP < rootQ) {
+        parent[rootQ] = rootP;
+    } else if (rootQ < rootP) {
+        parent[rootP] = rootQ;
+    }
+}
+
+/**
+ * @brief merge a pixel with its 8-connected neighbours of the row above
+ *
+ * @param dispMap disparity map
+ * @param parent parent of every pixel
+ * @param i image y-coordinate of the pixel, the row above is in the image
+ * @param j image x-coordinate of the pixel
+ * @param dispDomainThreshold parallax map connectivity threshold
+ */
+static void uniteAbove(const Mat &dispMap, vector<int> &parent, const int i,
+                       const int j, const float dispDomainThreshold) {
+    const int cols = dispMap.cols;
+    const float disp = dispMap.ptr<float>(i)[j];
+    auto ptrAbove = dispMap.ptr<float>(i - 1);
+    for (int x = max(j - 1, 0); x <= min(j + 1, cols - 1); ++x) {
+        if (parent[(i - 1) * cols + x] >= 0 &&
+            abs(ptrAbove[x] - disp) < dispDomainThreshold) {
+            unite(parent, i * cols + j, (i - 1) * cols + x);
+        }
+    }
+}
+
+/**
+ * @brief remove small connected domains, the 8-connected components of
+ * similar disparities are labelled by union-find in bands of rows in
+ * parallel, the bands are merged along their borders and the pixels of the
+ * components smaller than the threshold are cleared
  *
  * @param dispMap               //disparity map
  * @param out                   //out disparity map
@@ -26,98 +97,269 @@ void removeSmallArea(const Mat &dispMap, Mat &out,
     if (out.empty())
         out = dispMap.clone();
 
-    vector<bool> visited(dispMap.rows * dispMap.cols, false);
+    const int rows = dispMap.rows, cols = dispMap.cols;
+    const int bands = (rows + CCL_BAND_ROWS - 1) / CCL_BAND_ROWS;
+    // parent of every pixel, -1 for the pixels without a disparity
+    vector<int> parent(static_cast<size_t>(rows) * cols);
 
-    for (int i = 0; i < dispMap.rows; ++i) {
-        auto ptrDispMap = dispMap.ptr<float>(i);
+#pragma omp parallel for schedule(dynamic) default(shared)
+    for (int band = 0; band < bands; ++band) {
+        const int bandBegin = band * CCL_BAND_ROWS;
+        const int bandEnd = min(bandBegin + CCL_BAND_ROWS, rows);
+
+        // the pixels only merge with the pixels of their band, whose roots
+        // are in the band
+        for (int i = bandBegin; i < bandEnd; ++i) {
+            auto ptrDispMap = dispMap.ptr<float>(i);
+            for (int j = 0; j < cols; ++j) {
+                const int p = i * cols + j;
+                if (abs(ptrDispMap[j]) < 0.001f) {
+                    parent[p] = -1;
+                    continue;
+                }
 
-        for (int j = 0; j < dispMap.cols; ++j) {
-            if (visited[dispMap.cols * i + j] || abs(ptrDispMap[j]) < 0.001f) {
-                continue;
+                parent[p] = p;
+                if (j > 0 && parent[p - 1] >= 0 &&
+                    abs(ptrDispMap[j - 1] - ptrDispMap[j]) <
+                        dispDomainThreshold) {
+                    unite(parent, p, p - 1);
+                }
+                if (i > bandBegin) {
+                    uniteAbove(dispMap, parent, i, j, dispDomainThreshold);
+                }
             }
+        }
+    }
 
-            vector<pair<int, int>> area;
-            int areaSize = area.size();
-            area.emplace_back(make_pair(j, i));
-            visited[dispMap.cols * i + j] = true;
-
-            do {
-                int preSize = areaSize;
-                areaSize = area.size();
-
-                for (int k = preSize; k < areaSize; ++k) {
-                    auto curPixelX = area[k].first;
-                    auto curPixelY = area[k].second;
-                    auto curPixelDisp =
-                        dispMap.ptr<float>(curPixelY)[curPixelX];
-
-                    for (int y = -1; y <= 1; ++y) {
-                        for (int x = -1; x <= 1; ++x) {
-                            auto visitPixelX = curPixelX + x;
-                            auto visitPixelY = curPixelY + y;
-
-                            if (visitPixelX < 0 ||
-                                visitPixelX > dispMap.cols - 1 ||
-                                visitPixelY < 0 ||
-                                visitPixelY > dispMap.rows - 1) {
-                                continue;
-                            }
-
-                            if (visited[dispMap.cols * visitPixelY +
-                                        visitPixelX] ||
-                                abs(dispMap.ptr<float>(
-                                    visitPixelY)[visitPixelX]) < 0.001f) {
-                                continue;
-                            }
-
-                            if (abs(dispMap.ptr<float>(
-                                        visitPixelY)[visitPixelX] -
-                                    curPixelDisp) < dispDomainThreshold) {
-                                area.push_back(
-                                    make_pair(visitPixelX, visitPixelY));
-                                visited[dispMap.cols * visitPixelY +
-                                        visitPixelX] = true;
-                            }
-                        }
-                    }
-                }
-            } while (areaSize < area.size());
+    // the border rows of the bands are few, they are merged in turn
+    for (int band = 1; band < bands; ++band) {
+        const int i = band * CCL_BAND_ROWS;
+        for (int j = 0; j < cols; ++j) {
+            if (parent[i * cols + j] >= 0) {
+                uniteAbove(dispMap, parent, i, j, dispDomainThreshold);
+            }
+        }
+    }
 
-            if (area.size() < smallAreaThreshold) {
-                for (auto loc : area) {
-                    out.ptr<float>(loc.second)[loc.first] = NONE_PIXEL;
-                }
+    // the label of every pixel is its root, the parents are only read
+    vector<int> label(parent.size());
+#pragma omp parallel for schedule(static) default(shared)
+    for (int i = 0; i < rows; ++i) {
+        for (int p = i * cols; p < (i + 1) * cols; ++p) {
+            int root = parent[p];
+            while (root >= 0 && parent[root] != root) {
+                root = parent[root];
+            }
+            label[p] = root;
+        }
+    }
+
+    // component sizes, a run of pixels of the same label is counted at once
+    vector<int> &size = parent;
+    std::fill(size.begin(), size.end(), 0);
+#pragma omp parallel for schedule(static) default(shared)
+    for (int i = 0; i < rows; ++i) {
+        const int *ptrLabel = label.data() + i * cols;
+        for (int j = 0; j < cols;) {
+            const int runBegin = j;
+            while (j < cols && ptrLabel[j] == ptrLabel[runBegin]) {
+                ++j;
+            }
+            if (ptrLabel[runBegin] >= 0) {
+#pragma omp atomic
+                size[ptrLabel[runBegin]] += j - runBegin;
+            }
+        }
+    }
+
+#pragma omp parallel for schedule(static) default(shared)
+    for (int i = 0; i < rows; ++i) {
+        const int *ptrLabel = label.data() + i * cols;
+        auto ptrOut = out.ptr<float>(i);
+        for (int j = 0; j < cols; ++j) {
+            if (ptrLabel[j] >= 0 && size[ptrLabel[j]] < smallAreaThreshold) {
+                ptrOut[j] = NONE_PIXEL;
             }
         }
     }
 }
 
 /**
- * @brief median filter for float-type image
+ * @brief bins a pixel of the sliding histogram of the median filter, finer
+ * steps than this are only kept when the values of a bin are all the same
+ *
+ */
+static const float MEDIAN_BINS_PER_PIXEL = 16.f;
+
+/**
+ * @brief the most bins of the sliding histogram of the median filter
+ *
+ */
+static const int MEDIAN_MAX_BINS = 1 << 16;
+
+/**
+ * @brief median filter of the large kernels by a sliding histogram of the
+ * quantized disparities(Huang's algorithm), a window moving one pixel
+ * right drops its left column and adds a new right one, and the median bin
+ * moves from the last one. A bin gives back the smallest disparity of the
+ * map in it, so the median is exact where the disparities of a bin agree,
+ * such as the integer disparities and the invalid pixel values.
  *
  * @param dispMap disparity map
  * @param out filtered disparity map
  * @param k kernel size
  */
-void medianFilter(const Mat &dispMap, Mat &out, const int k) {
+static void medianFilterHistogram(const Mat &dispMap, Mat &out, const int k) {
+    const int rows = dispMap.rows, cols = dispMap.cols;
     const int halfSize = k / 2;
     const int medianIndex = (k * k) / 2;
 
-#pragma omp parallel for schedule(dynamic) default(shared)
-    for (int i = halfSize; i < dispMap.rows - halfSize; ++i) {
-        auto ptrOut = out.ptr<float>(i);
+    vector<float> rowMin(rows), rowMax(rows);
+#pragma omp parallel for schedule(static) default(shared)
+    for (int i = 0; i < rows; ++i) {
+        auto ptrDispMap = dispMap.ptr<float>(i);
+        rowMin[i] = *min_element(ptrDispMap, ptrDispMap + cols);
+        rowMax[i] = *max_element(ptrDispMap, ptrDispMap + cols);
+    }
+    const float minValue = *min_element(rowMin.begin(), rowMin.end());
+    const float maxValue = *max_element(rowMax.begin(), rowMax.end());
+    const float scale = min(MEDIAN_BINS_PER_PIXEL,
+                            (MEDIAN_MAX_BINS - 1) /
+                                max(maxValue - minValue, 1.f));
+    const int bins = static_cast<int>((maxValue - minValue) * scale) + 1;
+
+    // the bin of every pixel and the smallest disparity of every bin
+    Mat binMap(rows, cols, CV_16UC1);
+    vector<float> binValue(bins, maxValue);
+#pragma omp parallel default(shared)
+    {
+        vector<float> localValue(bins, maxValue);
+#pragma omp for schedule(static)
+        for (int i = 0; i < rows; ++i) {
+            auto ptrDispMap = dispMap.ptr<float>(i);
+            auto ptrBinMap = binMap.ptr<uint16_t>(i);
+            for (int j = 0; j < cols; ++j) {
+                const int bin = min(
+                    static_cast<int>((ptrDispMap[j] - minValue) * scale),
+                    bins - 1);
+                ptrBinMap[j] = static_cast<uint16_t>(bin);
+                localValue[bin] = min(localValue[bin], ptrDispMap[j]);
+            }
+        }
+#pragma omp critical
+        for (int bin = 0; bin < bins; ++bin) {
+            binValue[bin] = min(binValue[bin], localValue[bin]);
+        }
+    }
 
-        for (int j = halfSize; j < dispMap.cols - halfSize; ++j) {
-            vector<float> disp;
+#pragma omp parallel default(shared)
+    {
+        vector<int> histogram(bins, 0);
+        // the rows of the window, the ones out of the image are replicated
+        vector<const uint16_t *> windowRows(k);
+
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < rows; ++i) {
+            auto ptrOut = out.ptr<float>(i);
+            for (int y = 0; y < k; ++y) {
+                windowRows[y] = binMap.ptr<uint16_t>(
+                    min(max(i + y - halfSize, 0), rows - 1));
+            }
 
-            for (int y = -halfSize; y <= halfSize; ++y) {
+            for (int y = 0; y < k; ++y) {
                 for (int x = -halfSize; x <= halfSize; ++x) {
-                    disp.emplace_back(dispMap.ptr<float>(i + y)[j + x]);
+                    ++histogram[windowRows[y][min(max(x, 0), cols - 1)]];
                 }
             }
 
-            std::sort(disp.begin(), disp.end());
-            ptrOut[j] = disp[medianIndex];
+            // the median bin and the count of the window below it
+            int medianBin = 0, below = 0;
+            for (int j = 0; j < cols; ++j) {
+                if (j > 0) {
+                    const int dropX = max(j - 1 - halfSize, 0);
+                    const int addX = min(j + halfSize, cols - 1);
+                    for (int y = 0; y < k; ++y) {
+                        const int dropBin = windowRows[y][dropX];
+                        const int addBin = windowRows[y][addX];
+                        --histogram[dropBin];
+                        ++histogram[addBin];
+                        below += (addBin < medianBin) - (dropBin < medianBin);
+                    }
+                }
+
+                while (below > medianIndex) {
+                    --medianBin;
+                    below -= histogram[medianBin];
+                }
+                while (below + histogram[medianBin] <= medianIndex) {
+                    below += histogram[medianBin];
+                    ++medianBin;
+                }
+                ptrOut[j] = binValue[medianBin];
+            }
+
+            // the histogram is left empty for the next row
+            for (int y = 0; y < k; ++y) {
+                for (int x = cols - 1 - halfSize; x <= cols - 1 + halfSize;
+                     ++x) {
+                    --histogram[windowRows[y][min(max(x, 0), cols - 1)]];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief median filter for float-type image, the pixels out of the image are
+ * replicated from the border. The 3 x 3 and 5 x 5 kernels select the median
+ * with a network over many pixels at a time, the larger ones with a sliding
+ * histogram.
+ *
+ * @param dispMap disparity map
+ * @param out filtered disparity map
+ * @param k kernel size(odd)
+ */
+void medianFilter(const Mat &dispMap, Mat &out, const int k) {
+    CV_Assert_N(!dispMap.empty(), dispMap.type() == CV_32FC1, k > 0,
+                k % 2 == 1);
+
+    out.create(dispMap.size(), CV_32FC1);
+    if (k == 1) {
+        dispMap.copyTo(out);
+        return;
+    }
+
+    if (k > 5) {
+        medianFilterHistogram(dispMap, out, k);
+        return;
+    }
+
+    const median::MedianRowFunc medianRow =
+        k == 3 ? median::selectMedianRow<3>() : median::selectMedianRow<5>();
+    const int rows = dispMap.rows, cols = dispMap.cols;
+    const int halfSize = k / 2;
+    const int paddedCols = cols + 2 * halfSize;
+
+#pragma omp parallel default(shared)
+    {
+        // the rows of the window of the output row, padded by the border
+        // pixels on both sides
+        vector<float> window(k * paddedCols);
+        vector<float *> windowRows(k);
+
+#pragma omp for schedule(static)
+        for (int i = 0; i < rows; ++i) {
+            for (int y = 0; y < k; ++y) {
+                auto ptrDispMap =
+                    dispMap.ptr<float>(min(max(i + y - halfSize, 0), rows - 1));
+                float *ptrRow = window.data() + y * paddedCols;
+                std::fill(ptrRow, ptrRow + halfSize, ptrDispMap[0]);
+                std::copy(ptrDispMap, ptrDispMap + cols, ptrRow + halfSize);
+                std::fill(ptrRow + halfSize + cols, ptrRow + paddedCols,
+                          ptrDispMap[cols - 1]);
+                windowRows[y] = ptrRow;
+            }
+            medianRow(windowRows.data(), cols, out.ptr<float>(i));
         }
     }
 }
@@ -35,7 +35,7 @@ struct DispOptParams {
     bool enableDispFill;        // enable fill the background or prospect
     int smallAreaThreshold;     // small area threshild
     int dispDomainThreshold;    // parallax connected domain threshold
-    int k;                      // median filtering filter kernel size
+    int k;                      // median filtering filter kernel size(odd)
     int d;                      // bilateral filtering filter field diameter
     float sigmaColor; // standard deviation of Gaussian function in color space
     float sigmaSpace; // standard deviation of Gaussian function in coordinate
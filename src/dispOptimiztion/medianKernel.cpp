@@ -0,0 +1,292 @@
+#include "medianKernel.h"
+#include "common/cpuFeatures.h"
+
+#ifdef LIBSM_X86
+#include <immintrin.h>
+#endif
+
+namespace libSM {
+namespace median {
+/**
+ * @brief the largest kernel size of the selection networks
+ *
+ */
+static const int MEDIAN_MAX_K = 5;
+
+// sorting networks of the columns, cell y of a column is row y of the window
+#define MEDIAN_SORT_COLUMNS_3(X) X(0, 1) X(0, 2) X(1, 2)
+#define MEDIAN_SORT_COLUMNS_5(X)                                               \
+    X(0, 1) X(2, 3) X(0, 2) X(1, 3) X(1, 2) X(0, 4) X(2, 4) X(1, 2) X(3, 4)
+
+// selection networks of the median of a window of sorted columns, cell
+// x * K + y is row y of column x and the median ends in cell K * K / 2. X
+// sorts two cells, L only keeps the lower and H only the higher one, the
+// comparators whose order the sorted columns already tell are left out.
+#define MEDIAN_NETWORK_3(X, L, H) X(2, 3) X(0, 2) X(4, 6) X(5, 7) X(1, 2)      \
+    X(5, 6) H(0, 4) X(1, 5) L(2, 6) L(3, 7) X(2, 4) L(3, 5) H(1, 2) X(3, 4)    \
+    L(4, 8) H(2, 4) H(3, 4)
+#define MEDIAN_NETWORK_5(X, L, H) X(4, 5) X(14, 15) X(5, 7) X(8, 10) X(9, 11)  \
+    X(12, 14) X(5, 6) X(9, 10) X(13, 14) X(0, 4) X(1, 5) X(2, 6) X(8, 12)      \
+    X(10, 14) X(11, 15) X(16, 20) X(17, 21) X(18, 22) X(19, 23) X(2, 4)        \
+    X(3, 5) X(10, 12) X(11, 13) X(18, 20) X(19, 21) X(1, 2) X(3, 4) X(5, 6)    \
+    X(9, 10) X(11, 12) X(13, 14) X(17, 18) X(19, 20) X(21, 22) X(0, 8)         \
+    X(1, 9) X(2, 10) X(3, 11) X(4, 12) X(5, 13) X(6, 14) L(7, 15) X(4, 8)      \
+    X(5, 9) X(6, 10) X(7, 11) X(20, 24) X(2, 4) X(3, 5) X(6, 8) X(7, 9)        \
+    X(10, 12) X(11, 13) X(19, 21) X(22, 24) X(1, 2) X(3, 4) X(5, 6) X(7, 8)    \
+    X(9, 10) X(11, 12) L(13, 14) X(21, 22) X(23, 24) H(0, 16) H(1, 17)         \
+    H(2, 18) H(3, 19) H(4, 20) H(5, 21) L(6, 22) L(7, 23) L(8, 24) H(8, 16)    \
+    H(9, 17) L(10, 18) L(11, 19) L(12, 20) L(13, 21) H(6, 10) H(7, 11)         \
+    L(12, 16) L(13, 17) H(10, 12) L(11, 13) H(11, 12)
+// the comparators on the cells of an array v
+#define MEDIAN_SORT(a, b)                                                      \
+    {                                                                          \
+        const auto low = minValue(v[a], v[b]);                                 \
+        v[b] = maxValue(v[a], v[b]);                                           \
+        v[a] = low;                                                            \
+    }
+#define MEDIAN_LOW(a, b) v[a] = minValue(v[a], v[b]);
+#define MEDIAN_HIGH(a, b) v[b] = maxValue(v[a], v[b]);
+
+/**
+ * @brief minimum and maximum of the same choice as the vector instructions,
+ * the second value unless the first one is lower or higher, so that all the
+ * kernels give the same bits
+ *
+ */
+static inline float minValue(const float a, const float b) {
+    return a < b ? a : b;
+}
+static inline float maxValue(const float a, const float b) {
+    return a > b ? a : b;
+}
+
+/**
+ * @brief sort the columns of the padded rows
+ *
+ * @tparam K kernel size
+ * @param rows padded rows of the windows
+ * @param begin first column
+ * @param end column end
+ */
+template <int K>
+static void sortColumns(float *const *rows, const int begin, const int end) {
+    for (int x = begin; x < end; ++x) {
+        float v[MEDIAN_MAX_K];
+        for (int y = 0; y < K; ++y) {
+            v[y] = rows[y][x];
+        }
+        if (K == 3) {
+            MEDIAN_SORT_COLUMNS_3(MEDIAN_SORT)
+        } else {
+            MEDIAN_SORT_COLUMNS_5(MEDIAN_SORT)
+        }
+        for (int y = 0; y < K; ++y) {
+            rows[y][x] = v[y];
+        }
+    }
+}
+
+/**
+ * @brief median of the windows of pixels of a row, the columns are sorted
+ *
+ * @tparam K kernel size
+ * @param rows padded rows of the windows
+ * @param begin first pixel
+ * @param end pixel end
+ * @param out median of every pixel
+ */
+template <int K>
+static void selectPixels(float *const *rows, const int begin, const int end,
+                         float *out) {
+    for (int j = begin; j < end; ++j) {
+        float v[MEDIAN_MAX_K * MEDIAN_MAX_K];
+        for (int x = 0; x < K; ++x) {
+            for (int y = 0; y < K; ++y) {
+                v[x * K + y] = rows[y][j + x];
+            }
+        }
+        if (K == 3) {
+            MEDIAN_NETWORK_3(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        } else {
+            MEDIAN_NETWORK_5(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        }
+        out[j] = v[K * K / 2];
+    }
+}
+
+template <int K>
+static void medianRow(float *const *rows, const int cols, float *out) {
+    sortColumns<K>(rows, 0, cols + K - 1);
+    selectPixels<K>(rows, 0, cols, out);
+}
+
+#ifdef LIBSM_X86
+LIBSM_TARGET_SSE42 static inline __m128 minValue(const __m128 a,
+                                                 const __m128 b) {
+    return _mm_min_ps(a, b);
+}
+LIBSM_TARGET_SSE42 static inline __m128 maxValue(const __m128 a,
+                                                 const __m128 b) {
+    return _mm_max_ps(a, b);
+}
+
+template <int K>
+LIBSM_TARGET_SSE42 static void medianRowSSE42(float *const *rows,
+                                              const int cols, float *out) {
+    const int paddedCols = cols + K - 1;
+    int x = 0;
+    for (; x + 4 <= paddedCols; x += 4) {
+        __m128 v[MEDIAN_MAX_K];
+        for (int y = 0; y < K; ++y) {
+            v[y] = _mm_loadu_ps(rows[y] + x);
+        }
+        if (K == 3) {
+            MEDIAN_SORT_COLUMNS_3(MEDIAN_SORT)
+        } else {
+            MEDIAN_SORT_COLUMNS_5(MEDIAN_SORT)
+        }
+        for (int y = 0; y < K; ++y) {
+            _mm_storeu_ps(rows[y] + x, v[y]);
+        }
+    }
+    sortColumns<K>(rows, x, paddedCols);
+
+    int j = 0;
+    for (; j + 4 <= cols; j += 4) {
+        __m128 v[MEDIAN_MAX_K * MEDIAN_MAX_K];
+        for (int dx = 0; dx < K; ++dx) {
+            for (int y = 0; y < K; ++y) {
+                v[dx * K + y] = _mm_loadu_ps(rows[y] + j + dx);
+            }
+        }
+        if (K == 3) {
+            MEDIAN_NETWORK_3(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        } else {
+            MEDIAN_NETWORK_5(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        }
+        _mm_storeu_ps(out + j, v[K * K / 2]);
+    }
+    selectPixels<K>(rows, j, cols, out);
+}
+
+LIBSM_TARGET_AVX2 static inline __m256 minValue(const __m256 a,
+                                                const __m256 b) {
+    return _mm256_min_ps(a, b);
+}
+LIBSM_TARGET_AVX2 static inline __m256 maxValue(const __m256 a,
+                                                const __m256 b) {
+    return _mm256_max_ps(a, b);
+}
+
+template <int K>
+LIBSM_TARGET_AVX2 static void medianRowAVX2(float *const *rows,
+                                            const int cols, float *out) {
+    const int paddedCols = cols + K - 1;
+    int x = 0;
+    for (; x + 8 <= paddedCols; x += 8) {
+        __m256 v[MEDIAN_MAX_K];
+        for (int y = 0; y < K; ++y) {
+            v[y] = _mm256_loadu_ps(rows[y] + x);
+        }
+        if (K == 3) {
+            MEDIAN_SORT_COLUMNS_3(MEDIAN_SORT)
+        } else {
+            MEDIAN_SORT_COLUMNS_5(MEDIAN_SORT)
+        }
+        for (int y = 0; y < K; ++y) {
+            _mm256_storeu_ps(rows[y] + x, v[y]);
+        }
+    }
+    _mm256_zeroupper();
+    sortColumns<K>(rows, x, paddedCols);
+
+    int j = 0;
+    for (; j + 8 <= cols; j += 8) {
+        __m256 v[MEDIAN_MAX_K * MEDIAN_MAX_K];
+        for (int dx = 0; dx < K; ++dx) {
+            for (int y = 0; y < K; ++y) {
+                v[dx * K + y] = _mm256_loadu_ps(rows[y] + j + dx);
+            }
+        }
+        if (K == 3) {
+            MEDIAN_NETWORK_3(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        } else {
+            MEDIAN_NETWORK_5(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        }
+        _mm256_storeu_ps(out + j, v[K * K / 2]);
+    }
+    _mm256_zeroupper();
+    selectPixels<K>(rows, j, cols, out);
+}
+
+LIBSM_TARGET_AVX512 static inline __m512 minValue(const __m512 a,
+                                                  const __m512 b) {
+    return _mm512_min_ps(a, b);
+}
+LIBSM_TARGET_AVX512 static inline __m512 maxValue(const __m512 a,
+                                                  const __m512 b) {
+    return _mm512_max_ps(a, b);
+}
+
+template <int K>
+LIBSM_TARGET_AVX512 static void medianRowAVX512(float *const *rows,
+                                                const int cols, float *out) {
+    const int paddedCols = cols + K - 1;
+    int x = 0;
+    for (; x + 16 <= paddedCols; x += 16) {
+        __m512 v[MEDIAN_MAX_K];
+        for (int y = 0; y < K; ++y) {
+            v[y] = _mm512_loadu_ps(rows[y] + x);
+        }
+        if (K == 3) {
+            MEDIAN_SORT_COLUMNS_3(MEDIAN_SORT)
+        } else {
+            MEDIAN_SORT_COLUMNS_5(MEDIAN_SORT)
+        }
+        for (int y = 0; y < K; ++y) {
+            _mm512_storeu_ps(rows[y] + x, v[y]);
+        }
+    }
+    _mm256_zeroupper();
+    sortColumns<K>(rows, x, paddedCols);
+
+    int j = 0;
+    for (; j + 16 <= cols; j += 16) {
+        __m512 v[MEDIAN_MAX_K * MEDIAN_MAX_K];
+        for (int dx = 0; dx < K; ++dx) {
+            for (int y = 0; y < K; ++y) {
+                v[dx * K + y] = _mm512_loadu_ps(rows[y] + j + dx);
+            }
+        }
+        if (K == 3) {
+            MEDIAN_NETWORK_3(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        } else {
+            MEDIAN_NETWORK_5(MEDIAN_SORT, MEDIAN_LOW, MEDIAN_HIGH)
+        }
+        _mm512_storeu_ps(out + j, v[K * K / 2]);
+    }
+    _mm256_zeroupper();
+    selectPixels<K>(rows, j, cols, out);
+}
+#endif
+
+template <int K> MedianRowFunc selectMedianRow() {
+#ifdef LIBSM_X86
+    switch (currentSimdLevel()) {
+    case SimdLevel::AVX512:
+        return medianRowAVX512<K>;
+    case SimdLevel::AVX2:
+        return medianRowAVX2<K>;
+    case SimdLevel::SSE42:
+        return medianRowSSE42<K>;
+    default:
+        break;
+    }
+#endif
+    return medianRow<K>;
+}
+
+template MedianRowFunc selectMedianRow<3>();
+template MedianRowFunc selectMedianRow<5>();
+} // namespace median
+} // namespace libSM
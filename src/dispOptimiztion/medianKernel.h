@@ -0,0 +1,42 @@
+/**
+ * @file medianKernel.h
+ * @author Liu Yunhuang (1369215984@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-03-24
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __MEDIAN_KERNEL_H_
+#define __MEDIAN_KERNEL_H_
+
+#include <typeDef.h>
+
+namespace libSM {
+namespace median {
+/**
+ * @brief median of the K x K windows of an image row. The K rows of the
+ * windows are padded by K / 2 pixels on both sides, the columns of the rows
+ * are sorted in place first, so that a selection network of the sorted
+ * columns gives the median of a window.
+ *
+ * @param rows the K padded rows of the windows, cols + K - 1 pixels each
+ * @param cols image cols
+ * @param out median of the window of every pixel of the row
+ */
+typedef void (*MedianRowFunc)(float *const *rows, int cols, float *out);
+
+/**
+ * @brief median row kernel of the instruction set level in use, the windows
+ * of as many pixels as a vector holds are selected at once
+ *
+ * @tparam K kernel size(3 or 5)
+ * @return MedianRowFunc kernel
+ */
+template <int K> MedianRowFunc selectMedianRow();
+} // namespace median
+} // namespace libSM
+
+#endif //!__MEDIAN_KERNEL_H_
@@ -1,6 +1,7 @@
 #include "sgm.h"
 #include "costCompute/censusCost.h"
 #include "costAggregation/multipathAggregation.h"
+#include "costAggregation/memoryEfficientAggregation.h"
 #include "dispCompute/dispCompute.h"
 #include "dispOptimiztion/dispOptimiztion.h"
 
@@ -19,11 +20,33 @@ class SGMImpl : public SGM {
     SGMImpl(const Params params) : params_(params) {}
     void match(const cv::Mat &left, const cv::Mat &right,
                cv::Mat &dispMap) override;
+    void match(const cv::Mat &left, const cv::Mat &right, cv::Mat &dispMap,
+               cv::Mat &confidenceMap) override;
   private:
+    /**
+     * @brief perform stereo matching
+     *
+     * @param left left image
+     * @param right right image
+     * @param dispMap disparity Map
+     * @param confidenceMap confidence map, nullptr if not wanted
+     */
+    void matchImpl(const cv::Mat &left, const cv::Mat &right,
+                   cv::Mat &dispMap, cv::Mat *confidenceMap);
     Params params_;
 };
 
 void SGMImpl::match(const cv::Mat &left, const cv::Mat &right, cv::Mat &dispMap) {
+    matchImpl(left, right, dispMap, nullptr);
+}
+
+void SGMImpl::match(const cv::Mat &left, const cv::Mat &right,
+                    cv::Mat &dispMap, cv::Mat &confidenceMap) {
+    matchImpl(left, right, dispMap, &confidenceMap);
+}
+
+void SGMImpl::matchImpl(const cv::Mat &left, const cv::Mat &right,
+                        cv::Mat &dispMap, cv::Mat *confidenceMap) {
     CV_Assert_N(!left.empty(), !right.empty(), left.type() == CV_8UC1 || left.type() == CV_8UC3, right.type() == CV_8UC1 || right.type() == CV_8UC3);
 
     Mat leftProcess, rightProcess;
@@ -38,53 +61,91 @@ void SGMImpl::match(const cv::Mat &left, const cv::Mat &right, cv::Mat &dispMap)
     else
         rightProcess = right;
     
-    //cost compute
-    Mat cost;
-    {
-        auto params = CensusCost::Params();
-        params.windowWidth = params_.windowWidth;
-        params.windowHeight = params_.windowHeight;
-        params.minDisp = params_.minDisp;
-        params.maxDisp = params_.maxDisp;
-
-        auto adCensusComputer = CensusCost::create(params);
-        adCensusComputer->compute(leftProcess, rightProcess, cost);
-    }
+    auto dispParams = DispComputeParams();
+    dispParams.enableLRCheck = params_.enableLRCheck;
+    dispParams.enableUniqueCheck = params_.enableUniqueCheck;
+    dispParams.enableSubpixelFitting = params_.enableSubpixelFitting;
+    dispParams.lrCheckThreshod = params_.lrCheckThreshod;
+    dispParams.uniquenessRatio = params_.uniquenessRatio;
+    dispParams.minDisp = params_.minDisp;
+    dispParams.maxDisp = params_.maxDisp;
+    dispParams.confidenceType = params_.confidenceType;
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = params_.windowWidth;
+    costParams.windowHeight = params_.windowHeight;
+    costParams.minDisp = params_.minDisp;
+    costParams.maxDisp = params_.maxDisp;
+    costParams.costType = CV_8U;
 
-    //cost aggregation
-    Mat aggregatedCost;
-    {
-        auto params = MultipathAggregation::Params();
+    Mat disp;
+    if (params_.enableMemoryEfficient) {
+        // cost, aggregation and disparity compute strip by strip
+        auto params = MemoryEfficientAggregation::Params();
         params.P1 = params_.P1;
         params.P2 = params_.P2;
+        params.penaltyModel = params_.penaltyModel;
         params.enableHonrizon = params_.enableHonrizon;
-        params.enableVertiacl = params.enableVertiacl;
+        params.enableVertiacl = params_.enableVertiacl;
         params.enableNegtive45 = params_.enableNegtive45;
         params.enablePostive45 = params_.enablePostive45;
 
-        auto multipathAggregator = MultipathAggregation::create(params);
-        multipathAggregator->aggregation(leftProcess, cost, aggregatedCost);
+        auto censusComputer = CensusCost::create(costParams);
+        auto memoryEfficientAggregator =
+            MemoryEfficientAggregation::create(params);
+        if (confidenceMap != nullptr) {
+            memoryEfficientAggregator->aggregation(
+                leftProcess, rightProcess, *censusComputer, disp,
+                *confidenceMap, dispParams);
+        } else {
+            memoryEfficientAggregator->aggregation(
+                leftProcess, rightProcess, *censusComputer, disp, dispParams);
+        }
+    } else {
+        //cost compute
+        Mat cost;
+        {
+            auto adCensusComputer = CensusCost::create(costParams);
+            adCensusComputer->compute(leftProcess, rightProcess, cost);
+        }
+
+        //cost aggregation and disparity compute
+        {
+            auto params = MultipathAggregation::Params();
+            params.P1 = params_.P1;
+            params.P2 = params_.P2;
+            params.penaltyModel = params_.penaltyModel;
+            params.enableHonrizon = params_.enableHonrizon;
+            params.enableVertiacl = params_.enableVertiacl;
+            params.enableNegtive45 = params_.enableNegtive45;
+            params.enablePostive45 = params_.enablePostive45;
+            params.enableKnightMove = params_.enableKnightMove;
+
+            auto multipathAggregator =
+                std::static_pointer_cast<MultipathAggregation>(
+                    MultipathAggregation::create(params));
+            if (params_.enableFusedWTA && confidenceMap != nullptr) {
+                multipathAggregator->aggregation(leftProcess, cost, disp,
+                                                 *confidenceMap, dispParams);
+            } else if (params_.enableFusedWTA) {
+                multipathAggregator->aggregation(leftProcess, cost, disp,
+                                                 dispParams);
+            } else {
+                Mat aggregatedCost;
+                multipathAggregator->aggregation(leftProcess, cost,
+                                                 aggregatedCost);
+                cost.release();
+                if (confidenceMap != nullptr) {
+                    Mat rightDisp;
+                    winnerTakesAll(aggregatedCost, disp, rightDisp,
+                                   *confidenceMap, dispParams);
+                } else {
+                    winnerTakesAll(aggregatedCost, disp, dispParams);
+                }
+            }
+        }
     }
 
-    cost.release();
-
-    //disparity compute
-    Mat disp;
-    {
-        auto params = DispComputeParams();
-        params.enableLRCheck = params_.enableLRCheck;
-        params.enableUniqueCheck = params_.enableUniqueCheck;
-        params.enableSubpixelFitting = params_.enableSubpixelFitting;
-        params.lrCheckThreshod = params_.lrCheckThreshod;
-        params.uniquenessRatio = params_.uniquenessRatio;
-        params.minDisp = params_.minDisp;
-        params.maxDisp = params_.maxDisp;
-
-        winnerTakesAll(aggregatedCost, disp, params);
-    }
-
-    aggregatedCost.release();
-
     //disparity optimiztion
     {
         auto params = DispOptParams();
@@ -13,6 +13,8 @@
 #define __SGM_H_
 
 #include "algorithm.h"
+#include "costAggregation/penaltyModel.h"
+#include "dispCompute/dispCompute.h"
 
 namespace cv {
 class Mat;
@@ -37,18 +39,28 @@ class LIBSM_API SGM : public Algorithm {
     struct Params {
         Params()
             : enableHonrizon(true), enableVertiacl(true), enablePostive45(true),
-              enableNegtive45(true), enableBilateralFilter(false),
+              enableNegtive45(true), enableKnightMove(false),
+              enableMemoryEfficient(false), enableFusedWTA(true),
+              enableBilateralFilter(false),
               enableRemoveSmallArea(true), enableLRCheck(true),
               enableUniqueCheck(true), enableSubpixelFitting(true),
               enableMedianFilter(true), enableDispFill(true), windowWidth(9),
               windowHeight(7), minDisp(0), maxDisp(64), P1(10), P2(150),
               lrCheckThreshod(1), uniquenessRatio(0.95), smallAreaThreshold(20),
               dispDomainThreshold(1), k(3), d(10), sigmaColor(10),
-              sigmaSpace(10) {}
+              sigmaSpace(10), confidenceType(ConfidenceType::PeakRatio) {}
         bool enableHonrizon;        // enable aggregation on horizontal line
         bool enableVertiacl;        // enable aggregation on vertical line
         bool enablePostive45;       // enable aggregation on postive 45 line
         bool enableNegtive45;       // enable aggregation on negtive 45 line
+        bool enableKnightMove;      // enable aggregation on the 22.5 and 67.5
+                                    // degree lines(16 paths in total)
+        bool enableMemoryEfficient; // aggregation and winner-takes-all in
+                                    // two passes over cost strips(eSGM),
+                                    // without the knight-move paths
+        bool enableFusedWTA;        // winner-takes-all in the last
+                                    // aggregation direction, without storing
+                                    // the sum of all the paths
         bool enableBilateralFilter; // enable bilateral filter
         bool enableRemoveSmallArea; // enable remove small area
         bool enableLRCheck;         // left-right consistency check
@@ -62,6 +74,9 @@ class LIBSM_API SGM : public Algorithm {
         int maxDisp;                // maximum disparity value.
         float P1;            // penalty coefficient for disparity continuity
         float P2;            // penalty coefficient for disparity no continuity
+        Ptr<PenaltyModel> penaltyModel; // penalty of disparity changes larger
+                                        // than one pixel, the inverse
+                                        // gradient model of P1 and P2 if empty
         int lrCheckThreshod; // left and right consistency threshold
         float uniquenessRatio;   // uniqueness ratio
         int smallAreaThreshold;  // small area threshild
@@ -72,6 +87,7 @@ class LIBSM_API SGM : public Algorithm {
                           // space
         float sigmaSpace; // standard deviation of Gaussian function in
                           // coordinate space
+        ConfidenceType confidenceType; // measure of the confidence map
     };
     virtual ~SGM() {}
     /**
@@ -90,6 +106,19 @@ class LIBSM_API SGM : public Algorithm {
      */
     virtual void match(IN const cv::Mat &left, IN const cv::Mat &right,
                        OUT cv::Mat &dispMap) override = 0;
+    /**
+     * @brief perform stereo matching and give the confidence of every
+     * disparity, taken from the aggregated costs the disparity is picked from
+     *
+     * @param left left image
+     * @param right right image
+     * @param dispMap disparity Map
+     * @param confidenceMap confidence map(CV_32F) of params.confidenceType
+     * before the disparity optimization, 0 where the checks reject the
+     * disparity
+     */
+    virtual void match(IN const cv::Mat &left, IN const cv::Mat &right,
+                       OUT cv::Mat &dispMap, OUT cv::Mat &confidenceMap) = 0;
 };
 } // namespace libSM
 
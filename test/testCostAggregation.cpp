@@ -92,4 +92,948 @@ TEST_F(Cones, testMultipathAggregation) {
     }
 
     ASSERT_LE(abs(disp.ptr<float>(301)[308] - 40), 1.f);
-}
\ No newline at end of file
+}
+
+TEST_F(Cones, testMultipathAggregationCompact) {
+    transformToGray();
+
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 64;
+        params.costType = CV_8U;
+
+        auto censusComputer = CensusCost::create(params);
+        censusComputer->compute(left, right, cost);
+    }
+
+    Mat aggregatedCost;
+    {
+        auto params = MultipathAggregation::Params();
+        params.P1 = 10.f;
+        params.P2 = 150.f;
+
+        auto multipathAggregator = MultipathAggregation::create(params);
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+    }
+
+    ASSERT_EQ(aggregatedCost.depth(), CV_16U);
+
+    Mat disp;
+    {
+        auto params = DispComputeParams();
+        params.lrCheckThreshod = 1;
+        params.uniquenessRatio = 0.95f;
+        params.minDisp = 0;
+        params.maxDisp = 64;
+
+        winnerTakesAll(aggregatedCost, disp, params);
+    }
+
+    ASSERT_LE(abs(disp.ptr<float>(301)[308] - 40), 1.f);
+}
+
+TEST_F(Cones, testMultipathAggregationVolumeLayout) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 64;
+    costParams.costType = CV_16U;
+    auto censusComputer = CensusCost::create(costParams);
+
+    Mat cost;
+    censusComputer->compute(left, right, cost);
+
+    auto params = MultipathAggregation::Params();
+    params.P1 = 10.f;
+    params.P2 = 150.f;
+    auto multipathAggregator = MultipathAggregation::create(params);
+
+    Mat aggregatedCost;
+    multipathAggregator->aggregation(left, cost, aggregatedCost);
+
+    const CostLayout layouts[] = {CostLayout::PixelMajor,
+                                  CostLayout::DispMajor};
+    for (const CostLayout inLayout : layouts) {
+        CostVolume volume(inLayout);
+        censusComputer->compute(left, right, volume);
+
+        for (const CostLayout outLayout : layouts) {
+            CostVolume aggregatedVolume(outLayout);
+            multipathAggregator->aggregation(left, volume, aggregatedVolume);
+            ASSERT_EQ(aggregatedVolume.layout(), outLayout);
+
+            Mat back;
+            aggregatedVolume.copyTo(back);
+            ASSERT_EQ(back.type(), aggregatedCost.type());
+            ASSERT_EQ(memcmp(back.data, aggregatedCost.data,
+                             aggregatedCost.total() *
+                                 aggregatedCost.elemSize()),
+                      0);
+        }
+    }
+}
+
+TEST_F(Cones, testMultipathAggregationRagged) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 64;
+    auto censusComputer = CensusCost::create(costParams);
+    auto multipathAggregator =
+        MultipathAggregation::create(MultipathAggregation::Params());
+
+    auto dispParams = DispComputeParams();
+    dispParams.minDisp = 0;
+    dispParams.maxDisp = 64;
+
+    // the full search range gives the dense results
+    {
+        Mat cost, aggregatedCost, disp;
+        censusComputer->compute(left, right, cost);
+        multipathAggregator->aggregation(left, cost, aggregatedCost);
+        winnerTakesAll(aggregatedCost, disp, dispParams);
+
+        CostVolume volume(CostLayout::Ragged), aggregatedVolume(
+                                                   CostLayout::Ragged);
+        volume.create(left.rows, left.cols, 64, CV_32F);
+        censusComputer->compute(left, right, volume);
+        multipathAggregator->aggregation(left, volume, aggregatedVolume);
+        ASSERT_EQ(aggregatedVolume.layout(), CostLayout::Ragged);
+
+        Mat back, dispVolume;
+        aggregatedVolume.copyTo(back);
+        ASSERT_EQ(memcmp(back.data, aggregatedCost.data,
+                         aggregatedCost.total() * aggregatedCost.elemSize()),
+                  0);
+
+        winnerTakesAll(aggregatedVolume, dispVolume, dispParams);
+        ASSERT_EQ(
+            memcmp(disp.data, dispVolume.data, disp.total() * disp.elemSize()),
+            0);
+    }
+
+    // per-row search ranges, the upper rows only search the far half
+    Mat searchRange(left.rows, 1, CV_32SC2);
+    for (int i = 0; i < left.rows; ++i) {
+        searchRange.ptr<int>(i)[0] = i < left.rows / 2 ? 0 : 16;
+        searchRange.ptr<int>(i)[1] = i < left.rows / 2 ? 48 : 64;
+    }
+
+    Mat bands;
+    searchRangeBands(searchRange, left.rows, left.cols, 0, 64, bands);
+    CostVolume volume(CostLayout::Ragged), aggregatedVolume(CostLayout::Ragged);
+    volume.create(bands, 64, CV_32F);
+    censusComputer->compute(left, right, volume);
+    multipathAggregator->aggregation(left, volume, aggregatedVolume);
+
+    Mat disp;
+    dispParams.enableSubpixelFitting = false;
+    winnerTakesAll(aggregatedVolume, disp, dispParams);
+
+    for (int i = 0; i < disp.rows; ++i) {
+        for (int j = 0; j < disp.cols; ++j) {
+            const float val = disp.ptr<float>(i)[j];
+            if (IS_NONE_PIXEL(val) || IS_OCCLUDED_PIXEL(val) ||
+                IS_MISMATCHED_PIXEL(val)) {
+                continue;
+            }
+            ASSERT_GE(val, searchRange.ptr<int>(i)[0]);
+            ASSERT_LT(val, searchRange.ptr<int>(i)[1]);
+        }
+    }
+
+    ASSERT_LE(abs(disp.ptr<float>(301)[308] - 40), 1.f);
+}
+
+TEST_F(Cones, testMultipathAggregationValidBand) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 64;
+    costParams.costType = CV_16U;
+
+    // an unallocated ragged volume only stores the valid cells
+    CostVolume cost(CostLayout::Ragged);
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    CostVolume aggregatedCost(CostLayout::Ragged);
+    MultipathAggregation::create(MultipathAggregation::Params())
+        ->aggregation(left, cost, aggregatedCost);
+
+    // no path runs through an invalid cell, so nothing saturates
+    for (int i = 0; i < cost.rows(); ++i) {
+        for (int j = 0; j < cost.cols(); ++j) {
+            for (int d = cost.dispBegin(i, j); d < cost.dispEnd(i, j); ++d) {
+                ASSERT_LT(cost.at<uint16_t>(i, j, d), 65535);
+                ASSERT_LT(aggregatedCost.at<uint16_t>(i, j, d), 65535);
+            }
+        }
+    }
+
+    Mat disp;
+    {
+        auto params = DispComputeParams();
+        params.minDisp = 0;
+        params.maxDisp = 64;
+        winnerTakesAll(aggregatedCost, disp, params);
+    }
+
+    ASSERT_TRUE(IS_NONE_PIXEL(disp.ptr<float>(0)[308]));
+    ASSERT_LE(abs(disp.ptr<float>(301)[308] - 40), 1.f);
+}
+
+TEST_F(Cones, testMultipathAggregationSimdExact) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    // not a multiple of the vector widths, so the tails are covered
+    costParams.maxDisp = 70;
+
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    costParams.costType = CV_16U;
+    CostVolume raggedCost(CostLayout::Ragged);
+    CensusCost::create(costParams)->compute(left, right, raggedCost);
+
+    auto aggregator =
+        MultipathAggregation::create(MultipathAggregation::Params());
+
+    setMaxSimdLevel(SimdLevel::Scalar);
+    Mat reference;
+    aggregator->aggregation(left, cost, reference);
+    CostVolume raggedReference(CostLayout::Ragged);
+    aggregator->aggregation(left, raggedCost, raggedReference);
+
+    const auto detected = detectSimdLevel();
+    for (int level = 1; level <= static_cast<int>(detected); ++level) {
+        setMaxSimdLevel(static_cast<SimdLevel>(level));
+
+        Mat aggregatedCost;
+        aggregator->aggregation(left, cost, aggregatedCost);
+
+        int mismatched = 0;
+        for (int i = 0; i < cost.rows; ++i) {
+            mismatched += memcmp(aggregatedCost.ptr(i), reference.ptr(i),
+                                 cost.cols * aggregatedCost.elemSize()) != 0;
+        }
+        EXPECT_EQ(mismatched, 0) << "simd level " << level;
+
+        CostVolume raggedAggregatedCost(CostLayout::Ragged);
+        aggregator->aggregation(left, raggedCost, raggedAggregatedCost);
+
+        mismatched = 0;
+        for (int i = 0; i < raggedCost.rows(); ++i) {
+            for (int j = 0; j < raggedCost.cols(); ++j) {
+                for (int d = raggedCost.dispBegin(i, j);
+                     d < raggedCost.dispEnd(i, j); ++d) {
+                    mismatched +=
+                        raggedAggregatedCost.at<uint16_t>(i, j, d) !=
+                        raggedReference.at<uint16_t>(i, j, d);
+                }
+            }
+        }
+        EXPECT_EQ(mismatched, 0) << "ragged, simd level " << level;
+    }
+
+    setMaxSimdLevel(SimdLevel::AVX512);
+}
+
+TEST_F(Cones, testMultipathAggregationInPlace) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 64;
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    Mat reference;
+    MultipathAggregation::create(MultipathAggregation::Params())
+        ->aggregation(left, cost, reference);
+
+    // the paths add into the same volume, which has to be the sum of the
+    // directions aggregated one at a time
+    Mat sum(cost.size(), CV_MAKETYPE(CV_32S, cost.channels()), Scalar(0));
+    for (int direction = 0; direction < 4; ++direction) {
+        auto params = MultipathAggregation::Params();
+        params.enableHonrizon = direction == 0;
+        params.enableVertiacl = direction == 1;
+        params.enablePostive45 = direction == 2;
+        params.enableNegtive45 = direction == 3;
+
+        Mat aggregatedCost;
+        MultipathAggregation::create(params)->aggregation(left, cost,
+                                                           aggregatedCost);
+        ASSERT_EQ(aggregatedCost.depth(), CV_16U);
+
+        for (int i = 0; i < cost.rows; ++i) {
+            const uint16_t *ptrAggregatedCost =
+                aggregatedCost.ptr<uint16_t>(i);
+            int *ptrSum = sum.ptr<int>(i);
+            for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+                ptrSum[k] += ptrAggregatedCost[k];
+            }
+        }
+    }
+
+    int mismatched = 0;
+    for (int i = 0; i < cost.rows; ++i) {
+        const uint16_t *ptrReference = reference.ptr<uint16_t>(i);
+        const int *ptrSum = sum.ptr<int>(i);
+        for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+            mismatched += ptrReference[k] != min(ptrSum[k], USHRT_MAX);
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+}
+
+TEST_F(Cones, testMultipathAggregationConcurrent) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 64;
+    costParams.costType = CV_16U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+    CostVolume raggedCost(CostLayout::Ragged);
+    CensusCost::create(costParams)->compute(left, right, raggedCost);
+
+    // the directions going the same way are swept at the same time, every
+    // line on its own adds the same path costs
+    auto params = MultipathAggregation::Params();
+    params.enableKnightMove = true;
+    Mat aggregatedCost;
+    CostVolume raggedAggregatedCost(CostLayout::Ragged);
+    MultipathAggregation::create(params)->aggregation(left, cost,
+                                                       aggregatedCost);
+    MultipathAggregation::create(params)->aggregation(left, raggedCost,
+                                                       raggedAggregatedCost);
+
+    Mat reference(cost.size(), CV_MAKETYPE(CV_32S, cost.channels()),
+                  Scalar(0));
+    Mat raggedReference = reference.clone();
+    for (int line = 0; line < 5; ++line) {
+        auto lineParams = MultipathAggregation::Params();
+        lineParams.enableHonrizon = line == 0;
+        lineParams.enableVertiacl = line == 1;
+        lineParams.enablePostive45 = line == 2;
+        lineParams.enableNegtive45 = line == 3;
+        lineParams.enableKnightMove = line == 4;
+        auto aggregator = MultipathAggregation::create(lineParams);
+
+        Mat lineCost;
+        aggregator->aggregation(left, cost, lineCost);
+        for (int i = 0; i < cost.rows; ++i) {
+            const uint16_t *ptrLineCost = lineCost.ptr<uint16_t>(i);
+            int *ptrReference = reference.ptr<int>(i);
+            for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+                ptrReference[k] += ptrLineCost[k];
+            }
+        }
+
+        CostVolume raggedLineCost(CostLayout::Ragged);
+        aggregator->aggregation(left, raggedCost, raggedLineCost);
+        for (int i = 0; i < raggedCost.rows(); ++i) {
+            for (int j = 0; j < raggedCost.cols(); ++j) {
+                int *ptrReference =
+                    raggedReference.ptr<int>(i) + j * cost.channels();
+                for (int d = raggedCost.dispBegin(i, j);
+                     d < raggedCost.dispEnd(i, j); ++d) {
+                    ptrReference[d] += raggedLineCost.at<uint16_t>(i, j, d);
+                }
+            }
+        }
+    }
+
+    // the invalid costs out of the image saturate the sums
+    int mismatched = 0;
+    for (int i = 0; i < cost.rows; ++i) {
+        const uint16_t *ptrAggregatedCost = aggregatedCost.ptr<uint16_t>(i);
+        const int *ptrReference = reference.ptr<int>(i);
+        for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+            mismatched += ptrAggregatedCost[k] !=
+                          min(ptrReference[k], USHRT_MAX);
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+
+    mismatched = 0;
+    for (int i = 0; i < raggedCost.rows(); ++i) {
+        for (int j = 0; j < raggedCost.cols(); ++j) {
+            const int *ptrReference =
+                raggedReference.ptr<int>(i) + j * cost.channels();
+            for (int d = raggedCost.dispBegin(i, j);
+                 d < raggedCost.dispEnd(i, j); ++d) {
+                mismatched += raggedAggregatedCost.at<uint16_t>(i, j, d) !=
+                              ptrReference[d];
+            }
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+}
+
+TEST_F(Cones, testMultipathAggregationFusedWTA) {
+    transformToGray();
+
+    for (const int costType : {CV_8U, CV_32F}) {
+        auto costParams = CensusCost::Params();
+        costParams.windowWidth = 9;
+        costParams.windowHeight = 7;
+        costParams.minDisp = 2;
+        costParams.maxDisp = 66;
+        costParams.costType = costType;
+        Mat cost;
+        CensusCost::create(costParams)->compute(left, right, cost);
+
+        for (int mask = 0; mask < 16; ++mask) {
+            auto params = MultipathAggregation::Params();
+            params.enableKnightMove = mask & 8;
+            auto aggregator = std::static_pointer_cast<MultipathAggregation>(
+                MultipathAggregation::create(params));
+
+            auto dispParams = DispComputeParams();
+            dispParams.enableLRCheck = mask & 1;
+            dispParams.enableUniqueCheck = mask & 2;
+            dispParams.enableSubpixelFitting = mask & 4;
+            dispParams.uniquenessRatio = 0.95f;
+            dispParams.minDisp = 2;
+            dispParams.maxDisp = 66;
+
+            // the winner-takes-all of the stored sum and the one of the last
+            // direction see the same sums
+            Mat aggregatedCost, reference, disp;
+            aggregator->aggregation(left, cost, aggregatedCost);
+            winnerTakesAll(aggregatedCost, reference, dispParams);
+            aggregator->aggregation(left, cost, disp, dispParams);
+
+            int mismatched = 0;
+            for (int i = 0; i < disp.rows; ++i) {
+                for (int j = 0; j < disp.cols; ++j) {
+                    mismatched += abs(disp.ptr<float>(i)[j] -
+                                      reference.ptr<float>(i)[j]) > 1e-3f;
+                }
+            }
+
+            // the float sums are added up in another order
+            if (costType == CV_8U) {
+                EXPECT_EQ(mismatched, 0);
+            } else {
+                EXPECT_LE(mismatched, static_cast<int>(disp.total() / 1000));
+            }
+        }
+    }
+}
+
+/**
+ * @brief add the path costs of one direction to sum, the path of a pixel
+ * starts at the first pixel whose predecessor is out of the image
+ *
+ */
+static void referenceLinePath(const Mat &left, const Mat &cost,
+                              const MultipathAggregation::Params &params,
+                              const int directionY, const int directionX,
+                              Mat &sum) {
+    const int dispRange = cost.channels();
+    Mat pathCost(cost.size(), CV_MAKETYPE(CV_32S, dispRange));
+    const int beginY = directionY > 0 ? 0 : cost.rows - 1;
+    for (int step = 0; step < cost.rows; ++step) {
+        const int i = beginY + (directionY > 0 ? step : -step);
+        for (int j = 0; j < cost.cols; ++j) {
+            const uchar *ptrCost = cost.ptr<uchar>(i) + j * dispRange;
+            int *ptrPathCost = pathCost.ptr<int>(i) + j * dispRange;
+            const int lastI = i - directionY, lastJ = j - directionX;
+
+            if (lastI < 0 || lastI >= cost.rows || lastJ < 0 ||
+                lastJ >= cost.cols) {
+                for (int d = 0; d < dispRange; ++d) {
+                    ptrPathCost[d] = ptrCost[d];
+                }
+            } else {
+                const int *ptrLastCost =
+                    pathCost.ptr<int>(lastI) + lastJ * dispRange;
+                const int lastMin =
+                    *min_element(ptrLastCost, ptrLastCost + dispRange);
+                const int intensityDiff =
+                    abs(left.ptr<uchar>(i)[j] - left.ptr<uchar>(lastI)[lastJ]);
+                const int penalty = cvRound(
+                    max(params.P2 / max(intensityDiff, 1), params.P1));
+                const int P1 = cvRound(params.P1);
+                for (int d = 0; d < dispRange; ++d) {
+                    int minCost = min(ptrLastCost[d], lastMin + penalty);
+                    if (d > 0) {
+                        minCost = min(minCost, ptrLastCost[d - 1] + P1);
+                    }
+                    if (d < dispRange - 1) {
+                        minCost = min(minCost, ptrLastCost[d + 1] + P1);
+                    }
+                    ptrPathCost[d] = ptrCost[d] + minCost - lastMin;
+                }
+            }
+
+            int *ptrSum = sum.ptr<int>(i) + j * dispRange;
+            for (int d = 0; d < dispRange; ++d) {
+                ptrSum[d] += ptrPathCost[d];
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testMultipathAggregationVertical) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 16;
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    // the columns of a band advance a row at a time
+    auto params = MultipathAggregation::Params();
+    params.enableHonrizon = false;
+    params.enablePostive45 = false;
+    params.enableNegtive45 = false;
+    Mat aggregatedCost;
+    MultipathAggregation::create(params)->aggregation(left, cost,
+                                                       aggregatedCost);
+
+    Mat reference(cost.size(), CV_MAKETYPE(CV_32S, cost.channels()),
+                  Scalar(0));
+    referenceLinePath(left, cost, params, 1, 0, reference);
+    referenceLinePath(left, cost, params, -1, 0, reference);
+
+    int mismatched = 0;
+    for (int i = 0; i < cost.rows; ++i) {
+        const uint16_t *ptrAggregatedCost = aggregatedCost.ptr<uint16_t>(i);
+        const int *ptrReference = reference.ptr<int>(i);
+        for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+            mismatched += ptrAggregatedCost[k] != ptrReference[k];
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+}
+
+TEST_F(Cones, testPenaltyModel) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 64;
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    auto compare = [&](const MultipathAggregation::Params &params,
+                       const MultipathAggregation::Params &referenceParams) {
+        Mat aggregatedCost, reference;
+        MultipathAggregation::create(params)->aggregation(left, cost,
+                                                           aggregatedCost);
+        MultipathAggregation::create(referenceParams)
+            ->aggregation(left, cost, reference);
+        int mismatched = 0;
+        for (int i = 0; i < cost.rows; ++i) {
+            mismatched += memcmp(aggregatedCost.ptr(i), reference.ptr(i),
+                                 cost.cols * aggregatedCost.elemSize()) != 0;
+        }
+        return mismatched;
+    };
+
+    // no model is the inverse gradient model of P1 and P2
+    auto referenceParams = MultipathAggregation::Params();
+    auto params = referenceParams;
+    auto modelParams = PenaltyModel::Params();
+    modelParams.type = PenaltyType::InverseGradient;
+    modelParams.P2 = referenceParams.P2;
+    modelParams.minP2 = referenceParams.P1;
+    params.penaltyModel = PenaltyModel::create(modelParams);
+    EXPECT_EQ(compare(params, referenceParams), 0);
+
+    // a constant penalty is an inverse gradient one, which never falls below
+    // P2
+    modelParams.type = PenaltyType::Constant;
+    modelParams.P2 = 60.f;
+    params.penaltyModel = PenaltyModel::create(modelParams);
+    modelParams.type = PenaltyType::InverseGradient;
+    modelParams.minP2 = modelParams.P2;
+    referenceParams.penaltyModel = PenaltyModel::create(modelParams);
+    EXPECT_EQ(compare(params, referenceParams), 0);
+
+    // the edge map marks the pixels around a step and lowers the penalty of
+    // the steps into or out of them
+    modelParams.type = PenaltyType::EdgeMap;
+    modelParams.P2 = 150.f;
+    modelParams.edgeP2 = 30.f;
+    modelParams.edgeThreshold = 20;
+    auto edgeModel = PenaltyModel::create(modelParams);
+    Mat step(8, 8, CV_8UC1, Scalar(0)), edgeMap;
+    step(Rect(4, 0, 4, 8)).setTo(100);
+    edgeModel->guide(step, edgeMap);
+    ASSERT_EQ(edgeMap.type(), CV_8UC1);
+    for (int j = 0; j < step.cols; ++j) {
+        const bool edge = j == 3 || j == 4;
+        EXPECT_EQ(edgeMap.ptr<uchar>(0)[j], edge ? UCHAR_MAX : 0) << j;
+    }
+    EXPECT_EQ(edgeModel->penalty(0), 150.f);
+    EXPECT_EQ(edgeModel->penalty(UCHAR_MAX), 30.f);
+
+    params.penaltyModel = edgeModel;
+    Mat aggregatedCost;
+    MultipathAggregation::create(params)->aggregation(left, cost,
+                                                       aggregatedCost);
+    EXPECT_EQ(aggregatedCost.size(), cost.size());
+}
+
+TEST_F(Cones, testMultipathAggregationDiagonal) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 16;
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    auto params = MultipathAggregation::Params();
+    params.enableHonrizon = false;
+    params.enableVertiacl = false;
+    Mat aggregatedCost;
+    MultipathAggregation::create(params)->aggregation(left, cost,
+                                                       aggregatedCost);
+
+    Mat reference(cost.size(), CV_MAKETYPE(CV_32S, cost.channels()),
+                  Scalar(0));
+    referenceLinePath(left, cost, params, 1, -1, reference);
+    referenceLinePath(left, cost, params, -1, 1, reference);
+    referenceLinePath(left, cost, params, 1, 1, reference);
+    referenceLinePath(left, cost, params, -1, -1, reference);
+
+    int mismatched = 0;
+    for (int i = 0; i < cost.rows; ++i) {
+        const uint16_t *ptrAggregatedCost = aggregatedCost.ptr<uint16_t>(i);
+        const int *ptrReference = reference.ptr<int>(i);
+        for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+            mismatched += ptrAggregatedCost[k] != ptrReference[k];
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+}
+
+TEST_F(Cones, testMultipathAggregationKnightMove) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 16;
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    auto params = MultipathAggregation::Params();
+    params.enableHonrizon = false;
+    params.enableVertiacl = false;
+    params.enablePostive45 = false;
+    params.enableNegtive45 = false;
+    params.enableKnightMove = true;
+    Mat aggregatedCost;
+    MultipathAggregation::create(params)->aggregation(left, cost,
+                                                       aggregatedCost);
+
+    Mat reference(cost.size(), CV_MAKETYPE(CV_32S, cost.channels()),
+                  Scalar(0));
+    const int steps[4][2] = {{1, 2}, {2, 1}, {1, -2}, {2, -1}};
+    for (const auto &step : steps) {
+        referenceLinePath(left, cost, params, step[0], step[1], reference);
+        referenceLinePath(left, cost, params, -step[0], -step[1], reference);
+    }
+
+    int mismatched = 0;
+    for (int i = 0; i < cost.rows; ++i) {
+        const uint16_t *ptrAggregatedCost = aggregatedCost.ptr<uint16_t>(i);
+        const int *ptrReference = reference.ptr<int>(i);
+        for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+            mismatched += ptrAggregatedCost[k] != ptrReference[k];
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+}
+
+TEST_F(Cones, testMemoryEfficientAggregation) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 64;
+    costParams.costType = CV_8U;
+    auto censusComputer = CensusCost::create(costParams);
+
+    auto dispParams = DispComputeParams();
+    dispParams.enableLRCheck = false;
+    dispParams.enableUniqueCheck = false;
+    dispParams.enableSubpixelFitting = false;
+    dispParams.minDisp = costParams.minDisp;
+    dispParams.maxDisp = costParams.maxDisp;
+
+    // the costs of the strips equal the costs of the whole image
+    auto params = MemoryEfficientAggregation::Params();
+    params.stripRows = left.rows;
+    Mat reference;
+    MemoryEfficientAggregation::create(params)->aggregation(
+        left, right, *censusComputer, reference, dispParams);
+
+    params.stripRows = 16;
+    Mat disp;
+    MemoryEfficientAggregation::create(params)->aggregation(
+        left, right, *censusComputer, disp, dispParams);
+
+    int mismatched = 0;
+    for (int i = 0; i < left.rows; ++i) {
+        mismatched += memcmp(disp.ptr(i), reference.ptr(i),
+                             left.cols * sizeof(float)) != 0;
+    }
+    EXPECT_EQ(mismatched, 0);
+
+    // the forward sums away from the forward minimum are approximated, the
+    // disparities stay close to the ones of the whole aggregated volume
+    Mat cost, aggregatedCost, fullDisp;
+    censusComputer->compute(left, right, cost);
+    MultipathAggregation::create(MultipathAggregation::Params())
+        ->aggregation(left, cost, aggregatedCost);
+    winnerTakesAll(aggregatedCost, fullDisp, dispParams);
+
+    int agreed = 0;
+    for (int i = 0; i < left.rows; ++i) {
+        for (int j = 0; j < left.cols; ++j) {
+            agreed += abs(disp.ptr<float>(i)[j] - fullDisp.ptr<float>(i)[j]) <=
+                      1.f;
+        }
+    }
+    EXPECT_GT(agreed, 0.95 * left.rows * left.cols);
+
+    // the strips take the rows the window of the computer reaches around
+    // them, whatever its height
+    costParams.windowWidth = 11;
+    costParams.windowHeight = 11;
+    auto wideComputer = CensusCost::create(costParams);
+    params.stripRows = left.rows;
+    MemoryEfficientAggregation::create(params)->aggregation(
+        left, right, *wideComputer, reference, dispParams);
+    params.stripRows = 16;
+    MemoryEfficientAggregation::create(params)->aggregation(
+        left, right, *wideComputer, disp, dispParams);
+
+    mismatched = 0;
+    for (int i = 0; i < left.rows; ++i) {
+        mismatched += memcmp(disp.ptr(i), reference.ptr(i),
+                             left.cols * sizeof(float)) != 0;
+    }
+    EXPECT_EQ(mismatched, 0);
+
+    // the mutual information table of the whole pair is shared by the strips
+    auto miParams = MICost::Params();
+    miParams.minDisp = costParams.minDisp;
+    miParams.maxDisp = costParams.maxDisp;
+    auto miComputer = MICost::create(miParams);
+    params.stripRows = left.rows;
+    MemoryEfficientAggregation::create(params)->aggregation(
+        left, right, *miComputer, reference, dispParams);
+    params.stripRows = 16;
+    MemoryEfficientAggregation::create(params)->aggregation(
+        left, right, *miComputer, disp, dispParams);
+
+    mismatched = 0;
+    for (int i = 0; i < left.rows; ++i) {
+        mismatched += memcmp(disp.ptr(i), reference.ptr(i),
+                             left.cols * sizeof(float)) != 0;
+    }
+    EXPECT_EQ(mismatched, 0);
+}
+
+/**
+ * @brief add the MGM path costs of one direction to sum, the pixels are
+ * visited in the order of their projection on the sum of the direction and
+ * the direction turned by 90 degrees, which comes after both previous pixels
+ *
+ */
+static void referenceMGMPath(const Mat &left, const Mat &cost,
+                             const MGMAggregation::Params &params,
+                             const int directionY, const int directionX,
+                             Mat &sum) {
+    const int dispRange = cost.channels();
+    const int predY[2] = {-directionY, -directionX};
+    const int predX[2] = {-directionX, directionY};
+    vector<Point> pixels;
+    for (int i = 0; i < cost.rows; ++i) {
+        for (int j = 0; j < cost.cols; ++j) {
+            pixels.emplace_back(j, i);
+        }
+    }
+    auto order = [&](const Point &p) {
+        return p.y * (directionY + directionX) +
+               p.x * (directionX - directionY);
+    };
+    stable_sort(pixels.begin(), pixels.end(),
+                [&](const Point &a, const Point &b) {
+                    return order(a) < order(b);
+                });
+
+    Mat pathCost(cost.size(), CV_MAKETYPE(CV_32S, dispRange));
+    const int P1 = cvRound(params.P1);
+    for (const Point &p : pixels) {
+        const int i = p.y, j = p.x;
+        const uchar *ptrCost = cost.ptr<uchar>(i) + j * dispRange;
+        int *ptrPathCost = pathCost.ptr<int>(i) + j * dispRange;
+
+        vector<vector<int>> transitions;
+        for (int n = 0; n < 2; ++n) {
+            const int lastI = i + predY[n], lastJ = j + predX[n];
+            if (lastI < 0 || lastI >= cost.rows || lastJ < 0 ||
+                lastJ >= cost.cols) {
+                continue;
+            }
+            const int *ptrLastCost =
+                pathCost.ptr<int>(lastI) + lastJ * dispRange;
+            const int lastMin =
+                *min_element(ptrLastCost, ptrLastCost + dispRange);
+            const int intensityDiff =
+                abs(left.ptr<uchar>(i)[j] - left.ptr<uchar>(lastI)[lastJ]);
+            const int penalty =
+                cvRound(max(params.P2 / max(intensityDiff, 1), params.P1));
+            vector<int> transition(dispRange);
+            for (int d = 0; d < dispRange; ++d) {
+                int minCost = min(ptrLastCost[d], lastMin + penalty);
+                if (d > 0) {
+                    minCost = min(minCost, ptrLastCost[d - 1] + P1);
+                }
+                if (d < dispRange - 1) {
+                    minCost = min(minCost, ptrLastCost[d + 1] + P1);
+                }
+                transition[d] = minCost - lastMin;
+            }
+            transitions.push_back(transition);
+        }
+
+        for (int d = 0; d < dispRange; ++d) {
+            int pathCostD = ptrCost[d];
+            if (transitions.size() == 1) {
+                pathCostD += transitions[0][d];
+            } else if (transitions.size() == 2) {
+                pathCostD += (transitions[0][d] + transitions[1][d] + 1) / 2;
+            }
+            ptrPathCost[d] = pathCostD;
+        }
+
+        int *ptrSum = sum.ptr<int>(i) + j * dispRange;
+        for (int d = 0; d < dispRange; ++d) {
+            ptrSum[d] += ptrPathCost[d];
+        }
+    }
+}
+
+TEST_F(Cones, testMGMAggregation) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    costParams.maxDisp = 16;
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    auto params = MGMAggregation::Params();
+    Mat aggregatedCost;
+    MGMAggregation::create(params)->aggregation(left, cost, aggregatedCost);
+    ASSERT_EQ(aggregatedCost.depth(), CV_16U);
+
+    Mat reference(cost.size(), CV_MAKETYPE(CV_32S, cost.channels()),
+                  Scalar(0));
+    const int directions[8][2] = {{0, 1},  {0, -1}, {1, 0},  {-1, 0},
+                                  {1, -1}, {-1, 1}, {1, 1}, {-1, -1}};
+    for (const auto &direction : directions) {
+        referenceMGMPath(left, cost, params, direction[0], direction[1],
+                         reference);
+    }
+
+    int mismatched = 0;
+    for (int i = 0; i < cost.rows; ++i) {
+        const uint16_t *ptrAggregatedCost = aggregatedCost.ptr<uint16_t>(i);
+        const int *ptrReference = reference.ptr<int>(i);
+        for (int k = 0; k < cost.cols * cost.channels(); ++k) {
+            mismatched +=
+                ptrAggregatedCost[k] != min(ptrReference[k], USHRT_MAX);
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+}
+
+TEST_F(Cones, testMGMAggregationSimdExact) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 0;
+    // not a multiple of the vector widths, so the tails are covered
+    costParams.maxDisp = 70;
+    costParams.costType = CV_8U;
+    Mat cost;
+    CensusCost::create(costParams)->compute(left, right, cost);
+
+    auto aggregator = MGMAggregation::create(MGMAggregation::Params());
+
+    setMaxSimdLevel(SimdLevel::Scalar);
+    Mat reference;
+    aggregator->aggregation(left, cost, reference);
+
+    const auto detected = detectSimdLevel();
+    for (int level = 1; level <= static_cast<int>(detected); ++level) {
+        setMaxSimdLevel(static_cast<SimdLevel>(level));
+
+        Mat aggregatedCost;
+        aggregator->aggregation(left, cost, aggregatedCost);
+
+        int mismatched = 0;
+        for (int i = 0; i < cost.rows; ++i) {
+            mismatched += memcmp(aggregatedCost.ptr(i), reference.ptr(i),
+                                 cost.cols * aggregatedCost.elemSize()) != 0;
+        }
+        EXPECT_EQ(mismatched, 0) << "simd level " << level;
+    }
+
+    setMaxSimdLevel(SimdLevel::AVX512);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <bitset>
+
 #include <opencv2/opencv.hpp>
 
 #include <libStereoMatch.h>
@@ -102,4 +104,645 @@ TEST_F(Cones, testADCensusCost) {
     Mat out;
     transformToGray();
     adCensusComputer->compute(left, right, out);
-}
\ No newline at end of file
+}
+/**
+ * @brief reference census cost, one compare and one bit at a time
+ *
+ */
+static void referenceCensusCost(const Mat &left, const Mat &right,
+                                const int windowWidth, const int windowHeight,
+                                const int minDisp, const int maxDisp,
+                                Mat &out) {
+    const int halfWidth = windowWidth / 2;
+    const int halfHeight = windowHeight / 2;
+    const int dispRange = maxDisp - minDisp;
+
+    auto census = [&](const Mat &img, const int x, const int y) {
+        const uchar centerGray = img.ptr<uchar>(y)[x];
+        uint64_t val = 0;
+        for (int i = -halfHeight; i <= halfHeight; ++i) {
+            for (int j = -halfWidth; j <= halfWidth; ++j) {
+                val += (img.ptr<uchar>(y + i)[x + j] > centerGray);
+                if (i != halfHeight || j != halfWidth) {
+                    val <<= 1;
+                }
+            }
+        }
+        return val;
+    };
+
+    out = Mat(left.size(), CV_32FC(dispRange), Scalar(0.f));
+
+    for (int i = 0; i < out.rows; ++i) {
+        for (int j = 0; j < out.cols; ++j) {
+            for (int d = 0; d < dispRange; ++d) {
+                const int rx = j - minDisp - d;
+                if (j < halfWidth || j > out.cols - halfWidth - 1 ||
+                    i < halfHeight || i > out.rows - halfHeight - 1 ||
+                    rx < halfWidth || rx > out.cols - halfWidth - 1) {
+                    out.ptr<float>(i)[dispRange * j + d] = FLT_MAX;
+                    continue;
+                }
+
+                auto diff = census(left, j, i) ^ census(right, rx, i);
+                int distance = 0;
+                for (int k = 0; k < windowWidth * windowHeight; ++k) {
+                    distance += (diff >> k) & 0x01;
+                }
+                out.ptr<float>(i)[dispRange * j + d] = distance;
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testCensusCostSimdExact) {
+    transformToGray();
+
+    Mat reference;
+    referenceCensusCost(left, right, 9, 7, 0, 64, reference);
+
+    auto params = CensusCost::Params();
+    params.windowWidth = 9;
+    params.windowHeight = 7;
+    params.minDisp = 0;
+    params.maxDisp = 64;
+
+    const auto detected = detectSimdLevel();
+    for (int level = 0; level <= static_cast<int>(detected); ++level) {
+        setMaxSimdLevel(static_cast<SimdLevel>(level));
+
+        Mat out;
+        CensusCost::create(params)->compute(left, right, out);
+
+        int mismatched = 0;
+        for (int i = 0; i < out.rows; ++i) {
+            mismatched += memcmp(out.ptr<float>(i), reference.ptr<float>(i),
+                                 out.cols * out.elemSize()) != 0;
+        }
+        EXPECT_EQ(mismatched, 0) << "simd level " << level;
+    }
+
+    setMaxSimdLevel(SimdLevel::AVX512);
+}
+
+TEST_F(Cones, testCensusCostCompact) {
+    transformToGray();
+
+    auto params = CensusCost::Params();
+    params.windowWidth = 9;
+    params.windowHeight = 7;
+    params.minDisp = 0;
+    params.maxDisp = 64;
+
+    Mat reference;
+    CensusCost::create(params)->compute(left, right, reference);
+
+    for (auto costType : {CV_8U, CV_16U}) {
+        params.costType = costType;
+        Mat out;
+        CensusCost::create(params)->compute(left, right, out);
+        ASSERT_EQ(out.depth(), costType);
+
+        Mat converted;
+        out.convertTo(converted, CV_32F);
+
+        int mismatched = 0;
+        for (int i = 0; i < out.rows; ++i) {
+            for (int k = 0; k < out.cols * out.channels(); ++k) {
+                const float expected = reference.ptr<float>(i)[k];
+                const float actual = converted.ptr<float>(i)[k];
+                mismatched += expected == FLT_MAX
+                                  ? actual != (costType == CV_8U ? 255 : 65535)
+                                  : actual != expected;
+            }
+        }
+        EXPECT_EQ(mismatched, 0) << "cost type " << costType;
+    }
+}
+
+/**
+ * @brief reference census cost of a sampling pattern, the distance is the
+ * number of comparisons whose outcome differs
+ *
+ */
+static void referencePatternCost(const Mat &left, const Mat &right,
+                                 const CensusPattern pattern,
+                                 const int windowWidth, const int windowHeight,
+                                 const int minDisp, const int maxDisp,
+                                 Mat &out) {
+    const int halfWidth = windowWidth / 2;
+    const int halfHeight = windowHeight / 2;
+    const int dispRange = maxDisp - minDisp;
+
+    auto census = [&](const Mat &img, const int x, const int y) {
+        bitset<256> val;
+        int bit = 0;
+        for (int i = -halfHeight; i <= halfHeight; ++i) {
+            for (int j = -halfWidth; j <= halfWidth; ++j) {
+                const uchar gray = img.ptr<uchar>(y + i)[x + j];
+                if (pattern == CensusPattern::Dense) {
+                    val[bit++] = gray > img.ptr<uchar>(y)[x];
+                } else if (pattern == CensusPattern::Sparse) {
+                    if ((i + j) % 2 == 0 && (i != 0 || j != 0)) {
+                        val[bit++] = gray > img.ptr<uchar>(y)[x];
+                    }
+                } else if (i < 0 || (i == 0 && j < 0)) {
+                    val[bit++] = gray > img.ptr<uchar>(y - i)[x - j];
+                }
+            }
+        }
+        return val;
+    };
+
+    vector<bitset<256>> leftCensus(left.total()), rightCensus(right.total());
+    for (int i = halfHeight; i < left.rows - halfHeight; ++i) {
+        for (int j = halfWidth; j < left.cols - halfWidth; ++j) {
+            leftCensus[i * left.cols + j] = census(left, j, i);
+            rightCensus[i * left.cols + j] = census(right, j, i);
+        }
+    }
+
+    out = Mat(left.size(), CV_32FC(dispRange), Scalar(0.f));
+
+    for (int i = 0; i < out.rows; ++i) {
+        for (int j = 0; j < out.cols; ++j) {
+            for (int d = 0; d < dispRange; ++d) {
+                const int rx = j - minDisp - d;
+                if (j < halfWidth || j > out.cols - halfWidth - 1 ||
+                    i < halfHeight || i > out.rows - halfHeight - 1 ||
+                    rx < halfWidth || rx > out.cols - halfWidth - 1) {
+                    out.ptr<float>(i)[dispRange * j + d] = FLT_MAX;
+                    continue;
+                }
+
+                out.ptr<float>(i)[dispRange * j + d] = static_cast<float>(
+                    (leftCensus[i * out.cols + j] ^
+                     rightCensus[i * out.cols + rx])
+                        .count());
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testCensusCostPatterns) {
+    transformToGray();
+
+    struct Case {
+        CensusPattern pattern;
+        int windowWidth;
+        int windowHeight;
+    };
+    // 121, 112, 112 and 225 comparisons, two and four words
+    const Case cases[] = {{CensusPattern::Dense, 11, 11},
+                          {CensusPattern::Sparse, 15, 15},
+                          {CensusPattern::CenterSymmetric, 15, 15},
+                          {CensusPattern::Dense, 15, 15}};
+
+    for (const auto &c : cases) {
+        Mat reference;
+        referencePatternCost(left, right, c.pattern, c.windowWidth,
+                             c.windowHeight, 5, 37, reference);
+
+        auto params = CensusCost::Params();
+        params.windowWidth = c.windowWidth;
+        params.windowHeight = c.windowHeight;
+        params.minDisp = 5;
+        params.maxDisp = 37;
+        params.pattern = c.pattern;
+
+        const auto detected = detectSimdLevel();
+        for (int level = 0; level <= static_cast<int>(detected); ++level) {
+            setMaxSimdLevel(static_cast<SimdLevel>(level));
+
+            Mat out;
+            CensusCost::create(params)->compute(left, right, out);
+
+            int mismatched = 0;
+            for (int i = 0; i < out.rows; ++i) {
+                mismatched +=
+                    memcmp(out.ptr<float>(i), reference.ptr<float>(i),
+                           out.cols * out.elemSize()) != 0;
+            }
+            EXPECT_EQ(mismatched, 0)
+                << "pattern " << static_cast<int>(c.pattern) << " window "
+                << c.windowWidth << "x" << c.windowHeight << " simd level "
+                << level;
+        }
+    }
+
+    setMaxSimdLevel(SimdLevel::AVX512);
+}
+
+TEST_F(Cones, testCensusCostSpecializedWindow) {
+    transformToGray();
+
+    // the specialized dense windows and a window of the generic kernel
+    const int windows[][2] = {{5, 5}, {7, 7}, {9, 7}, {11, 11}, {7, 5}};
+
+    for (const auto &window : windows) {
+        Mat reference;
+        referencePatternCost(left, right, CensusPattern::Dense, window[0],
+                             window[1], 3, 35, reference);
+
+        auto params = CensusCost::Params();
+        params.windowWidth = window[0];
+        params.windowHeight = window[1];
+        params.minDisp = 3;
+        params.maxDisp = 35;
+
+        const auto detected = detectSimdLevel();
+        for (int level = 0; level <= static_cast<int>(detected); ++level) {
+            setMaxSimdLevel(static_cast<SimdLevel>(level));
+
+            Mat out;
+            CensusCost::create(params)->compute(left, right, out);
+
+            int mismatched = 0;
+            for (int i = 0; i < out.rows; ++i) {
+                mismatched +=
+                    memcmp(out.ptr<float>(i), reference.ptr<float>(i),
+                           out.cols * out.elemSize()) != 0;
+            }
+            EXPECT_EQ(mismatched, 0) << "window " << window[0] << "x"
+                                     << window[1] << " simd level " << level;
+        }
+    }
+
+    setMaxSimdLevel(SimdLevel::AVX512);
+}
+
+TEST_F(Cones, testADCostLargeWindow) {
+    auto params = ADCost::Params();
+    params.windowWidth = 15;
+    params.windowHeight = 15;
+    params.minDisp = 0;
+    params.maxDisp = 64;
+    auto adCostComputer = ADCost::create(params);
+
+    for (int color = 1; color >= 0; --color) {
+        if (!color)
+            transformToGray();
+
+        Mat out;
+        adCostComputer->compute(left, right, out);
+
+        for (auto loc : {Point(100, 100), Point(308, 301), Point(440, 200)}) {
+            for (int d = 0; d < 64; d += 7) {
+                const float cost = out.ptr<float>(loc.y)[64 * loc.x + d];
+                if (loc.x - d < 7 || loc.x > left.cols - 8) {
+                    ASSERT_EQ(cost, FLT_MAX);
+                    continue;
+                }
+
+                float expected = 0.f;
+                for (int i = -7; i <= 7; ++i) {
+                    for (int j = -7; j <= 7; ++j) {
+                        auto ptrLeft = left.ptr<uchar>(loc.y + i);
+                        auto ptrRight = right.ptr<uchar>(loc.y + i);
+                        for (int c = 0; c < left.channels(); ++c) {
+                            expected += abs(static_cast<float>(
+                                                ptrLeft[left.channels() *
+                                                            (loc.x + j) +
+                                                        c]) -
+                                            ptrRight[left.channels() *
+                                                         (loc.x - d + j) +
+                                                     c]);
+                        }
+                    }
+                }
+                expected /= left.channels();
+
+                ASSERT_LE(abs(cost - expected), 0.1f);
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testADCost16U) {
+    transformToGray();
+
+    auto params = ADCost::Params();
+    params.minDisp = 0;
+    params.maxDisp = 64;
+
+    // the window sums fit, the 16-bit cost is the rounded float cost
+    Mat reference, out;
+    params.costType = CV_32F;
+    ADCost::create(params)->compute(left, right, reference);
+    params.costType = CV_16U;
+    ADCost::create(params)->compute(left, right, out);
+
+    int mismatched = 0;
+    for (int i = 0; i < left.rows; ++i) {
+        const float *ptrReference = reference.ptr<float>(i);
+        const uint16_t *ptrOut = out.ptr<uint16_t>(i);
+        for (int k = 0; k < left.cols * 64; ++k) {
+            mismatched += ptrReference[k] == FLT_MAX
+                              ? ptrOut[k] != USHRT_MAX
+                              : ptrOut[k] != cvRound(ptrReference[k]);
+        }
+    }
+    EXPECT_EQ(mismatched, 0);
+
+    // the largest sum of a 17x17 window does not fit, a valid cost is scaled
+    // below the invalid one
+    params.windowWidth = 17;
+    params.windowHeight = 17;
+    Mat bright(left.size(), CV_8UC1, Scalar(255));
+    Mat dark(left.size(), CV_8UC1, Scalar(0));
+    ADCost::create(params)->compute(bright, dark, out);
+
+    const uint16_t *ptrOut = out.ptr<uint16_t>(left.rows / 2);
+    for (int d = 0; d < 64; ++d) {
+        EXPECT_EQ(ptrOut[64 * (left.cols - 9) + d], USHRT_MAX - 1);
+    }
+}
+
+TEST_F(Cones, testADCensusCostFused) {
+    transformToGray();
+
+    auto params = ADCensusCost::Params();
+    params.windowWidth = 9;
+    params.windowHeight = 7;
+    params.minDisp = 0;
+    params.maxDisp = 64;
+    params.adWeight = 10.f;
+    params.censusWeight = 30.f;
+    Mat out;
+    ADCensusCost::create(params)->compute(left, right, out);
+
+    Mat adCost, censusCost;
+    {
+        auto adParams = ADCost::Params();
+        adParams.maxDisp = 64;
+        ADCost::create(adParams)->compute(left, right, adCost);
+
+        auto censusParams = CensusCost::Params();
+        censusParams.maxDisp = 64;
+        CensusCost::create(censusParams)->compute(left, right, censusCost);
+    }
+
+    for (int i = 3; i < out.rows - 3; i += 17) {
+        for (int j = 4; j < out.cols - 4; j += 13) {
+            for (int d = 0; d < 64; ++d) {
+                const float ad = adCost.ptr<float>(i)[64 * j + d];
+                const float census = censusCost.ptr<float>(i)[64 * j + d];
+                const float expected =
+                    ad == FLT_MAX ? 2.f
+                                  : 2.f - exp(-ad / params.adWeight) -
+                                        exp(-census / params.censusWeight);
+                ASSERT_LE(abs(out.ptr<float>(i)[64 * j + d] - expected),
+                          1e-5f);
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testMICost) {
+    auto params = MICost::Params();
+    params.minDisp = 0;
+    params.maxDisp = 64;
+
+    Mat cost;
+    MICost::create(params)->compute(left, right, cost);
+    ASSERT_EQ(cost.type(), CV_32FC(64));
+
+    for (int i = 0; i < cost.rows; i += 31) {
+        for (int j = 0; j < cost.cols; j += 7) {
+            for (int d = 0; d < 64; ++d) {
+                const float val = cost.ptr<float>(i)[64 * j + d];
+                if (j - d < 0) {
+                    ASSERT_EQ(val, FLT_MAX);
+                } else {
+                    ASSERT_GE(val, 0.f);
+                }
+            }
+        }
+    }
+
+    params.costType = CV_16U;
+    Mat compactCost;
+    MICost::create(params)->compute(left, right, compactCost);
+    ASSERT_EQ(compactCost.type(), CV_16UC(64));
+    for (int i = 0; i < cost.rows; i += 31) {
+        for (int k = 0; k < cost.cols * 64; k += 11) {
+            const float val = cost.ptr<float>(i)[k];
+            ASSERT_EQ(compactCost.ptr<uint16_t>(i)[k],
+                      val == FLT_MAX
+                          ? 65535
+                          : saturate_cast<uint16_t>(val * MI_COST_SCALE_16U));
+        }
+    }
+
+    auto dispParams = DispComputeParams();
+    dispParams.minDisp = 0;
+    dispParams.maxDisp = 64;
+
+    Mat aggregatedCost, disp;
+    MultipathAggregation::create(MultipathAggregation::Params())
+        ->aggregation(left, cost, aggregatedCost);
+    winnerTakesAll(aggregatedCost, disp, dispParams);
+    ASSERT_LE(abs(disp.ptr<float>(301)[308] - 40), 1.f);
+
+    // the quantized cost matches with the penalties quantized alike
+    auto aggregationParams = MultipathAggregation::Params();
+    aggregationParams.P1 *= MI_COST_SCALE_16U;
+    aggregationParams.P2 *= MI_COST_SCALE_16U;
+    Mat compactDisp;
+    MultipathAggregation::create(aggregationParams)
+        ->aggregation(left, compactCost, aggregatedCost);
+    winnerTakesAll(aggregatedCost, compactDisp, dispParams);
+    ASSERT_LE(abs(compactDisp.ptr<float>(301)[308] - 40), 1.f);
+
+    int agreed = 0;
+    for (int i = 0; i < disp.rows; ++i) {
+        for (int j = 0; j < disp.cols; ++j) {
+            agreed += abs(compactDisp.ptr<float>(i)[j] -
+                          disp.ptr<float>(i)[j]) <= 1.f;
+        }
+    }
+    EXPECT_GT(agreed, 0.995 * disp.rows * disp.cols);
+}
+
+TEST_F(Cones, testCensusCostVolumeLayout) {
+    transformToGray();
+
+    const CostLayout layouts[] = {CostLayout::PixelMajor,
+                                  CostLayout::DispMajor};
+    for (const int costType : {CV_8U, CV_16U, CV_32F}) {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 3;
+        params.maxDisp = 67;
+        params.costType = costType;
+
+        auto censusComputer = CensusCost::create(params);
+        Mat cost;
+        censusComputer->compute(left, right, cost);
+
+        for (const CostLayout layout : layouts) {
+            CostVolume volume(layout);
+            censusComputer->compute(left, right, volume);
+
+            ASSERT_EQ(volume.layout(), layout);
+            ASSERT_EQ(volume.rows(), cost.rows);
+            ASSERT_EQ(volume.cols(), cost.cols);
+            ASSERT_EQ(volume.dispRange(), cost.channels());
+            ASSERT_EQ(volume.depth(), costType);
+
+            const size_t alignElems =
+                COST_VOLUME_ALIGN / CV_ELEM_SIZE1(costType);
+            ASSERT_EQ(reinterpret_cast<size_t>(volume.ptr<uint8_t>(0)) %
+                          COST_VOLUME_ALIGN,
+                      0u);
+            ASSERT_EQ(static_cast<size_t>(volume.rowStep()) % alignElems, 0u);
+            if (layout == CostLayout::PixelMajor) {
+                ASSERT_EQ(static_cast<size_t>(volume.pixelStep()) % alignElems,
+                          0u);
+            }
+
+            Mat back;
+            volume.copyTo(back);
+            ASSERT_EQ(back.type(), cost.type());
+            ASSERT_EQ(memcmp(back.data, cost.data, cost.total() * cost.elemSize()),
+                      0);
+
+            for (int i = 0; i < cost.rows; i += 37) {
+                for (int j = 0; j < cost.cols; j += 29) {
+                    const int channels = cost.channels();
+                    for (int d = 0; d < channels; ++d) {
+                        if (costType == CV_8U) {
+                            ASSERT_EQ(volume.at<uint8_t>(i, j, d),
+                                      cost.ptr<uint8_t>(i)[j * channels + d]);
+                        } else if (costType == CV_16U) {
+                            ASSERT_EQ(volume.at<uint16_t>(i, j, d),
+                                      cost.ptr<uint16_t>(i)[j * channels + d]);
+                        } else {
+                            ASSERT_EQ(volume.at<float>(i, j, d),
+                                      cost.ptr<float>(i)[j * channels + d]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testCostSearchRange) {
+    transformToGray();
+
+    // 4 x 2 tiles, the lower tiles search larger disparities
+    Mat searchRange(4, 2, CV_32SC2);
+    for (int i = 0; i < searchRange.rows; ++i) {
+        for (int j = 0; j < searchRange.cols; ++j) {
+            searchRange.ptr<int>(i)[2 * j] = 8 * i + 4 * j;
+            searchRange.ptr<int>(i)[2 * j + 1] = 8 * i + 4 * j + 36;
+        }
+    }
+
+    const int minDisp = 2, maxDisp = 66;
+    Mat bands;
+    searchRangeBands(searchRange, left.rows, left.cols, minDisp,
+                     maxDisp - minDisp, bands);
+
+    auto censusParams = CensusCost::Params();
+    censusParams.minDisp = minDisp;
+    censusParams.maxDisp = maxDisp;
+    censusParams.costType = CV_16U;
+    auto adParams = ADCost::Params();
+    adParams.minDisp = minDisp;
+    adParams.maxDisp = maxDisp;
+    const Ptr<CostComputer> computers[] = {CensusCost::create(censusParams),
+                                           ADCost::create(adParams)};
+
+    for (const auto &computer : computers) {
+        Mat cost;
+        computer->compute(left, right, cost);
+
+        CostVolume volume(CostLayout::Ragged);
+        volume.create(bands, maxDisp - minDisp, cost.depth());
+        computer->compute(left, right, volume);
+        ASSERT_EQ(volume.layout(), CostLayout::Ragged);
+        ASSERT_EQ(volume.depth(), cost.depth());
+
+        for (int i = 0; i < cost.rows; ++i) {
+            const int tileRow = i * searchRange.rows / cost.rows;
+            for (int j = 0; j < cost.cols; ++j) {
+                const int tileCol = j * searchRange.cols / cost.cols;
+                const int *range = searchRange.ptr<int>(tileRow) + 2 * tileCol;
+                ASSERT_EQ(volume.dispBegin(i, j),
+                          min(max(range[0] - minDisp, 0), maxDisp - minDisp));
+                ASSERT_EQ(volume.dispEnd(i, j),
+                          min(range[1] - minDisp, maxDisp - minDisp));
+
+                for (int d = volume.dispBegin(i, j); d < volume.dispEnd(i, j);
+                     ++d) {
+                    if (cost.depth() == CV_16U) {
+                        ASSERT_EQ(volume.at<uint16_t>(i, j, d),
+                                  cost.ptr<uint16_t>(i)[j * cost.channels() +
+                                                        d]);
+                    } else {
+                        ASSERT_EQ(volume.at<float>(i, j, d),
+                                  cost.ptr<float>(i)[j * cost.channels() + d]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testCostValidBand) {
+    transformToGray();
+
+    const int minDisp = 3, maxDisp = 67, dispRange = maxDisp - minDisp;
+
+    auto censusParams = CensusCost::Params();
+    censusParams.windowWidth = 9;
+    censusParams.windowHeight = 7;
+    censusParams.minDisp = minDisp;
+    censusParams.maxDisp = maxDisp;
+    auto adParams = ADCost::Params();
+    adParams.windowWidth = 9;
+    adParams.windowHeight = 7;
+    adParams.minDisp = minDisp;
+    adParams.maxDisp = maxDisp;
+    auto adCensusParams = ADCensusCost::Params();
+    adCensusParams.windowWidth = 9;
+    adCensusParams.windowHeight = 7;
+    adCensusParams.minDisp = minDisp;
+    adCensusParams.maxDisp = maxDisp;
+    const Ptr<CostComputer> computers[] = {
+        CensusCost::create(censusParams), ADCost::create(adParams),
+        ADCensusCost::create(adCensusParams)};
+
+    for (const auto &computer : computers) {
+        Mat cost;
+        computer->compute(left, right, cost);
+
+        CostVolume volume(CostLayout::Ragged);
+        computer->compute(left, right, volume);
+
+        for (int i = 0; i < cost.rows; ++i) {
+            for (int j = 0; j < cost.cols; ++j) {
+                // the matched window [j - d - 4, j - d + 4] inside the
+                // right image
+                int beginDisp = 0, endDisp = 0;
+                if (i >= 3 && i < cost.rows - 3 && j >= 4 &&
+                    j < cost.cols - 4) {
+                    beginDisp = max(j - minDisp - (cost.cols - 5), 0);
+                    endDisp = min(j - minDisp - 4 + 1, dispRange);
+                    endDisp = max(endDisp, beginDisp);
+                }
+                ASSERT_EQ(volume.dispBegin(i, j), beginDisp);
+                ASSERT_EQ(volume.dispEnd(i, j), endDisp);
+
+                for (int d = beginDisp; d < endDisp; ++d) {
+                    const float val = cost.ptr<float>(i)[j * dispRange + d];
+                    ASSERT_NE(val, FLT_MAX);
+                    ASSERT_EQ(volume.at<float>(i, j, d), val);
+                }
+            }
+        }
+    }
+}
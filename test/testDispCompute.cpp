@@ -81,4 +81,261 @@ TEST_F(Cones, testWinnerTakesAll) {
     }
 
     ASSERT_LE(abs(disp.ptr<float>(301)[308] - 40), 1.f);
-}
\ No newline at end of file
+}
+
+TEST_F(Cones, testWinnerTakesAllDispMajor) {
+    transformToGray();
+
+    for (const int costType : {CV_8U, CV_32F}) {
+        auto costParams = CensusCost::Params();
+        costParams.windowWidth = 9;
+        costParams.windowHeight = 7;
+        costParams.minDisp = 2;
+        costParams.maxDisp = 66;
+        costParams.costType = costType;
+        auto censusComputer = CensusCost::create(costParams);
+
+        Mat cost;
+        censusComputer->compute(left, right, cost);
+        CostVolume volume(CostLayout::DispMajor);
+        censusComputer->compute(left, right, volume);
+
+        for (int mask = 0; mask < 8; ++mask) {
+            auto params = DispComputeParams();
+            params.enableLRCheck = mask & 1;
+            params.enableUniqueCheck = mask & 2;
+            params.enableSubpixelFitting = mask & 4;
+            params.lrCheckThreshod = 1;
+            params.uniquenessRatio = 0.98f;
+            params.minDisp = 2;
+            params.maxDisp = 66;
+
+            Mat disp, dispVolume;
+            winnerTakesAll(cost, disp, params);
+            winnerTakesAll(volume, dispVolume, params);
+
+            ASSERT_EQ(memcmp(disp.data, dispVolume.data,
+                             disp.total() * disp.elemSize()),
+                      0);
+        }
+    }
+}
+
+TEST_F(Cones, testWinnerTakesAllRightDisp) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 2;
+    costParams.maxDisp = 66;
+    costParams.costType = CV_16U;
+    auto censusComputer = CensusCost::create(costParams);
+
+    auto params = DispComputeParams();
+    params.enableSubpixelFitting = false;
+    params.minDisp = 2;
+    params.maxDisp = 66;
+
+    for (const CostLayout layout :
+         {CostLayout::PixelMajor, CostLayout::DispMajor, CostLayout::Ragged}) {
+        CostVolume volume(layout);
+        censusComputer->compute(left, right, volume);
+
+        Mat disp, rightDisp;
+        winnerTakesAll(volume, disp, rightDisp, params);
+
+        // the best stored disparity of every right pixel, the larger one
+        // wins ties
+        int mismatched = 0;
+        for (int i = 0; i < volume.rows(); ++i) {
+            for (int x = 0; x < volume.cols(); ++x) {
+                uint16_t minCost = numeric_limits<uint16_t>::max();
+                float reference = NONE_PIXEL;
+                for (int d = params.maxDisp - params.minDisp - 1; d >= 0;
+                     --d) {
+                    const int j = x + d + params.minDisp;
+                    if (j >= volume.cols() || d < volume.dispBegin(i, j) ||
+                        d >= volume.dispEnd(i, j)) {
+                        continue;
+                    }
+                    if (volume.at<uint16_t>(i, j, d) < minCost) {
+                        minCost = volume.at<uint16_t>(i, j, d);
+                        reference = static_cast<float>(d + params.minDisp);
+                    }
+                }
+                mismatched += rightDisp.ptr<float>(i)[x] != reference;
+            }
+        }
+        EXPECT_EQ(mismatched, 0);
+
+        // the left disparities passing the check match their right ones
+        mismatched = 0;
+        for (int i = 0; i < volume.rows(); ++i) {
+            for (int j = 0; j < volume.cols(); ++j) {
+                const float d = disp.ptr<float>(i)[j];
+                if (d < params.minDisp) {
+                    continue;
+                }
+                const int rx = j - static_cast<int>(d);
+                mismatched += rx >= 0 && abs(rightDisp.ptr<float>(i)[rx] - d) >
+                                             params.lrCheckThreshod;
+            }
+        }
+        EXPECT_EQ(mismatched, 0);
+    }
+}
+
+TEST(DispCompute, testWinnerTakesAllSimdExact) {
+    // few cost values so that the minimums tie, invalid costs and disparity
+    // ranges off the vector widths
+    RNG rng(7);
+    for (const int dispRange : {3, 5, 37, 64, 100}) {
+        Mat cost16(40, 60, CV_MAKETYPE(CV_16U, dispRange));
+        Mat cost32(40, 60, CV_MAKETYPE(CV_32F, dispRange));
+        for (int i = 0; i < cost16.rows; ++i) {
+            uint16_t *ptrCost16 = cost16.ptr<uint16_t>(i);
+            float *ptrCost32 = cost32.ptr<float>(i);
+            for (int k = 0; k < cost16.cols * dispRange; ++k) {
+                const int value = rng.uniform(0, 24);
+                ptrCost16[k] = value < 20 ? static_cast<uint16_t>(value)
+                                          : numeric_limits<uint16_t>::max();
+                ptrCost32[k] = value < 20 ? value * 0.5f : FLT_MAX;
+            }
+        }
+
+        auto params = DispComputeParams();
+        params.enableLRCheck = false;
+        params.uniquenessRatio = 0.7f;
+        params.minDisp = 0;
+        params.maxDisp = dispRange;
+
+        for (const Mat &cost : {cost16, cost32}) {
+            setMaxSimdLevel(SimdLevel::Scalar);
+            Mat reference;
+            winnerTakesAll(cost, reference, params);
+
+            const auto detected = detectSimdLevel();
+            for (int level = 1; level <= static_cast<int>(detected); ++level) {
+                setMaxSimdLevel(static_cast<SimdLevel>(level));
+                Mat disp;
+                winnerTakesAll(cost, disp, params);
+
+                EXPECT_EQ(memcmp(disp.data, reference.data,
+                                 disp.total() * disp.elemSize()),
+                          0)
+                    << "disparity range " << dispRange << ", simd level "
+                    << level;
+            }
+        }
+    }
+
+    setMaxSimdLevel(SimdLevel::AVX512);
+}
+
+TEST(DispCompute, testWinnerTakesAllUniqueness) {
+    // the second best cost is looked for at all the disparities more than one
+    // away from the best one, not only at the ones before it
+    const float costs[8] = {90.f, 200.f, 10.f, 200.f, 200.f, 10.3f, 200.f,
+                            200.f};
+    Mat cost(1, 1, CV_32FC(8), const_cast<float *>(costs));
+
+    auto params = DispComputeParams();
+    params.enableLRCheck = false;
+    params.enableSubpixelFitting = false;
+    params.uniquenessRatio = 0.95f;
+    params.minDisp = 0;
+    params.maxDisp = 8;
+
+    Mat disp;
+    winnerTakesAll(cost, disp, params);
+    EXPECT_EQ(disp.ptr<float>(0)[0], NONE_PIXEL);
+
+    // a neighbour of the best disparity belongs to the same match
+    const float neighbourCosts[8] = {90.f, 200.f, 10.f, 10.3f, 200.f, 200.f,
+                                     200.f, 200.f};
+    Mat neighbourCost(1, 1, CV_32FC(8), const_cast<float *>(neighbourCosts));
+    disp.release();
+    winnerTakesAll(neighbourCost, disp, params);
+    EXPECT_EQ(disp.ptr<float>(0)[0], 2.f);
+}
+
+TEST_F(Cones, testWinnerTakesAllConfidence) {
+    transformToGray();
+
+    auto costParams = CensusCost::Params();
+    costParams.windowWidth = 9;
+    costParams.windowHeight = 7;
+    costParams.minDisp = 2;
+    costParams.maxDisp = 66;
+    costParams.costType = CV_16U;
+    auto censusComputer = CensusCost::create(costParams);
+
+    auto params = DispComputeParams();
+    params.enableSubpixelFitting = false;
+    params.minDisp = 2;
+    params.maxDisp = 66;
+
+    for (const ConfidenceType type :
+         {ConfidenceType::PeakRatio, ConfidenceType::Curvature,
+          ConfidenceType::LeftRightDifference}) {
+        params.confidenceType = type;
+        for (const CostLayout layout : {CostLayout::PixelMajor,
+                                        CostLayout::DispMajor,
+                                        CostLayout::Ragged}) {
+            CostVolume volume(layout);
+            censusComputer->compute(left, right, volume);
+
+            Mat disp, rightDisp, confidence;
+            winnerTakesAll(volume, disp, rightDisp, confidence, params);
+            ASSERT_EQ(confidence.type(), CV_32FC1);
+
+            // the confidence from the stored costs of the pixel and the
+            // right disparity it matches
+            int mismatched = 0;
+            for (int i = 0; i < volume.rows(); ++i) {
+                for (int j = 0; j < volume.cols(); ++j) {
+                    const float value = confidence.ptr<float>(i)[j];
+                    const float d = disp.ptr<float>(i)[j];
+                    if (d < params.minDisp) {
+                        mismatched += value != 0.f;
+                        continue;
+                    }
+
+                    const int best = static_cast<int>(d) - params.minDisp;
+                    const int dispBegin = volume.dispBegin(i, j);
+                    const int dispEnd = volume.dispEnd(i, j);
+                    const float cost = volume.at<uint16_t>(i, j, best);
+                    float minorCost = numeric_limits<uint16_t>::max();
+                    for (int k = dispBegin; k < dispEnd; ++k) {
+                        if (abs(k - best) > 1) {
+                            minorCost = min(
+                                minorCost,
+                                static_cast<float>(
+                                    volume.at<uint16_t>(i, j, k)));
+                        }
+                    }
+
+                    float reference = 0.f;
+                    if (type == ConfidenceType::PeakRatio) {
+                        reference = 1.f - cost / minorCost;
+                    } else if (type == ConfidenceType::Curvature) {
+                        if (best != dispBegin && best != dispEnd - 1) {
+                            reference =
+                                volume.at<uint16_t>(i, j, best - 1) +
+                                volume.at<uint16_t>(i, j, best + 1) - 2 * cost;
+                        }
+                    } else {
+                        const float rd = rightDisp.ptr<float>(i)[j - best -
+                                                                 params.minDisp];
+                        reference = 1.f / (1.f + abs(d - rd));
+                    }
+                    mismatched += abs(value - reference) > 1e-6f;
+                }
+            }
+            EXPECT_EQ(mismatched, 0) << "confidence type "
+                                     << static_cast<int>(type) << ", layout "
+                                     << static_cast<int>(layout);
+        }
+    }
+}
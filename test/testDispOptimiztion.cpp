@@ -107,4 +107,187 @@ TEST_F(Cones, testMultipathAggregation) {
     }
 
     ASSERT_LE(abs(optimizedDisp.ptr<float>(301)[308] - 40), 1.f);
-}
\ No newline at end of file
+}
+/**
+ * @brief remove the small 8-connected areas of similar disparities by flood
+ * fill
+ *
+ */
+static void referenceRemoveSmallArea(const Mat &dispMap, Mat &out,
+                                     const float dispDomainThreshold,
+                                     const int smallAreaThreshold) {
+    out = dispMap.clone();
+    vector<bool> visited(dispMap.total(), false);
+    for (int i = 0; i < dispMap.rows; ++i) {
+        for (int j = 0; j < dispMap.cols; ++j) {
+            if (visited[i * dispMap.cols + j] ||
+                abs(dispMap.ptr<float>(i)[j]) < 0.001f) {
+                continue;
+            }
+
+            vector<Point> area(1, Point(j, i));
+            visited[i * dispMap.cols + j] = true;
+            for (size_t k = 0; k < area.size(); ++k) {
+                const Point cur = area[k];
+                const float curDisp = dispMap.ptr<float>(cur.y)[cur.x];
+                for (int y = cur.y - 1; y <= cur.y + 1; ++y) {
+                    for (int x = cur.x - 1; x <= cur.x + 1; ++x) {
+                        if (y < 0 || y >= dispMap.rows || x < 0 ||
+                            x >= dispMap.cols ||
+                            visited[y * dispMap.cols + x]) {
+                            continue;
+                        }
+                        const float disp = dispMap.ptr<float>(y)[x];
+                        if (abs(disp) >= 0.001f &&
+                            abs(disp - curDisp) < dispDomainThreshold) {
+                            area.push_back(Point(x, y));
+                            visited[y * dispMap.cols + x] = true;
+                        }
+                    }
+                }
+            }
+
+            if (static_cast<int>(area.size()) < smallAreaThreshold) {
+                for (const Point &loc : area) {
+                    out.ptr<float>(loc.y)[loc.x] = NONE_PIXEL;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(Cones, testRemoveSmallArea) {
+    transformToGray();
+
+    // the raw costs give a noisy disparity map of many small areas, which
+    // cross the bands of rows the labelling runs in
+    Mat cost;
+    {
+        auto params = CensusCost::Params();
+        params.windowWidth = 9;
+        params.windowHeight = 7;
+        params.minDisp = 0;
+        params.maxDisp = 64;
+
+        auto censusComputer = CensusCost::create(params);
+        censusComputer->compute(left, right, cost);
+    }
+
+    Mat disp;
+    {
+        auto params = DispComputeParams();
+        params.minDisp = 0;
+        params.maxDisp = 64;
+
+        winnerTakesAll(cost, disp, params);
+    }
+
+    for (const int smallAreaThreshold : {2, 20, 400}) {
+        auto params = DispOptParams();
+        params.enableRemoveSmallArea = true;
+        params.enableDispFill = false;
+        params.enableMedianFilter = false;
+        params.enableBilateralFilter = false;
+        params.dispDomainThreshold = 1;
+        params.smallAreaThreshold = smallAreaThreshold;
+
+        Mat optimizedDisp, reference;
+        dispOptimiz(disp, optimizedDisp, params);
+        referenceRemoveSmallArea(disp, reference, 1.f, smallAreaThreshold);
+
+        EXPECT_EQ(memcmp(optimizedDisp.data, reference.data,
+                         reference.total() * reference.elemSize()),
+                  0)
+            << "small area threshold " << smallAreaThreshold;
+    }
+}
+
+/**
+ * @brief median filter by sorting the window, the pixels out of the image are
+ * replicated from the border
+ *
+ */
+static void referenceMedianFilter(const Mat &dispMap, Mat &out, const int k) {
+    out = Mat(dispMap.size(), CV_32FC1);
+    for (int i = 0; i < dispMap.rows; ++i) {
+        for (int j = 0; j < dispMap.cols; ++j) {
+            vector<float> window;
+            for (int y = i - k / 2; y <= i + k / 2; ++y) {
+                for (int x = j - k / 2; x <= j + k / 2; ++x) {
+                    window.push_back(dispMap.ptr<float>(
+                        min(max(y, 0), dispMap.rows - 1))[min(
+                        max(x, 0), dispMap.cols - 1)]);
+                }
+            }
+            std::sort(window.begin(), window.end());
+            out.ptr<float>(i)[j] = window[window.size() / 2];
+        }
+    }
+}
+
+TEST(DispOptimiztion, testMedianFilter) {
+    // sub-pixel and integer disparities with the invalid pixel values, few
+    // values so that the windows hold ties, and sizes off the vector widths
+    RNG rng(11);
+    Mat subpixelDisp(37, 53, CV_32FC1), integerDisp(37, 53, CV_32FC1);
+    const float invalid[3] = {NONE_PIXEL, OCCLUDED_PIXEL, MISMATCHED_PIXEL};
+    for (int i = 0; i < subpixelDisp.rows; ++i) {
+        for (int j = 0; j < subpixelDisp.cols; ++j) {
+            const int value = rng.uniform(0, 40);
+            subpixelDisp.ptr<float>(i)[j] =
+                value < 3 ? invalid[value] : 20.f + value * 0.37f;
+            integerDisp.ptr<float>(i)[j] =
+                value < 3 ? invalid[value] : static_cast<float>(value);
+        }
+    }
+
+    auto params = DispOptParams();
+    params.enableRemoveSmallArea = false;
+    params.enableDispFill = false;
+    params.enableMedianFilter = true;
+
+    // the networks of the small kernels are exact at every simd level
+    for (const int k : {3, 5}) {
+        params.k = k;
+        Mat reference;
+        referenceMedianFilter(subpixelDisp, reference, k);
+
+        const auto detected = detectSimdLevel();
+        for (int level = 0; level <= static_cast<int>(detected); ++level) {
+            setMaxSimdLevel(static_cast<SimdLevel>(level));
+            Mat filteredDisp;
+            dispOptimiz(subpixelDisp, filteredDisp, params);
+
+            EXPECT_EQ(memcmp(filteredDisp.data, reference.data,
+                             reference.total() * reference.elemSize()),
+                      0)
+                << "kernel size " << k << ", simd level " << level;
+        }
+    }
+    setMaxSimdLevel(SimdLevel::AVX512);
+
+    // the sliding histogram of the large kernels is exact for the integer
+    // disparities and within a bin for the sub-pixel ones
+    for (const int k : {7, 9, 15}) {
+        params.k = k;
+        Mat filteredDisp, reference;
+        dispOptimiz(integerDisp, filteredDisp, params);
+        referenceMedianFilter(integerDisp, reference, k);
+        EXPECT_EQ(memcmp(filteredDisp.data, reference.data,
+                         reference.total() * reference.elemSize()),
+                  0)
+            << "kernel size " << k;
+
+        filteredDisp.release();
+        dispOptimiz(subpixelDisp, filteredDisp, params);
+        referenceMedianFilter(subpixelDisp, reference, k);
+        int mismatched = 0;
+        for (int i = 0; i < reference.rows; ++i) {
+            for (int j = 0; j < reference.cols; ++j) {
+                mismatched += abs(filteredDisp.ptr<float>(i)[j] -
+                                  reference.ptr<float>(i)[j]) > 1.f / 16;
+            }
+        }
+        EXPECT_EQ(mismatched, 0) << "kernel size " << k;
+    }
+}
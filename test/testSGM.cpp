@@ -68,4 +68,55 @@ TEST_F(Cones, testSGMColor) {
     sgm->match(left, right, disparityMap);
 
     ASSERT_LE(abs(disparityMap.ptr<float>(301)[308] - 40), 1.f);
-}
\ No newline at end of file
+}
+
+TEST_F(Cones, testSGMMemoryEfficient) {
+    transformToGray();
+
+    auto params = SGM::Params();
+    params.enableMemoryEfficient = true;
+    auto sgm = SGM::create(params);
+
+    Mat disparityMap;
+    sgm->match(left, right, disparityMap);
+
+    ASSERT_LE(abs(disparityMap.ptr<float>(301)[308] - 40), 1.f);
+}
+
+TEST_F(Cones, testSGMConfidence) {
+    transformToGray();
+
+    // the fused winner-takes-all gives the confidences of the stored sums
+    auto params = SGM::Params();
+    Mat fusedDisp, fusedConfidence;
+    std::static_pointer_cast<SGM>(SGM::create(params))
+        ->match(left, right, fusedDisp, fusedConfidence);
+
+    params.enableFusedWTA = false;
+    Mat disp, confidence;
+    std::static_pointer_cast<SGM>(SGM::create(params))
+        ->match(left, right, disp, confidence);
+
+    ASSERT_EQ(confidence.type(), CV_32FC1);
+    ASSERT_EQ(confidence.size(), left.size());
+    EXPECT_EQ(memcmp(fusedConfidence.data, confidence.data,
+                     confidence.total() * confidence.elemSize()),
+              0);
+    EXPECT_GT(confidence.ptr<float>(301)[308], 0.f);
+
+    params.enableMemoryEfficient = true;
+    params.confidenceType = ConfidenceType::LeftRightDifference;
+    std::static_pointer_cast<SGM>(SGM::create(params))
+        ->match(left, right, disp, confidence);
+
+    // the disparities passing the left-right check differ by one at most
+    int outside = 0;
+    for (int i = 0; i < confidence.rows; ++i) {
+        for (int j = 0; j < confidence.cols; ++j) {
+            const float value = confidence.ptr<float>(i)[j];
+            outside += value != 0.f && (value < 0.5f || value > 1.f);
+        }
+    }
+    EXPECT_EQ(outside, 0);
+    EXPECT_GE(confidence.ptr<float>(301)[308], 0.5f);
+}